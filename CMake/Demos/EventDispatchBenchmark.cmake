@@ -0,0 +1,15 @@
+# DENG: dynamic engine - powerful 3D game engine
+# licence: Apache, see LICENCE file
+# file: EventDispatchBenchmark.cmake - EventManager dispatch benchmark
+# author: Karl-Mihkel Ott
+
+set(EVENT_DISPATCH_BENCHMARK_TARGET EventDispatchBenchmark)
+set(EVENT_DISPATCH_BENCHMARK_SOURCES 
+	Demos/EventDispatchBenchmark.cpp)
+
+add_executable(${EVENT_DISPATCH_BENCHMARK_TARGET} 
+	${EVENT_DISPATCH_BENCHMARK_SOURCES})
+add_dependencies(${EVENT_DISPATCH_BENCHMARK_TARGET} ${DENG_MINIMAL_TARGET})
+target_link_libraries(${EVENT_DISPATCH_BENCHMARK_TARGET} 
+	PRIVATE ${DENG_MINIMAL_TARGET})
+set_target_properties(${EVENT_DISPATCH_BENCHMARK_TARGET} PROPERTIES FOLDER ${DEMO_APPS_DIR})
@@ -0,0 +1,15 @@
+# DENG: dynamic engine - powerful 3D game engine
+# licence: Apache, see LICENCE file
+# file: EventQueueAllocationTest.cmake - EventQueue steady state allocation test
+# author: Karl-Mihkel Ott
+
+set(EVENT_QUEUE_ALLOCATION_TEST_TARGET EventQueueAllocationTest)
+set(EVENT_QUEUE_ALLOCATION_TEST_SOURCES 
+	Demos/EventQueueAllocationTest.cpp)
+
+add_executable(${EVENT_QUEUE_ALLOCATION_TEST_TARGET} 
+	${EVENT_QUEUE_ALLOCATION_TEST_SOURCES})
+add_dependencies(${EVENT_QUEUE_ALLOCATION_TEST_TARGET} ${DENG_MINIMAL_TARGET})
+target_link_libraries(${EVENT_QUEUE_ALLOCATION_TEST_TARGET} 
+	PRIVATE ${DENG_MINIMAL_TARGET})
+set_target_properties(${EVENT_QUEUE_ALLOCATION_TEST_TARGET} PROPERTIES FOLDER ${DEMO_APPS_DIR})
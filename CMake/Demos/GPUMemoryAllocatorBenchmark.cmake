@@ -0,0 +1,15 @@
+# DENG: dynamic engine - powerful 3D game engine
+# licence: Apache, see LICENCE file
+# file: GPUMemoryAllocatorBenchmark.cmake - GPU memory allocator fragmentation benchmark
+# author: Karl-Mihkel Ott
+
+set(GPU_MEMORY_ALLOCATOR_BENCHMARK_TARGET GPUMemoryAllocatorBenchmark)
+set(GPU_MEMORY_ALLOCATOR_BENCHMARK_SOURCES 
+	Demos/GPUMemoryAllocatorBenchmark.cpp)
+
+add_executable(${GPU_MEMORY_ALLOCATOR_BENCHMARK_TARGET} 
+	${GPU_MEMORY_ALLOCATOR_BENCHMARK_SOURCES})
+add_dependencies(${GPU_MEMORY_ALLOCATOR_BENCHMARK_TARGET} ${DENG_MINIMAL_TARGET})
+target_link_libraries(${GPU_MEMORY_ALLOCATOR_BENCHMARK_TARGET} 
+	PRIVATE ${DENG_MINIMAL_TARGET})
+set_target_properties(${GPU_MEMORY_ALLOCATOR_BENCHMARK_TARGET} PROPERTIES FOLDER ${DEMO_APPS_DIR})
@@ -0,0 +1,15 @@
+# DENG: dynamic engine - powerful 3D game engine
+# licence: Apache, see LICENCE file
+# file: SceneTransformBenchmark.cmake - Scene transform update benchmark
+# author: Karl-Mihkel Ott
+
+set(SCENE_TRANSFORM_BENCHMARK_TARGET SceneTransformBenchmark)
+set(SCENE_TRANSFORM_BENCHMARK_SOURCES 
+	Demos/SceneTransformBenchmark.cpp)
+
+add_executable(${SCENE_TRANSFORM_BENCHMARK_TARGET} 
+	${SCENE_TRANSFORM_BENCHMARK_SOURCES})
+add_dependencies(${SCENE_TRANSFORM_BENCHMARK_TARGET} ${DENG_MINIMAL_TARGET})
+target_link_libraries(${SCENE_TRANSFORM_BENCHMARK_TARGET} 
+	PRIVATE ${DENG_MINIMAL_TARGET})
+set_target_properties(${SCENE_TRANSFORM_BENCHMARK_TARGET} PROPERTIES FOLDER ${DEMO_APPS_DIR})
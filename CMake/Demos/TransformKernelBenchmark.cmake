@@ -0,0 +1,15 @@
+# DENG: dynamic engine - powerful 3D game engine
+# licence: Apache, see LICENCE file
+# file: TransformKernelBenchmark.cmake - batched transform kernel benchmark
+# author: Karl-Mihkel Ott
+
+set(TRANSFORM_KERNEL_BENCHMARK_TARGET TransformKernelBenchmark)
+set(TRANSFORM_KERNEL_BENCHMARK_SOURCES 
+	Demos/TransformKernelBenchmark.cpp)
+
+add_executable(${TRANSFORM_KERNEL_BENCHMARK_TARGET} 
+	${TRANSFORM_KERNEL_BENCHMARK_SOURCES})
+add_dependencies(${TRANSFORM_KERNEL_BENCHMARK_TARGET} ${DENG_MINIMAL_TARGET})
+target_link_libraries(${TRANSFORM_KERNEL_BENCHMARK_TARGET} 
+	PRIVATE ${DENG_MINIMAL_TARGET})
+set_target_properties(${TRANSFORM_KERNEL_BENCHMARK_TARGET} PROPERTIES FOLDER ${DEMO_APPS_DIR})
@@ -25,8 +25,10 @@ set(DENG_MINIMAL_HEADERS
 	Include/deng/App.h
 	Include/deng/CameraTransformer.h
 	Include/deng/Components.h
+	Include/deng/DirtyBitset.h
 	Include/deng/ErrorDefinitions.h
 	Include/deng/Event.h
+	Include/deng/EventProfiler.h
 	Include/deng/Exceptions.h
 	Include/deng/FileTextureBuilder.h
 	Include/deng/FileSystemShader.h
@@ -52,11 +54,19 @@ set(DENG_MINIMAL_HEADERS
 	Include/deng/SceneRenderer.h
 	Include/deng/SDLWindowContext.h
 	Include/deng/SkyboxBuilders.h
+	Include/deng/SpirvCache.h
+	Include/deng/TextureCooker.h
+	Include/deng/ThreadPool.h
+	Include/deng/TransformKernels.h
+	Include/deng/VulkanBufferArena.h
+	Include/deng/VulkanDeletionQueue.h
+	Include/deng/VulkanFrameAllocator.h
 	Include/deng/VulkanFramebuffer.h
 	Include/deng/VulkanHelpers.h
 	Include/deng/VulkanInstanceCreator.h
 	Include/deng/VulkanPipelineCreator.h
 	Include/deng/VulkanRenderer.h
+	Include/deng/VulkanStagingRing.h
 	Include/deng/VulkanSwapchainCreator.h
 	Include/deng/WindowEvents.h)
 	
@@ -64,6 +74,7 @@ set(DENG_MINIMAL_SOURCES
 	Sources/App.cpp
 	Sources/CameraTransformer.cpp
 	Sources/ErrorDefinitions.cpp
+	Sources/EventProfiler.cpp
 	Sources/FileTextureBuilder.cpp
 	Sources/FileSystemShader.cpp
 	Sources/GPUMemoryAllocator.cpp
@@ -78,11 +89,19 @@ set(DENG_MINIMAL_SOURCES
 	Sources/SDLWindowContext.cpp
 	Sources/Singletons.cpp
 	Sources/SkyboxBuilders.cpp
+	Sources/SpirvCache.cpp
+	Sources/TextureCooker.cpp
+	Sources/ThreadPool.cpp
+	Sources/TransformKernels.cpp
+	Sources/VulkanBufferArena.cpp
+	Sources/VulkanDeletionQueue.cpp
+	Sources/VulkanFrameAllocator.cpp
 	Sources/VulkanFramebuffer.cpp
 	Sources/VulkanHelpers.cpp
 	Sources/VulkanInstanceCreator.cpp
 	Sources/VulkanPipelineCreator.cpp
 	Sources/VulkanRenderer.cpp
+	Sources/VulkanStagingRing.cpp
 	Sources/VulkanSwapchainCreator.cpp)
 	
 if (NOT DENG_STATIC)
@@ -0,0 +1,109 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: EventDispatchBenchmark.cpp - EventManager dispatch latency and multi-threaded throughput benchmark
+// author: Karl-Mihkel Ott
+
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include "deng/Api.h"
+#include "deng/Event.h"
+
+#define DISPATCH_COUNT 1000000
+
+// same inheritance depth as ComponentModifiedEvent
+class BenchmarkSceneEvent : public DENG::IEvent {
+	public:
+		EVENT_CLASS_TYPE_NO_ID_CHECK("BenchmarkSceneEvent", DENG::IEvent);
+};
+
+class BenchmarkRegistryStateEvent : public BenchmarkSceneEvent {
+	public:
+		EVENT_CLASS_TYPE_NO_ID_CHECK("BenchmarkRegistryStateEvent", BenchmarkSceneEvent);
+};
+
+class BenchmarkComponentEvent : public BenchmarkRegistryStateEvent {
+	private:
+		uint32_t m_uEntity;
+
+	public:
+		BenchmarkComponentEvent(uint32_t _uEntity) :
+			m_uEntity(_uEntity) {}
+
+		inline uint32_t GetEntity() { return m_uEntity; }
+
+		EVENT_CLASS_TYPE_NO_ID_CHECK("BenchmarkComponentEvent", BenchmarkRegistryStateEvent);
+};
+
+class BenchmarkComponentModifiedEvent : public BenchmarkComponentEvent {
+	public:
+		BenchmarkComponentModifiedEvent(uint32_t _uEntity) :
+			BenchmarkComponentEvent(_uEntity) {}
+
+		EVENT_CLASS_TYPE_NO_ID_CHECK("BenchmarkComponentModifiedEvent", BenchmarkComponentEvent);
+};
+
+// listeners only read the event, which keeps shared listener state out of multi-threaded measurements
+class BenchmarkListener {
+	public:
+		bool OnComponentModifiedEvent(BenchmarkComponentModifiedEvent& _event) {
+			return _event.GetEntity() == UINT32_MAX;
+		}
+
+		bool OnComponentEvent(BenchmarkComponentEvent& _event) {
+			return _event.GetEntity() == UINT32_MAX;
+		}
+};
+
+// returns nanoseconds per dispatch, measured over all threads
+static double BenchmarkDispatch(size_t _uListenerCount, size_t _uThreadCount) {
+	DENG::EventManager& eventManager = DENG::EventManager::GetInstance();
+	std::vector<BenchmarkListener> listeners(_uListenerCount);
+	for (BenchmarkListener& listener : listeners) {
+		eventManager.AddListener<BenchmarkListener, BenchmarkComponentModifiedEvent>(&BenchmarkListener::OnComponentModifiedEvent, &listener);
+		eventManager.AddListener<BenchmarkListener, BenchmarkComponentEvent>(&BenchmarkListener::OnComponentEvent, &listener);
+	}
+
+	const size_t uDispatchesPerThread = DISPATCH_COUNT / _uThreadCount;
+	std::vector<std::thread> threads;
+	threads.reserve(_uThreadCount);
+
+	auto tpBegin = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < _uThreadCount; i++) {
+		threads.emplace_back([&eventManager, uDispatchesPerThread]() {
+			for (size_t j = 0; j < uDispatchesPerThread; j++)
+				eventManager.Dispatch<BenchmarkComponentModifiedEvent>(static_cast<uint32_t>(j));
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+	auto tpEnd = std::chrono::high_resolution_clock::now();
+
+	for (BenchmarkListener& listener : listeners) {
+		eventManager.RemoveListener<BenchmarkListener, BenchmarkComponentModifiedEvent>(&listener);
+		eventManager.RemoveListener<BenchmarkListener, BenchmarkComponentEvent>(&listener);
+	}
+
+	std::chrono::duration<double, std::nano> duration = tpEnd - tpBegin;
+	return duration.count() / static_cast<double>(uDispatchesPerThread * _uThreadCount);
+}
+
+int main(void) {
+	const size_t arrListenerCounts[] = { 1, 4, 16 };
+	const size_t arrThreadCounts[] = { 1, 2, 4 };
+
+	std::cout << std::setw(12) << "listeners" << std::setw(10) << "threads" << std::setw(20) << "ns per dispatch" << '\n';
+	for (size_t uListenerCount : arrListenerCounts) {
+		for (size_t uThreadCount : arrThreadCounts) {
+			std::cout << std::setw(12) << uListenerCount << std::setw(10) << uThreadCount <<
+				std::setw(20) << std::fixed << std::setprecision(1) << BenchmarkDispatch(uListenerCount, uThreadCount) << '\n';
+		}
+	}
+
+	return 0;
+}
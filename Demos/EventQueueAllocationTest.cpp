@@ -0,0 +1,116 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: EventQueueAllocationTest.cpp - checks that queuing events into a warmed up EventQueue does not allocate
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "deng/Api.h"
+#include "deng/Event.h"
+
+#define DISTINCT_KEY_COUNT 1000
+#define REPEAT_COUNT 4
+#define PLAIN_EVENT_COUNT 1000
+
+static size_t g_uAllocationCount = 0;
+
+void* operator new(size_t _uSize) {
+	g_uAllocationCount++;
+	if (void* pMemory = std::malloc(_uSize ? _uSize : 1))
+		return pMemory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* _pMemory) noexcept {
+	std::free(_pMemory);
+}
+
+void operator delete(void* _pMemory, size_t) noexcept {
+	std::free(_pMemory);
+}
+
+class TestCoalescedEvent : public DENG::IEvent {
+	private:
+		uint32_t m_uEntity;
+		uint32_t m_uValue;
+
+	public:
+		TestCoalescedEvent(uint32_t _uEntity, uint32_t _uValue) :
+			m_uEntity(_uEntity),
+			m_uValue(_uValue) {}
+
+		inline uint64_t GetCoalescingKey() const { return m_uEntity; }
+		inline uint32_t GetEntity() const { return m_uEntity; }
+		inline uint32_t GetValue() const { return m_uValue; }
+
+		EVENT_CLASS_TYPE_NO_ID_CHECK("TestCoalescedEvent", DENG::IEvent);
+};
+
+class TestPlainEvent : public DENG::IEvent {
+	public:
+		EVENT_CLASS_TYPE_NO_ID_CHECK("TestPlainEvent", DENG::IEvent);
+};
+
+static std::vector<uint32_t> g_dispatchedValues;
+static size_t g_uPlainEventCount = 0;
+
+static void DispatchCoalescedEvent(DENG::EventManager&, DENG::IEvent& _event) {
+	TestCoalescedEvent& event = static_cast<TestCoalescedEvent&>(_event);
+	g_dispatchedValues[event.GetEntity()] = event.GetValue();
+}
+
+static void DispatchPlainEvent(DENG::EventManager&, DENG::IEvent&) {
+	g_uPlainEventCount++;
+}
+
+// pushes one frame worth of events, returns false if coalescing results are wrong
+static bool PushFrame(DENG::EventQueue& _eventQueue) {
+	for (uint32_t uRepeat = 0; uRepeat < REPEAT_COUNT; uRepeat++) {
+		for (uint32_t uEntity = 0; uEntity < DISTINCT_KEY_COUNT; uEntity++)
+			_eventQueue.Push<TestCoalescedEvent>(&DispatchCoalescedEvent, uEntity, uRepeat);
+		for (uint32_t i = 0; i < PLAIN_EVENT_COUNT / REPEAT_COUNT; i++)
+			_eventQueue.Push<TestPlainEvent>(&DispatchPlainEvent);
+	}
+
+	if (_eventQueue.GetEventCount() != DISTINCT_KEY_COUNT + PLAIN_EVENT_COUNT)
+		return false;
+
+	std::fill(g_dispatchedValues.begin(), g_dispatchedValues.end(), UINT32_MAX);
+	g_uPlainEventCount = 0;
+	_eventQueue.Dispatch(DENG::EventManager::GetInstance());
+	_eventQueue.Clear();
+
+	// every key keeps the last pushed event
+	for (uint32_t uValue : g_dispatchedValues) {
+		if (uValue != REPEAT_COUNT - 1)
+			return false;
+	}
+
+	return g_uPlainEventCount == PLAIN_EVENT_COUNT;
+}
+
+int main(void) {
+	g_dispatchedValues.resize(DISTINCT_KEY_COUNT);
+	DENG::EventQueue eventQueue;
+
+	// first frame grows the event chunks, event table and coalescing table
+	if (!PushFrame(eventQueue)) {
+		std::cerr << "Incorrectly coalesced events in the first frame" << std::endl;
+		return 1;
+	}
+
+	const size_t uAllocationCount = g_uAllocationCount;
+	if (!PushFrame(eventQueue)) {
+		std::cerr << "Incorrectly coalesced events in the second frame" << std::endl;
+		return 1;
+	}
+
+	const size_t uFrameAllocationCount = g_uAllocationCount - uAllocationCount;
+	std::cout << "Allocations while queuing " << DISTINCT_KEY_COUNT * REPEAT_COUNT + PLAIN_EVENT_COUNT << " events: " << uFrameAllocationCount << std::endl;
+	return uFrameAllocationCount ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: GPUMemoryAllocatorBenchmark.cpp - GPU memory allocator fragmentation stress benchmark
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "deng/Api.h"
+#include "deng/GPUMemoryAllocator.h"
+
+#define CHURN_OPERATIONS 1000000
+#define MAX_ALLOCATION_SIZE 65536
+
+static const size_t s_arrAlignments[] = { 4, 16, 64, 256 };
+
+struct BenchmarkResult {
+	double fNsPerOperation = 0.0;
+	size_t uLiveBytes = 0;
+	size_t uUsedSpace = 0;
+	size_t uFragmentCount = 0;
+	bool bIsValid = true;
+};
+
+// keeps _uLiveCount allocations alive while randomly freeing and requesting regions of random size and alignment
+static BenchmarkResult StressAllocator(size_t _uLiveCount) {
+	std::mt19937 rng(1337);
+	std::uniform_int_distribution<size_t> sizeDistribution(1, MAX_ALLOCATION_SIZE);
+	std::uniform_int_distribution<size_t> alignmentDistribution(0, sizeof(s_arrAlignments) / sizeof(s_arrAlignments[0]) - 1);
+	std::uniform_int_distribution<size_t> indexDistribution(0, _uLiveCount - 1);
+
+	DENG::GPUMemoryAllocator allocator;
+	std::vector<DENG::MemoryRegion> liveRegions;
+	liveRegions.reserve(_uLiveCount);
+
+	for (size_t i = 0; i < _uLiveCount; i++)
+		liveRegions.push_back(allocator.RequestMemory(sizeDistribution(rng), s_arrAlignments[alignmentDistribution(rng)]));
+
+	auto tpBegin = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < CHURN_OPERATIONS; i++) {
+		DENG::MemoryRegion& region = liveRegions[indexDistribution(rng)];
+		allocator.FreeMemory(region.uOffset);
+		region = allocator.RequestMemory(sizeDistribution(rng), s_arrAlignments[alignmentDistribution(rng)]);
+	}
+	auto tpEnd = std::chrono::high_resolution_clock::now();
+
+	BenchmarkResult result;
+	std::chrono::duration<double, std::nano> duration = tpEnd - tpBegin;
+	result.fNsPerOperation = duration.count() / static_cast<double>(2 * CHURN_OPERATIONS);
+
+	// live regions must not overlap
+	std::map<size_t, size_t> sortedRegions;
+	for (const DENG::MemoryRegion& region : liveRegions) {
+		result.uLiveBytes += region.uSize;
+		result.uUsedSpace = std::max(result.uUsedSpace, region.uOffset + region.uSize);
+		if (!sortedRegions.emplace(region.uOffset, region.uSize).second)
+			result.bIsValid = false;
+	}
+
+	size_t uPreviousEnd = 0;
+	for (auto it = sortedRegions.begin(); it != sortedRegions.end(); it++) {
+		if (it->first < uPreviousEnd)
+			result.bIsValid = false;
+		uPreviousEnd = it->first + it->second;
+	}
+
+	// running statistics counters must agree with live regions
+	const DENG::MemoryStatistics statistics = allocator.GetStatistics();
+	if (statistics.uUsedBytes != result.uLiveBytes || statistics.uAllocationCount != liveRegions.size() || statistics.uCapacity != result.uUsedSpace)
+		result.bIsValid = false;
+	result.uFragmentCount = statistics.uFragmentCount;
+
+	return result;
+}
+
+int main(void) {
+	const size_t arrLiveCounts[] = { 100, 1000, 10000, 100000 };
+
+	std::cout << std::setw(12) << "live regions" << std::setw(16) << "ns per op" << std::setw(16) << "utilization" << std::setw(12) << "fragments" << std::setw(10) << "valid" << '\n';
+	for (size_t uLiveCount : arrLiveCounts) {
+		const BenchmarkResult result = StressAllocator(uLiveCount);
+		std::cout << std::setw(12) << uLiveCount <<
+			std::setw(16) << std::fixed << std::setprecision(1) << result.fNsPerOperation <<
+			std::setw(15) << std::setprecision(1) << 100.0 * static_cast<double>(result.uLiveBytes) / static_cast<double>(result.uUsedSpace) << '%' <<
+			std::setw(12) << result.uFragmentCount <<
+			std::setw(10) << (result.bIsValid ? "yes" : "no") << '\n';
+	}
+
+	return 0;
+}
@@ -32,10 +32,14 @@ class WindowResizeLayer : public DENG::ILayer {
 };
 
 class ImGuiApp : public DENG::App {
+	private:
+		DENG::IRenderer* m_pMainRenderer = nullptr;
+
 	public:
 		ImGuiApp() {
 			DENG::IWindowContext* pWindowContext = SetWindowContext(new DENG::SDLWindowContext);
 			DENG::IRenderer* pRenderer = SetRenderer(new DENG::VulkanRenderer);
+			m_pMainRenderer = pRenderer;
 			pWindowContext->SetHints(DENG::WindowHint_Vulkan | DENG::WindowHint_Shown | DENG::WindowHint_Resizeable);
 			DENG::IFramebuffer* pMainFramebuffer = nullptr;
 
@@ -61,6 +65,8 @@ class ImGuiApp : public DENG::App {
 
 		void ImGuiCallback() {
 			ImGui::ShowDemoWindow();
+			DENG::ImGuiLayer::DrawMemoryStatistics(m_pMainRenderer->GetMemoryStatistics());
+			DENG::ImGuiLayer::DrawEventProfile();
 		}
 };
 
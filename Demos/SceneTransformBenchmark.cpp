@@ -0,0 +1,98 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: SceneTransformBenchmark.cpp - per-update cost of scene transform modifications
+// author: Karl-Mihkel Ott
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "deng/Scene.h"
+
+// Renderer that accepts every request and does nothing, so only the scene side bookkeeping is measured
+class NullRenderer : public DENG::IRenderer {
+	private:
+		size_t m_uOffset = 0;
+		std::vector<char> m_scratch;
+
+	public:
+		virtual void DeleteTextureHandles() override {}
+		virtual void UpdateViewport(uint32_t, uint32_t) override {}
+		virtual void DestroyPipeline(cvar::hash_t) override {}
+		virtual void PrecompilePipelines(DENG::IFramebuffer*) override {}
+		virtual DENG::IFramebuffer* CreateFramebuffer(uint32_t, uint32_t) override { return nullptr; }
+		virtual DENG::IFramebuffer* CreateContext(DENG::IWindowContext*) override { return nullptr; }
+		
+		virtual size_t AllocateMemory(size_t _uSize, DENG::BufferDataType) override {
+			size_t uOffset = m_uOffset;
+			m_uOffset += _uSize;
+			return uOffset;
+		}
+
+		virtual void DeallocateMemory(size_t) override {}
+		virtual size_t AllocateFrameMemory(size_t _uSize, DENG::BufferDataType _eType) override {
+			return AllocateMemory(_uSize, _eType);
+		}
+
+		virtual void* MapBufferRegion(size_t _uSize, size_t) override {
+			if (m_scratch.size() < _uSize)
+				m_scratch.resize(_uSize);
+			return m_scratch.data();
+		}
+
+		virtual void UpdateBuffer(const void*, size_t, size_t) override {}
+		virtual void UpdateBufferRegions(const DENG::BufferRegion*, size_t) override {}
+		virtual bool SetupFrame() override { return true; }
+		virtual void DrawInstance(cvar::hash_t, cvar::hash_t, DENG::IFramebuffer*, uint32_t, uint32_t, cvar::hash_t) override {}
+};
+
+// every 16 consecutive entities share one mesh, which yields N / 16 draw calls
+#define ENTITIES_PER_DRAW_CALL 16
+#define BENCHMARK_FRAMES 10
+
+static double BenchmarkTransformUpdates(size_t _uInstanceCount) {
+	NullRenderer renderer;
+	DENG::Scene scene(&renderer, nullptr);
+
+	std::vector<DENG::Entity> entities;
+	entities.reserve(_uInstanceCount);
+	for (size_t i = 0; i < _uInstanceCount; i++) {
+		DENG::Entity idEntity = scene.CreateEntity();
+		scene.EmplaceComponent<DENG::MeshComponent>(idEntity, static_cast<cvar::hash_t>(i / ENTITIES_PER_DRAW_CALL + 1));
+		scene.EmplaceComponent<DENG::ShaderComponent>(idEntity, static_cast<cvar::hash_t>(1));
+		scene.EmplaceComponent<DENG::MaterialComponent>(idEntity);
+		scene.EmplaceComponent<DENG::TransformComponent>(idEntity);
+		entities.push_back(idEntity);
+	}
+
+	scene.AttachComponents();
+
+	DENG::EventManager& eventManager = DENG::EventManager::GetInstance();
+	auto tpBegin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+		for (DENG::Entity idEntity : entities) {
+			scene.GetComponent<DENG::TransformComponent>(idEntity).vTranslation.first += 0.1f;
+			eventManager.Dispatch<DENG::ComponentModifiedEvent>(idEntity, DENG::ComponentType_Transform);
+		}
+		scene.RenderScene();
+	}
+	auto tpEnd = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double, std::nano> duration = tpEnd - tpBegin;
+	return duration.count() / static_cast<double>(_uInstanceCount * BENCHMARK_FRAMES);
+}
+
+int main(void) {
+	const size_t arrInstanceCounts[] = { 1000, 10000, 100000 };
+
+	std::cout << std::setw(12) << "instances" << std::setw(16) << "draw calls" << std::setw(20) << "ns per update" << '\n';
+	for (size_t uInstanceCount : arrInstanceCounts) {
+		const double fNsPerUpdate = BenchmarkTransformUpdates(uInstanceCount);
+		std::cout << std::setw(12) << uInstanceCount << 
+			std::setw(16) << (uInstanceCount + ENTITIES_PER_DRAW_CALL - 1) / ENTITIES_PER_DRAW_CALL <<
+			std::setw(20) << std::fixed << std::setprecision(1) << fNsPerUpdate << '\n';
+	}
+
+	return 0;
+}
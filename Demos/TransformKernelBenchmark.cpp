@@ -0,0 +1,132 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: TransformKernelBenchmark.cpp - throughput and accuracy of batched rotation / normal matrix kernels
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "trs/Matrix.h"
+#include "trs/Quaternion.h"
+#include "deng/TransformKernels.h"
+
+#define BENCHMARK_TRANSFORM_COUNT 100000
+#define BENCHMARK_ITERATIONS 20
+// kernels use polynomial sine / cosine approximations, anything above this is a bug rather than rounding
+#define BENCHMARK_MAX_ERROR 1e-5f
+
+struct SoAStorage {
+	std::vector<float> elements;
+	DENG::Matrix3SoA matrices;
+
+	SoAStorage(size_t _uCount) :
+		elements(_uCount * 9)
+	{
+		for (size_t i = 0; i < 9; i++)
+			matrices.arrElements[i] = elements.data() + i * _uCount;
+	}
+};
+
+static const char* GetInstructionSetName(DENG::SimdInstructionSet _eInstructionSet) {
+	switch (_eInstructionSet) {
+		case DENG::SimdInstructionSet::AVX2:
+			return "AVX2";
+
+		case DENG::SimdInstructionSet::SSE41:
+			return "SSE4.1";
+
+		default:
+			return "scalar";
+	}
+}
+
+// per transform work the kernels replace: quaternion product, matrix expansion and a general 4x4 inverse
+static TRS::Matrix4<float> CalculateReferenceNormal(float _fX, float _fY, float _fZ) {
+	const TRS::Quaternion qX = { std::sin(_fX / 2.f), 0.f, 0.f, std::cos(_fX / 2.f) };
+	const TRS::Quaternion qY = { 0.f, std::sin(_fY / 2.f), 0.f, std::cos(_fY / 2.f) };
+	const TRS::Quaternion qZ = { 0.f, 0.f, std::sin(_fZ / 2.f), std::cos(_fZ / 2.f) };
+	return (qX * qY * qZ).ExpandToMatrix4().Inverse();
+}
+
+// largest absolute difference between kernel output and the reference normal matrices
+static float CalculateMaxError(const std::vector<TRS::Matrix4<float>>& _references, const DENG::Matrix3SoA& _normals) {
+	float fMaxError = 0.f;
+	for (size_t i = 0; i < _references.size(); i++) {
+		for (size_t uColumn = 0; uColumn < 3; uColumn++) {
+			TRS::Vector4<float> vBasis = { 0.f, 0.f, 0.f, 0.f };
+			vBasis[uColumn] = 1.f;
+			const TRS::Vector4<float> vColumn = _references[i] * vBasis;
+
+			for (size_t uRow = 0; uRow < 3; uRow++)
+				fMaxError = std::max(fMaxError, std::abs(vColumn[uRow] - _normals.arrElements[uRow * 3 + uColumn][i]));
+		}
+	}
+
+	return fMaxError;
+}
+
+int main(void) {
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> dist(-2.f * 3.14159265f, 2.f * 3.14159265f);
+
+	std::vector<float> rotationsX(BENCHMARK_TRANSFORM_COUNT), rotationsY(BENCHMARK_TRANSFORM_COUNT), rotationsZ(BENCHMARK_TRANSFORM_COUNT);
+	for (size_t i = 0; i < BENCHMARK_TRANSFORM_COUNT; i++) {
+		rotationsX[i] = dist(rng);
+		rotationsY[i] = dist(rng);
+		rotationsZ[i] = dist(rng);
+	}
+
+	std::vector<TRS::Matrix4<float>> references(BENCHMARK_TRANSFORM_COUNT);
+	auto tpBegin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		for (size_t j = 0; j < BENCHMARK_TRANSFORM_COUNT; j++)
+			references[j] = CalculateReferenceNormal(rotationsX[j], rotationsY[j], rotationsZ[j]);
+	}
+	auto tpEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = tpEnd - tpBegin;
+
+	std::cout << std::setw(12) << "path" << std::setw(20) << "M transforms/s" << std::setw(16) << "max error" << '\n';
+	std::cout << std::setw(12) << "quaternion" <<
+		std::setw(20) << std::fixed << std::setprecision(2) << BENCHMARK_TRANSFORM_COUNT * BENCHMARK_ITERATIONS / duration.count() / 1e6 <<
+		std::setw(16) << "-" << '\n';
+
+	const DENG::SimdInstructionSet arrInstructionSets[] = { 
+		DENG::SimdInstructionSet::Scalar, 
+		DENG::SimdInstructionSet::SSE41, 
+		DENG::SimdInstructionSet::AVX2 
+	};
+
+	SoAStorage rotations(BENCHMARK_TRANSFORM_COUNT), normals(BENCHMARK_TRANSFORM_COUNT);
+	bool bIsAccurate = true;
+	for (DENG::SimdInstructionSet eInstructionSet : arrInstructionSets) {
+		if (static_cast<int>(eInstructionSet) > static_cast<int>(DENG::TransformKernels::GetInstructionSet())) {
+			std::cout << std::setw(12) << GetInstructionSetName(eInstructionSet) << std::setw(20) << "unsupported" << '\n';
+			continue;
+		}
+
+		tpBegin = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+			DENG::TransformKernels::CalculateRotations(rotationsX.data(), rotationsY.data(), rotationsZ.data(), BENCHMARK_TRANSFORM_COUNT,
+													   rotations.matrices, normals.matrices, eInstructionSet);
+		}
+		tpEnd = std::chrono::high_resolution_clock::now();
+		duration = tpEnd - tpBegin;
+
+		const float fMaxError = CalculateMaxError(references, normals.matrices);
+		std::cout << std::setw(12) << GetInstructionSetName(eInstructionSet) <<
+			std::setw(20) << std::fixed << std::setprecision(2) << BENCHMARK_TRANSFORM_COUNT * BENCHMARK_ITERATIONS / duration.count() / 1e6 <<
+			std::setw(16) << std::scientific << std::setprecision(2) << fMaxError << '\n';
+
+		if (!(fMaxError <= BENCHMARK_MAX_ERROR)) {
+			std::cerr << GetInstructionSetName(eInstructionSet) << " max error exceeds " << BENCHMARK_MAX_ERROR << '\n';
+			bIsAccurate = false;
+		}
+	}
+
+	return bIsAccurate ? 0 : 1;
+}
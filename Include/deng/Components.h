@@ -7,6 +7,7 @@
 #define COMPONENTS_H
 
 #include <array>
+#include <cmath>
 #include <string>
 #include <variant>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "deng/MathConstants.h"
 #include "deng/Event.h"
 #include "deng/ErrorDefinitions.h"
+#include "deng/TransformKernels.h"
 
 namespace DENG {
 	class Scene;
@@ -63,6 +65,8 @@ namespace DENG {
 		cvar::hash_t hshShader = 0;
 		cvar::hash_t hshMaterial = 0;
 		uint32_t uInstanceCount = 1;
+		uint32_t uFirstInstance = 0;	// first draw descriptor of the batch
+		uint32_t uCapacity = 1;			// draw descriptors reserved for the batch
 	};
 
 	/*	Note: for das2 structures the ECS representation would look something like this
@@ -166,11 +170,16 @@ namespace DENG {
 		TRS::Vector4<float> vScale = { 1.f, 1.f, 1.f, 0.f };
 		TRS::Vector4<float> vRotation = { 0.f, 0.f, 0.f, 0.f }; // in radians
 
+		// closed form of (qX * qY * qZ).ExpandToMatrix4().Inverse(), inverse of a rotation matrix is its transpose
 		void CalculateNormalMatrix() {
-			TRS::Quaternion qX = { std::sinf(vRotation.first / 2.f), 0.f, 0.f, std::cosf(vRotation.first / 2.f) };
-			TRS::Quaternion qY = { 0.f, std::sinf(vRotation.second / 2.f), 0.f, std::cosf(vRotation.second / 2.f) };
-			TRS::Quaternion qZ = { 0.f, 0.f, std::sinf(vRotation.third / 2.f), std::cosf(vRotation.third / 2.f) };
-			mNormal = (qX * qY * qZ).ExpandToMatrix4().Inverse();
+			const std::array<float, 9> arrRotation = TransformKernels::CalculateRotation(vRotation.first, vRotation.second, vRotation.third);
+
+			mNormal = {
+				{ arrRotation[0], arrRotation[3], arrRotation[6], 0.f },
+				{ arrRotation[1], arrRotation[4], arrRotation[7], 0.f },
+				{ arrRotation[2], arrRotation[5], arrRotation[8], 0.f },
+				{ 0.f, 0.f, 0.f, 1.f }
+			};
 		}
 	};
 
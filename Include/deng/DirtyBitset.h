@@ -0,0 +1,139 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: DirtyBitset.h - dense dirty element tracking and upload region builder
+// author: Karl-Mihkel Ott
+
+#ifndef DIRTY_BITSET_H
+#define DIRTY_BITSET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+#ifndef DEFAULT_UPLOAD_MERGE_GAP
+#define DEFAULT_UPLOAD_MERGE_GAP 3
+#endif
+
+namespace DENG {
+
+	// Tracks modified elements of a contiguous buffer with one bit per element.
+	// Dirty bits are turned into coalesced [first, last] element regions with a word-at-a-time scan,
+	// two regions are merged when the distance between them is less than the merge gap (adjacent regions are always merged).
+	// Storage for both bits and regions is reused between frames, so steady state tracking does not allocate.
+	class DirtyBitset {
+		private:
+			std::vector<uint64_t> m_words;
+			std::vector<std::pair<std::size_t, std::size_t>> m_regions;
+			std::size_t m_uFirstDirtyWord = SIZE_MAX;
+			std::size_t m_uLastDirtyWord = 0;
+			std::size_t m_uMergeGap = DEFAULT_UPLOAD_MERGE_GAP;
+
+		private:
+			static inline uint32_t _CountTrailingZeros(uint64_t _uBits) {
+#ifdef _MSC_VER
+				unsigned long uIndex = 0;
+				_BitScanForward64(&uIndex, _uBits);
+				return static_cast<uint32_t>(uIndex);
+#else
+				return static_cast<uint32_t>(__builtin_ctzll(_uBits));
+#endif
+			}
+
+			inline void _AppendRegion(std::size_t _uFirst, std::size_t _uLast) {
+				if (m_regions.size() && (_uFirst - m_regions.back().second < m_uMergeGap || _uFirst == m_regions.back().second + 1))
+					m_regions.back().second = _uLast;
+				else
+					m_regions.emplace_back(_uFirst, _uLast);
+			}
+
+		public:
+			DirtyBitset() = default;
+			DirtyBitset(std::size_t _uMergeGap) :
+				m_uMergeGap(_uMergeGap) {}
+
+			// preallocates bits for _uCount elements
+			inline void Reserve(std::size_t _uCount) {
+				const std::size_t uWordCount = (_uCount + 63) >> 6;
+				if (uWordCount > m_words.size())
+					m_words.resize(uWordCount, 0);
+			}
+
+			inline void Set(std::size_t _uIndex) {
+				const std::size_t uWord = _uIndex >> 6;
+				if (uWord >= m_words.size())
+					m_words.resize(uWord + 1, 0);
+
+				m_words[uWord] |= (1ull << (_uIndex & 63));
+				if (uWord < m_uFirstDirtyWord)
+					m_uFirstDirtyWord = uWord;
+				if (uWord > m_uLastDirtyWord)
+					m_uLastDirtyWord = uWord;
+			}
+
+			inline void SetRange(std::size_t _uFirst, std::size_t _uCount) {
+				for (std::size_t i = _uFirst; i < _uFirst + _uCount; i++)
+					Set(i);
+			}
+
+			inline bool Any() const {
+				return m_uFirstDirtyWord != SIZE_MAX;
+			}
+
+			inline void Clear() {
+				if (!Any())
+					return;
+
+				for (std::size_t i = m_uFirstDirtyWord; i <= m_uLastDirtyWord; i++)
+					m_words[i] = 0;
+				m_uFirstDirtyWord = SIZE_MAX;
+				m_uLastDirtyWord = 0;
+			}
+
+			inline void SetMergeGap(std::size_t _uMergeGap) {
+				m_uMergeGap = _uMergeGap;
+			}
+
+			inline std::size_t GetMergeGap() const {
+				return m_uMergeGap;
+			}
+
+			// regions built by the last MakeRegions() call
+			inline const std::vector<std::pair<std::size_t, std::size_t>>& GetRegions() const {
+				return m_regions;
+			}
+
+			// returns inclusive [first, last] element regions, valid until the next call
+			const std::vector<std::pair<std::size_t, std::size_t>>& MakeRegions() {
+				m_regions.clear();
+				if (!Any())
+					return m_regions;
+
+				for (std::size_t uWord = m_uFirstDirtyWord; uWord <= m_uLastDirtyWord; uWord++) {
+					uint64_t uBits = m_words[uWord];
+
+					while (uBits) {
+						const uint32_t uFirstBit = _CountTrailingZeros(uBits);
+						const uint64_t uInverted = ~(uBits >> uFirstBit);
+						const uint32_t uRunLength = uInverted ? _CountTrailingZeros(uInverted) : 64 - uFirstBit;
+
+						const std::size_t uFirst = (uWord << 6) + uFirstBit;
+						_AppendRegion(uFirst, uFirst + uRunLength - 1);
+
+						if (uFirstBit + uRunLength >= 64)
+							uBits = 0;
+						else
+							uBits &= ~((1ull << (uFirstBit + uRunLength)) - 1);
+					}
+				}
+
+				return m_regions;
+			}
+	};
+}
+
+#endif
@@ -6,20 +6,54 @@
 #ifndef EVENT_H
 #define EVENT_H
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <list>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "deng/Api.h"
+#include "deng/ErrorDefinitions.h"
+#include "deng/EventProfiler.h"
 #include <cvar/SID.h>
 
+// large enough for member function pointers of any inheritance model
+#ifndef EVENT_LISTENER_CALLBACK_SIZE
+#define EVENT_LISTENER_CALLBACK_SIZE (3 * sizeof(void*))
+#endif
+
+// consumer queues for posted events, consumer 0 is drained by the main thread
+#ifndef MAX_EVENT_CONSUMERS
+#define MAX_EVENT_CONSUMERS 8
+#endif
+
+#define EVENT_CONSUMER_MAIN_THREAD 0
+
+// queued events are placed into memory chunks of this size, which are reused from frame to frame
+#ifndef EVENT_QUEUE_CHUNK_SIZE
+#define EVENT_QUEUE_CHUNK_SIZE (1 << 16)
+#endif
+
+// initial slot count of the coalescing table, has to be a power of two, table doubles whenever it gets half full
+#ifndef EVENT_QUEUE_COALESCING_SLOTS
+#define EVENT_QUEUE_COALESCING_SLOTS 256
+#endif
+
 namespace DENG {
 
 
 #define EVENT_CLASS_TYPE_NO_ID_CHECK(str_type, parent)	static constexpr cvar::hash_t GetStaticType() { return SID(str_type); }\
+														static constexpr const char* GetStaticName() { return str_type; }\
 														virtual cvar::hash_t GetEventType() const override { return GetStaticType(); }\
 														const parent* GetParent() const { return static_cast<const parent*>(this); }\
 														virtual const char* GetName() const override { return str_type; }
@@ -29,6 +63,7 @@ namespace DENG {
 															static_assert(table{}.Has<Wrapper<SID(str_type)>>(), "Unregistred event id");\
 															return SID(str_type);\
 														}\
+														static constexpr const char* GetStaticName() { return str_type; }\
 														virtual cvar::hash_t GetEventType() const override { return GetStaticType(); }\
 														const parent* GetParent() const { return static_cast<const parent*>(this); }\
 														virtual const char* GetName() const override { return str_type; }
@@ -46,6 +81,10 @@ namespace DENG {
 				return 0;
 			}
 
+			static constexpr const char* GetStaticName() {
+				return "IEvent";
+			}
+
 			virtual cvar::hash_t GetEventType() const {
 				return IEvent::GetStaticType();
 			}
@@ -61,60 +100,415 @@ namespace DENG {
 			}
 	};
 
+	// Type erased member function callback, which is invoked without any heap allocated state
 	class EventListener {
 		private:
-			using PFN_CallbackType = std::function<bool(IEvent&)>;
+			using PFN_InvokeCallback = bool(*)(const EventListener&, IEvent&);
 
-			PFN_CallbackType m_CallbackLambda = nullptr;
 			void* m_pInstance = nullptr;
+			const char* m_szEventName = "";
+			PFN_InvokeCallback m_pfnInvokeCallback = nullptr;
+			unsigned char m_callback[EVENT_LISTENER_CALLBACK_SIZE] = {};
+
+		private:
+			template<typename T, typename E>
+			static bool _InvokeCallback(const EventListener& _listener, IEvent& _event) {
+				bool(T::*pfnCallback)(E&) = nullptr;
+				std::memcpy(&pfnCallback, _listener.m_callback, sizeof(pfnCallback));
+				return (static_cast<T*>(_listener.m_pInstance)->*pfnCallback)(static_cast<E&>(_event));
+			}
 
 		public:
-			EventListener(void* _pInstance, const PFN_CallbackType& _CallbackLambda) :
-				m_CallbackLambda(_CallbackLambda),
-				m_pInstance(_pInstance) {}
+			template<typename T, typename E>
+			EventListener(T* _pInstance, bool(T::*_pfnCallback)(E&)) :
+				m_pInstance(_pInstance),
+				m_szEventName(E::GetStaticName()),
+				m_pfnInvokeCallback(&EventListener::_InvokeCallback<T, E>)
+			{
+				static_assert(sizeof(_pfnCallback) <= EVENT_LISTENER_CALLBACK_SIZE, "Member function pointer does not fit into listener");
+				std::memcpy(m_callback, &_pfnCallback, sizeof(_pfnCallback));
+			}
 			EventListener(const EventListener&) = default;
 
-			inline bool OnEvent(IEvent& _event) {
-				if (m_CallbackLambda)
-					return m_CallbackLambda(_event);
-				return false;
+			inline bool OnEvent(IEvent& _event) const {
+				return m_pfnInvokeCallback(*this, _event);
 			}
 
 			template<typename T>
-			inline bool IsInstance(T* _pInstance) {
+			inline bool IsInstance(T* _pInstance) const {
 				return reinterpret_cast<T*>(m_pInstance) == _pInstance;
 			}
+
+			inline const void* GetInstance() const { return m_pInstance; }
+			inline const char* GetEventName() const { return m_szEventName; }
+	};
+
+
+	class EventManager;
+
+	// Events, which are stored in reusable memory chunks and dispatched later in the order they were pushed.
+	// Event classes that implement GetCoalescingKey() const are coalesced: an event replaces the earlier queued event of the same type
+	// and key, while keeping the position of the earlier event.
+	class EventQueue {
+		public:
+			using PFN_DispatchEvent = void(*)(EventManager&, IEvent&);
+
+		private:
+			struct _QueuedEvent {
+				IEvent* pEvent = nullptr;
+				PFN_DispatchEvent pfnDispatch = nullptr;
+				void(*pfnDestroy)(IEvent&) = nullptr;
+			};
+
+			// slot is occupied only if its generation matches the queue generation, which lets Clear() empty the table in constant time
+			struct _CoalescingSlot {
+				cvar::hash_t hshType = 0;
+				uint64_t uKey = 0;
+				size_t uEventIndex = 0;
+				uint32_t uGeneration = 0;
+			};
+
+			template<typename T, typename = void>
+			struct _IsCoalescing : std::false_type {};
+
+			template<typename T>
+			struct _IsCoalescing<T, std::void_t<decltype(std::declval<const T&>().GetCoalescingKey())>> : std::true_type {};
+
+			std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+			size_t m_uChunkIndex = 0;
+			size_t m_uChunkOffset = 0;
+
+			std::vector<_QueuedEvent> m_events;
+			// open addressing table of (event type, coalescing key) -> index of the queued event, linear probing
+			std::vector<_CoalescingSlot> m_coalescingSlots;
+			size_t m_uCoalescedEventCount = 0;
+			uint32_t m_uGeneration = 1;
+
+		private:
+			template<typename T>
+			static void _DestroyEvent(IEvent& _event) {
+				static_cast<T&>(_event).~T();
+			}
+
+			inline void* _Allocate(size_t _uSize, size_t _uAlignment) {
+				if (m_chunks.empty())
+					m_chunks.emplace_back(new unsigned char[EVENT_QUEUE_CHUNK_SIZE]);
+
+				size_t uOffset = (m_uChunkOffset + _uAlignment - 1) & ~(_uAlignment - 1);
+				if (uOffset + _uSize > EVENT_QUEUE_CHUNK_SIZE) {
+					m_uChunkIndex++;
+					if (m_uChunkIndex == m_chunks.size())
+						m_chunks.emplace_back(new unsigned char[EVENT_QUEUE_CHUNK_SIZE]);
+					uOffset = 0;
+				}
+
+				m_uChunkOffset = uOffset + _uSize;
+				return m_chunks[m_uChunkIndex].get() + uOffset;
+			}
+
+			static inline size_t _HashCoalescingKey(cvar::hash_t _hshType, uint64_t _uKey) {
+				uint64_t uHash = _hshType ^ (_uKey * 0x9e3779b97f4a7c15ull);
+				uHash ^= uHash >> 32;
+				return static_cast<size_t>(uHash);
+			}
+
+			inline void _GrowCoalescingSlots() {
+				std::vector<_CoalescingSlot> slots(m_coalescingSlots.empty() ? EVENT_QUEUE_COALESCING_SLOTS : m_coalescingSlots.size() * 2);
+				const size_t uMask = slots.size() - 1;
+				for (const _CoalescingSlot& slot : m_coalescingSlots) {
+					if (slot.uGeneration != m_uGeneration)
+						continue;
+
+					size_t i = _HashCoalescingKey(slot.hshType, slot.uKey) & uMask;
+					while (slots[i].uGeneration == m_uGeneration)
+						i = (i + 1) & uMask;
+					slots[i] = slot;
+				}
+
+				m_coalescingSlots.swap(slots);
+			}
+
+			// Returns the index of the queued event with the same type and key, if there is none _uEventIndex is inserted and returned
+			inline size_t _FindOrInsertCoalescedEvent(cvar::hash_t _hshType, uint64_t _uKey, size_t _uEventIndex) {
+				if ((m_uCoalescedEventCount + 1) * 2 > m_coalescingSlots.size())
+					_GrowCoalescingSlots();
+
+				const size_t uMask = m_coalescingSlots.size() - 1;
+				for (size_t i = _HashCoalescingKey(_hshType, _uKey) & uMask;; i = (i + 1) & uMask) {
+					_CoalescingSlot& slot = m_coalescingSlots[i];
+					if (slot.uGeneration != m_uGeneration) {
+						slot.hshType = _hshType;
+						slot.uKey = _uKey;
+						slot.uEventIndex = _uEventIndex;
+						slot.uGeneration = m_uGeneration;
+						m_uCoalescedEventCount++;
+						return _uEventIndex;
+					}
+
+					if (slot.hshType == _hshType && slot.uKey == _uKey)
+						return slot.uEventIndex;
+				}
+			}
+
+		public:
+			EventQueue() = default;
+			EventQueue(const EventQueue&) = delete;
+			~EventQueue() {
+				Clear();
+			}
+
+			template<typename T, typename... Args>
+			void Push(PFN_DispatchEvent _pfnDispatch, Args&&... args) {
+				static_assert(sizeof(T) <= EVENT_QUEUE_CHUNK_SIZE, "Event does not fit into event queue chunk");
+				static_assert(alignof(T) <= alignof(std::max_align_t), "Event alignment is not supported by event queue");
+
+				if constexpr (_IsCoalescing<T>::value) {
+					T event(std::forward<Args>(args)...);
+					const size_t uEventIndex = _FindOrInsertCoalescedEvent(T::GetStaticType(), static_cast<uint64_t>(event.GetCoalescingKey()), m_events.size());
+					if (uEventIndex != m_events.size()) {
+						T* pQueuedEvent = static_cast<T*>(m_events[uEventIndex].pEvent);
+						pQueuedEvent->~T();
+						new (pQueuedEvent) T(std::move(event));
+						return;
+					}
+
+					m_events.push_back({ new (_Allocate(sizeof(T), alignof(T))) T(std::move(event)), _pfnDispatch, &EventQueue::_DestroyEvent<T> });
+				}
+				else {
+					m_events.push_back({ new (_Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...), _pfnDispatch, &EventQueue::_DestroyEvent<T> });
+				}
+			}
+
+			// Dispatches every queued event in order, queue has to be cleared afterwards
+			inline void Dispatch(EventManager& _eventManager) {
+				for (const _QueuedEvent& queuedEvent : m_events)
+					queuedEvent.pfnDispatch(_eventManager, *queuedEvent.pEvent);
+			}
+
+			// Destroys all queued events, memory chunks, event and coalescing tables are kept for reuse
+			inline void Clear() {
+				for (const _QueuedEvent& queuedEvent : m_events)
+					queuedEvent.pfnDestroy(*queuedEvent.pEvent);
+
+				m_events.clear();
+				// slot generations are reset only once the counter wraps around
+				m_uCoalescedEventCount = 0;
+				if (++m_uGeneration == 0) {
+					for (_CoalescingSlot& slot : m_coalescingSlots)
+						slot.uGeneration = 0;
+					m_uGeneration = 1;
+				}
+				m_uChunkIndex = 0;
+				m_uChunkOffset = 0;
+			}
+
+			inline size_t GetEventCount() const { return m_events.size(); }
 	};
 
 
+	// Listener tables are immutable snapshots, which are replaced as a whole whenever a listener is added or removed.
+	// Dispatch reads the current snapshot without taking a lock, retired snapshots are freed by the next writer that sees no reader in progress.
+	// Listeners may thus dispatch events and add or remove listeners themselves, changes take effect from the next dispatch onwards.
+	//
+	// Threading guarantees:
+	//  - Dispatch() invokes listeners synchronously on the calling thread.
+	//  - Post() may be called from any thread, it is lock-free and never invokes listeners. A posted event is pushed into the queue of
+	//    the consumer its exact type is routed to and it is dispatched on whichever thread calls DispatchQueuedEvents() for that consumer.
+	//    Event types are routed to EVENT_CONSUMER_MAIN_THREAD, which App::Run drains once per frame, unless RouteEvent() says otherwise.
+	//  - Events posted by a single thread to a single consumer are dispatched in posting order.
 	class DENG_API EventManager {
 		private:
+			struct _ListenerTable {
+				std::unordered_map<cvar::hash_t, std::vector<EventListener>, cvar::NoHash> listeners;
+				// event type -> consumer, unlisted types are consumed by the main thread
+				std::unordered_map<cvar::hash_t, uint32_t, cvar::NoHash> consumers;
+			};
+
+			// type erased posted event, which is owned by the consumer queue it was pushed into
+			struct _PostedEventNode {
+				_PostedEventNode* pNext = nullptr;
+				// moves the event into an event queue and deletes the node
+				void(*pfnEnqueue)(_PostedEventNode*, EventQueue&) = nullptr;
+				void(*pfnDelete)(_PostedEventNode*) = nullptr;
+			};
+
+			template<typename T>
+			struct _PostedEvent : public _PostedEventNode {
+				T event;
+
+				template<typename... Args>
+				_PostedEvent(Args&&... args) :
+					event(std::forward<Args>(args)...) {}
+			};
+
+			struct _Consumer {
+				// lock-free multi producer stack of posted events, newest event first
+				std::atomic<_PostedEventNode*> pPostedEvents = nullptr;
+				// only accessed by the consuming thread
+				EventQueue eventQueue;
+			};
+
+			// keeps the listener table snapshot, which was loaded after construction, alive until destruction
+			class _SnapshotGuard {
+				private:
+					std::atomic<uint32_t>& m_uActiveReaderCount;
+
+				public:
+					_SnapshotGuard(std::atomic<uint32_t>& _uActiveReaderCount) :
+						m_uActiveReaderCount(_uActiveReaderCount)
+					{
+						m_uActiveReaderCount.fetch_add(1);
+					}
+
+					~_SnapshotGuard() {
+						m_uActiveReaderCount.fetch_sub(1);
+					}
+			};
+
+			// serializes listener table writers
 			std::mutex m_mutex;
-			std::unordered_map<cvar::hash_t, std::list<EventListener>, cvar::NoHash> m_eventHandlers;
+			std::atomic<const _ListenerTable*> m_pListenerTable = new _ListenerTable;
+			std::atomic<uint32_t> m_uActiveReaderCount = 0;
+			std::vector<const _ListenerTable*> m_retiredListenerTables;
+
+			std::array<_Consumer, MAX_EVENT_CONSUMERS> m_consumers;
+			std::atomic<uint32_t> m_uConsumerCount = 1;
+
+			std::atomic<bool> m_bIsProfiling = false;
+			EventProfiler m_profiler;
+
 			static EventManager m_sEventManager;
 
 		private:
 			template<typename T>
-			constexpr void _TraverseInheritanceHierarchy(T* _pEvent, std::vector<cvar::hash_t>& _eventTypesToDispatch) {
-				_eventTypesToDispatch.push_back(T::GetStaticType());
+			using _ParentEvent_T = std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const T&>().GetParent())>>;
+
+			template<typename T>
+			static constexpr size_t _GetInheritanceDepth() {
+				if constexpr (T::GetStaticType() != 0)
+					return 1 + _GetInheritanceDepth<_ParentEvent_T<T>>();
+				else return 1;
+			}
+
+			template<typename T>
+			static constexpr void _TraverseInheritanceHierarchy(cvar::hash_t* _pEventTypes) {
+				*_pEventTypes = T::GetStaticType();
 
 				if constexpr (T::GetStaticType() != 0) {
-					_TraverseInheritanceHierarchy(_pEvent->GetParent(), _eventTypesToDispatch);
+					_TraverseInheritanceHierarchy<_ParentEvent_T<T>>(_pEventTypes + 1);
 				}
 			}
 
+			// event type followed by the types of all of its base events
 			template<typename T>
-			constexpr std::vector<cvar::hash_t> _GetEventTypesToDispatch(T* _pEvent) {
-				std::vector<cvar::hash_t> eventTypesToDispatch;
+			static constexpr std::array<cvar::hash_t, _GetInheritanceDepth<T>()> _GetEventTypesToDispatch() {
+				std::array<cvar::hash_t, _GetInheritanceDepth<T>()> eventTypes = {};
+				_TraverseInheritanceHierarchy<T>(eventTypes.data());
+				return eventTypes;
+			}
+
+			template<typename F>
+			void _UpdateListenerTable(F&& _update) {
+				std::scoped_lock lock(m_mutex);
+				_ListenerTable* pListenerTable = new _ListenerTable(*m_pListenerTable.load());
+				_update(*pListenerTable);
+				m_retiredListenerTables.push_back(m_pListenerTable.exchange(pListenerTable));
+
+				// a reader, which started before the exchange, is still counted as active
+				if (m_uActiveReaderCount.load() == 0) {
+					for (const _ListenerTable* pRetiredTable : m_retiredListenerTables)
+						delete pRetiredTable;
+					m_retiredListenerTables.clear();
+				}
+			}
+
+			template<typename T>
+			void _DispatchEvent(T& _event) {
+				static constexpr auto s_eventTypesToDispatch = _GetEventTypesToDispatch<T>();
+
+				_SnapshotGuard snapshotGuard(m_uActiveReaderCount);
+				const _ListenerTable* pListenerTable = m_pListenerTable.load();
+				if (m_bIsProfiling.load(std::memory_order_relaxed)) {
+					_DispatchProfiledEvent(_event, s_eventTypesToDispatch, pListenerTable);
+					return;
+				}
+
+				for (cvar::hash_t hshEventType : s_eventTypesToDispatch) {
+					auto itListeners = pListenerTable->listeners.find(hshEventType);
+					if (itListeners == pListenerTable->listeners.end())
+						continue;
 
-				_TraverseInheritanceHierarchy(_pEvent, eventTypesToDispatch);
+					for (auto it = itListeners->second.rbegin(); it != itListeners->second.rend(); it++) {
+						if (it->OnEvent(_event))
+							break;
+					}
+				}
+			}
 
-				return eventTypesToDispatch;
+			// same as the regular dispatch loop, but every listener invocation is timed
+			template<typename T, size_t N>
+			void _DispatchProfiledEvent(T& _event, const std::array<cvar::hash_t, N>& _eventTypesToDispatch, const _ListenerTable* _pListenerTable) {
+				auto tpBegin = std::chrono::high_resolution_clock::now();
+				uint32_t uListenerInvocationCount = 0;
+
+				for (cvar::hash_t hshEventType : _eventTypesToDispatch) {
+					auto itListeners = _pListenerTable->listeners.find(hshEventType);
+					if (itListeners == _pListenerTable->listeners.end())
+						continue;
+
+					for (auto it = itListeners->second.rbegin(); it != itListeners->second.rend(); it++) {
+						auto tpListenerBegin = std::chrono::high_resolution_clock::now();
+						const bool bIsHandled = it->OnEvent(_event);
+						auto tpListenerEnd = std::chrono::high_resolution_clock::now();
+
+						uListenerInvocationCount++;
+						m_profiler.RecordListener(hshEventType, it->GetEventName(), it->GetInstance(),
+							static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(tpListenerEnd - tpListenerBegin).count()));
+						if (bIsHandled)
+							break;
+					}
+				}
+
+				auto tpEnd = std::chrono::high_resolution_clock::now();
+				m_profiler.RecordDispatch(T::GetStaticType(), T::GetStaticName(), static_cast<uint32_t>(N - 1), uListenerInvocationCount,
+					static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(tpEnd - tpBegin).count()));
 			}
-			
+
+			template<typename T>
+			static void _DispatchQueuedEvent(EventManager& _eventManager, IEvent& _event) {
+				_eventManager._DispatchEvent(static_cast<T&>(_event));
+			}
+
+			template<typename T>
+			static void _EnqueuePostedEvent(_PostedEventNode* _pNode, EventQueue& _eventQueue) {
+				_PostedEvent<T>* pPostedEvent = static_cast<_PostedEvent<T>*>(_pNode);
+				_eventQueue.Push<T>(&EventManager::_DispatchQueuedEvent<T>, std::move(pPostedEvent->event));
+				delete pPostedEvent;
+			}
+
+			template<typename T>
+			static void _DeletePostedEvent(_PostedEventNode* _pNode) {
+				delete static_cast<_PostedEvent<T>*>(_pNode);
+			}
+
 			EventManager() = default;
 
 		public:
+			~EventManager() {
+				for (_Consumer& consumer : m_consumers) {
+					_PostedEventNode* pNode = consumer.pPostedEvents.load();
+					while (pNode) {
+						_PostedEventNode* pNext = pNode->pNext;
+						pNode->pfnDelete(pNode);
+						pNode = pNext;
+					}
+				}
+
+				for (const _ListenerTable* pRetiredTable : m_retiredListenerTables)
+					delete pRetiredTable;
+				delete m_pListenerTable.load();
+			}
+
 			static EventManager& GetInstance() {
 				return m_sEventManager;
 			}
@@ -124,44 +518,101 @@ namespace DENG {
 
 			template<typename T, typename E>
 			inline void AddListener(PFN_ListenerCallback_T<T, E> _pfnCallback, T* _pClassInstance) {
-				std::scoped_lock lock(m_mutex);
-				m_eventHandlers[E::GetStaticType()].emplace_back(
-					_pClassInstance,
-					[=](IEvent& _event) {
-						return (*_pClassInstance.*_pfnCallback)(static_cast<E&>(_event));
-					}
-				);
+				_UpdateListenerTable([=](_ListenerTable& _listenerTable) {
+					_listenerTable.listeners[E::GetStaticType()].emplace_back(_pClassInstance, _pfnCallback);
+				});
 			}
 
 			template<typename T, typename E>
 			inline void RemoveListener(T* _pInstance) {
-				std::scoped_lock lock(m_mutex);
-				auto& listeners = m_eventHandlers[E::GetStaticType()];
-
-				for (auto it = listeners.begin(); it != listeners.end(); it++) {
-					if (it->IsInstance(_pInstance)) {
-						listeners.erase(it);
-						break;
+				_UpdateListenerTable([=](_ListenerTable& _listenerTable) {
+					auto itListeners = _listenerTable.listeners.find(E::GetStaticType());
+					if (itListeners == _listenerTable.listeners.end())
+						return;
+
+					for (auto it = itListeners->second.begin(); it != itListeners->second.end(); it++) {
+						if (it->IsInstance(_pInstance)) {
+							itListeners->second.erase(it);
+							break;
+						}
 					}
-				}
+				});
+			}
+
+			// Profiling is opt-in, dispatches only check a flag while it is disabled
+			inline void SetProfiling(bool _bIsProfiling) { m_bIsProfiling.store(_bIsProfiling); }
+			inline bool IsProfiling() const { return m_bIsProfiling.load(); }
+			inline EventProfiler& GetProfiler() { return m_profiler; }
+
+			// Reserves a consumer queue for a thread, which is going to call DispatchQueuedEvents() with the returned id
+			inline uint32_t CreateEventConsumer() {
+				const uint32_t uConsumer = m_uConsumerCount.fetch_add(1);
+				DENG_ASSERT(uConsumer < MAX_EVENT_CONSUMERS);
+				return uConsumer;
+			}
+
+			// Posted events of exact type E are consumed by _uConsumer from now on, events that are already queued stay where they are
+			template<typename E>
+			inline void RouteEvent(uint32_t _uConsumer) {
+				DENG_ASSERT(_uConsumer < m_uConsumerCount.load());
+				_UpdateListenerTable([=](_ListenerTable& _listenerTable) {
+					_listenerTable.consumers[E::GetStaticType()] = _uConsumer;
+				});
 			}
 
 
 			template<typename T, typename... Args>
-			void Dispatch(Args... args) {
-				std::scoped_lock lock(m_mutex);
+			void Dispatch(Args&&... args) {
 				T event(std::forward<Args>(args)...);
-				
-				std::vector<cvar::hash_t> eventTypesToDispatch = _GetEventTypesToDispatch(&event);
+				_DispatchEvent(event);
+			}
 
-				for (cvar::hash_t hshEventType : eventTypesToDispatch) {
-					auto& eventHandlers = m_eventHandlers[hshEventType];
+			// Queues an event for the consumer that T is routed to
+			template<typename T, typename... Args>
+			void Post(Args&&... args) {
+				_PostedEvent<T>* pPostedEvent = new _PostedEvent<T>(std::forward<Args>(args)...);
+				pPostedEvent->pfnEnqueue = &EventManager::_EnqueuePostedEvent<T>;
+				pPostedEvent->pfnDelete = &EventManager::_DeletePostedEvent<T>;
+
+				uint32_t uConsumer = EVENT_CONSUMER_MAIN_THREAD;
+				{
+					_SnapshotGuard snapshotGuard(m_uActiveReaderCount);
+					const _ListenerTable* pListenerTable = m_pListenerTable.load();
+					auto itConsumer = pListenerTable->consumers.find(T::GetStaticType());
+					if (itConsumer != pListenerTable->consumers.end())
+						uConsumer = itConsumer->second;
+				}
 
-					for (auto it = eventHandlers.rbegin(); it != eventHandlers.rend(); it++) {
-						if (it->OnEvent(event))
-							break;
-					}
+				std::atomic<_PostedEventNode*>& pPostedEvents = m_consumers[uConsumer].pPostedEvents;
+				_PostedEventNode* pHead = pPostedEvents.load(std::memory_order_relaxed);
+				do {
+					pPostedEvent->pNext = pHead;
+				} while (!pPostedEvents.compare_exchange_weak(pHead, pPostedEvent, std::memory_order_release, std::memory_order_relaxed));
+			}
+
+			// Dispatches events posted to _uConsumer since the previous call, events posted by listeners meanwhile are left for the next call.
+			// Only one thread may consume a given consumer id.
+			inline void DispatchQueuedEvents(uint32_t _uConsumer = EVENT_CONSUMER_MAIN_THREAD) {
+				_Consumer& consumer = m_consumers[_uConsumer];
+
+				// posted events are taken over as a whole and reversed into posting order
+				_PostedEventNode* pNode = consumer.pPostedEvents.exchange(nullptr, std::memory_order_acquire);
+				_PostedEventNode* pOrderedNode = nullptr;
+				while (pNode) {
+					_PostedEventNode* pNext = pNode->pNext;
+					pNode->pNext = pOrderedNode;
+					pOrderedNode = pNode;
+					pNode = pNext;
+				}
+
+				while (pOrderedNode) {
+					_PostedEventNode* pNext = pOrderedNode->pNext;
+					pOrderedNode->pfnEnqueue(pOrderedNode, consumer.eventQueue);
+					pOrderedNode = pNext;
 				}
+
+				consumer.eventQueue.Dispatch(*this);
+				consumer.eventQueue.Clear();
 			}
 	};
 }
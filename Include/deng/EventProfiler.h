@@ -0,0 +1,75 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: EventProfiler.h - event dispatch profiler class header
+// author: Karl-Mihkel Ott
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef EVENT_PROFILER_CPP
+	#include <algorithm>
+#endif
+
+#include "deng/Api.h"
+#include <cvar/SID.h>
+
+// listener costs are grouped into power of two nanosecond classes, class i holds durations in range [2^i, 2^(i + 1)) ns
+#ifndef EVENT_PROFILE_HISTOGRAM_SIZE
+#define EVENT_PROFILE_HISTOGRAM_SIZE 24
+#endif
+
+namespace DENG {
+
+	struct EventTypeProfile {
+		cvar::hash_t hshEventType = 0;
+		const char* szName = "";
+		// number of base event types that the dispatch walks through via GetParent()
+		uint32_t uPropagationSteps = 0;
+		uint64_t uFrameDispatchCount = 0;
+		uint64_t uLastFrameDispatchCount = 0;
+		uint64_t uTotalDispatchCount = 0;
+		uint64_t uListenerInvocationCount = 0;
+		uint64_t uTotalNanoseconds = 0;
+	};
+
+	struct ListenerProfile {
+		// event type the listener was added for, which can be a base type of dispatched events
+		cvar::hash_t hshEventType = 0;
+		const char* szEventName = "";
+		const void* pInstance = nullptr;
+		uint64_t uInvocationCount = 0;
+		// listener durations include events that the listener dispatches itself
+		uint64_t uTotalNanoseconds = 0;
+		uint64_t uMaxNanoseconds = 0;
+		std::array<uint64_t, EVENT_PROFILE_HISTOGRAM_SIZE> costHistogram = {};
+	};
+
+	// Thread safe accumulator of EventManager dispatch measurements, it is only written to while profiling is enabled
+	class DENG_API EventProfiler {
+		private:
+			mutable std::mutex m_mutex;
+			std::unordered_map<cvar::hash_t, EventTypeProfile, cvar::NoHash> m_eventTypeProfiles;
+			std::map<std::pair<cvar::hash_t, const void*>, ListenerProfile> m_listenerProfiles;
+
+		public:
+			void RecordDispatch(cvar::hash_t _hshEventType, const char* _szName, uint32_t _uPropagationSteps, uint32_t _uListenerInvocationCount, uint64_t _uNanoseconds);
+			void RecordListener(cvar::hash_t _hshEventType, const char* _szEventName, const void* _pInstance, uint64_t _uNanoseconds);
+			// rolls per frame dispatch counts over
+			void NextFrame();
+			void Reset();
+
+			// snapshots sorted by last frame dispatch count and by total listener time respectively
+			std::vector<EventTypeProfile> GetEventTypeProfiles() const;
+			std::vector<ListenerProfile> GetListenerProfiles() const;
+	};
+}
+
+#endif
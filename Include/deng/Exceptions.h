@@ -6,6 +6,7 @@
 #ifndef EXCEPTIONS_H
 #define EXCEPTIONS_H
 
+#include <string>
 #include <exception>
 
 namespace DENG {
@@ -22,7 +23,7 @@ namespace DENG {
 					m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -40,7 +41,7 @@ namespace DENG {
 					m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -57,7 +58,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -74,7 +75,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -92,7 +93,7 @@ namespace DENG {
 					m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -109,7 +110,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -126,7 +127,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -143,7 +144,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -160,7 +161,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -177,7 +178,7 @@ namespace DENG {
 				else m_szWhatMessage = _sWhat;
 			}
 
-			const char* what() const override {
+			const char* what() const noexcept override {
 				return m_szWhatMessage.c_str();
 			}
 	};
@@ -6,6 +6,10 @@
 #ifndef FILE_SYSTEM_SHADER_H
 #define FILE_SYSTEM_SHADER_H
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -25,6 +29,8 @@
 	#include "deng/Api.h"
 	#include "deng/ErrorDefinitions.h"
 	#include "deng/Exceptions.h"
+	#include "deng/SpirvCache.h"
+	#include "deng/ThreadPool.h"
 #endif
 
 namespace DENG {
@@ -35,10 +41,6 @@ namespace DENG {
 			const std::string_view m_csGeometryShaderSourcePath = "Shaders/Source/Geometry";
 			const std::string_view m_csFragmentShaderSourcePath = "Shaders/Source/Fragment";
 
-			const std::string_view m_csVertexShaderSpirvPath = "Shaders/SPV/Vertex";
-			const std::string_view m_csGeometryShaderSpirvPath = "Shaders/SPV/Geometry";
-			const std::string_view m_csFragmentShaderSpirvPath = "Shaders/SPV/Fragment";
-
 			const std::string m_csPipelineCachePath = "Shaders/PipelineCache";
 
 			// source identifiers
@@ -46,7 +48,7 @@ namespace DENG {
 			const std::string m_csGeometryShaderSourceName;
 			const std::string m_csFragmentShaderSourceName;
 			
-			// spirv identifiers
+			// spirv identifiers, compiled modules themselves are stored in SpirvCache
 			const std::string m_csVertexShaderSpirvName;
 			const std::string m_csGeometryShaderSpirvName;
 			const std::string m_csFragmentShaderSpirvName;
@@ -57,10 +59,35 @@ namespace DENG {
 			std::vector<std::pair<std::string, std::string>> m_geometryShaderMacros;
 			std::vector<std::pair<std::string, std::string>> m_fragmentShaderMacros;
 
+			// background compilations of vertex, geometry and fragment stages, a job is dropped once its result is taken
+			mutable std::mutex m_spirvJobMutex;
+			mutable std::array<std::future<std::vector<uint32_t>>, 3> m_spirvJobs;
+			// SpirvCache keys of loaded stages, zero until the stage is preprocessed for the current macro definitions
+			mutable std::array<std::atomic<cvar::hash_t>, 3> m_spirvKeys = {};
+
 		private:
-			std::vector<uint32_t>&& _CompileVertexShaderToSpirv() const;
-			std::vector<uint32_t>&& _CompileGeometryShaderToSpirv() const;
-			std::vector<uint32_t>&& _CompileFragmentShaderToSpirv() const;
+			std::string _GetSourcePath(ShaderStageBits _bmStage) const;
+			const std::vector<std::pair<std::string, std::string>>& _GetMacros(ShaderStageBits _bmStage) const;
+			// Preprocesses the stage source and returns SpirvCache key of the stage module
+			static cvar::hash_t _PreprocessSource(
+				const ProgramFilesManager& _programFilesManager,
+				const std::string& _sSourcePath,
+				ShaderStageBits _bmStage,
+				const std::vector<std::pair<std::string, std::string>>& _macros,
+				std::string& _sPreprocessedSource);
+			// Compilation only depends on its arguments, thus it can run on any thread, module key is written into _hshKey
+			static std::vector<uint32_t> _CompileSpirv(
+				const ProgramFilesManager& _programFilesManager,
+				const std::string& _sSourcePath,
+				ShaderStageBits _bmStage,
+				const std::vector<std::pair<std::string, std::string>>& _macros,
+				cvar::hash_t& _hshKey);
+			std::vector<uint32_t> _GetSpirv(ShaderStageBits _bmStage) const;
+			// every pipeline cache read, write and status check goes through the same path
+			std::string _GetPipelineCachePath(RendererType _eRendererType) const;
+			bool _ExistsPipelineCache(RendererType _eRendererType) const;
+			// waits for a pending job of the stage, whose macro definitions are about to change, and forgets the stage key
+			void _DiscardSpirvJob(ShaderStageBits _bmStage);
 
 		public:
 			// If spirv names are unspecified then source names are going to be used
@@ -70,36 +97,47 @@ namespace DENG {
 							 const std::string& _sVertexShaderSpirvName = "",
 							 const std::string& _sGeometryShaderSpirvName = "",
 							 const std::string& _sFragmentShaderSprivName = "");
+			~FileSystemShader();
+
+			virtual void CompileSpirvAsync() override;
+			virtual bool IsSpirvReady() const override;
+			virtual void WaitForSpirv() const override;
 
-			virtual std::vector<uint32_t>&& GetVertexShaderSpirv() const override;
-			virtual std::vector<uint32_t>&& GetGeometryShaderSpirv() const override;
-			virtual std::vector<uint32_t>&& GetFragmentShaderSpirv() const override;
+			virtual std::vector<uint32_t> GetVertexShaderSpirv() const override;
+			virtual std::vector<uint32_t> GetGeometryShaderSpirv() const override;
+			virtual std::vector<uint32_t> GetFragmentShaderSpirv() const override;
 
-			virtual std::vector<char>&& GetPipelineCache(RendererType _eRendererType) const override;
+			virtual FileView GetPipelineCache(RendererType _eRendererType) const override;
 			virtual void CachePipeline(RendererType _eRendererType, const void* _pData, size_t _uLength) const override;
 			virtual PipelineCacheStatusBits GetPipelineCacheStatus() const override;
 
 			inline void AddVertexShaderMacroDefinition(const std::string& _sDefinition) {
+				_DiscardSpirvJob(ShaderStageBit_Vertex);
 				m_vertexShaderMacros.push_back(std::make_pair(_sDefinition, ""));
 			}
 
 			inline void AddVertexShaderMacroDefinition(const std::string& _sDefinition, const std::string& _sValue) {
+				_DiscardSpirvJob(ShaderStageBit_Vertex);
 				m_vertexShaderMacros.push_back(std::make_pair(_sDefinition, _sValue));
 			}
 
 			inline void AddGeometryShaderMacroDefinition(const std::string& _sDefinition) {
+				_DiscardSpirvJob(ShaderStageBit_Geometry);
 				m_geometryShaderMacros.push_back(std::make_pair(_sDefinition, ""));
 			}
 
 			inline void AddGeometryShaderMacroDefinition(const std::string& _sDefinition, const std::string& _sValue) {
+				_DiscardSpirvJob(ShaderStageBit_Geometry);
 				m_geometryShaderMacros.push_back(std::make_pair(_sDefinition, _sValue));
 			}
 
 			inline void AddFragmentShaderMacroDefinition(const std::string& _sDefinition) {
+				_DiscardSpirvJob(ShaderStageBit_Fragment);
 				m_fragmentShaderMacros.push_back(std::make_pair(_sDefinition, ""));
 			}
 
 			inline void AddFragmentShaderMacroDefinition(const std::string& _sDefinition, const std::string& _sValue) {
+				_DiscardSpirvJob(ShaderStageBit_Fragment);
 				m_fragmentShaderMacros.push_back(std::make_pair(_sDefinition, _sValue));
 			}
 	};
@@ -12,8 +12,11 @@
 #ifdef FILE_TEXTURE_BUILDER_CPP
 	#include <fstream>
 	#include <array>
+	#include <cstring>
 	#include "deng/Exceptions.h"
 	#include "deng/ProgramFilesManager.h"
+	#include "deng/TextureCooker.h"
+	#include "deng/ThreadPool.h"
 	#include <stb_image.h>
 #endif
 
@@ -31,6 +34,29 @@ namespace DENG {
 	};
 
 
+	// Loads block compressed texture from DDS file. Other image formats are cooked into Textures/Cooked/<file>.<format>.dds
+	// on first load and the cooked file is reused for as long as it is newer than the source image.
+	// Without renderer support for block compression, see IRenderer::IsTextureCompressionSupported(), other image formats
+	// are loaded as raw RGBA texels the same way as FileTextureBuilder does.
+	class DENG_API FileCompressedTextureBuilder {
+		private:
+			const std::string m_sFileName;
+			const bool m_bCompressionSupported;
+			const TextureFormat m_eFormat;
+
+		private:
+			std::string _GetCookedFileName();
+
+		public:
+			FileCompressedTextureBuilder(const std::string& _sFileName, bool _bCompressionSupported, TextureFormat _eFormat = TextureFormat::BC3) :
+				m_sFileName(_sFileName),
+				m_bCompressionSupported(_bCompressionSupported),
+				m_eFormat(_eFormat) {}
+
+			Texture Get();
+	};
+
+
 	class DENG_API FileMonochromeTextureBuilder {
 		private:
 			const std::string m_sFileName;
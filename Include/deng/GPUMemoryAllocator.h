@@ -6,20 +6,52 @@
 #ifndef GPU_MEMORY_ALLOCATOR_H
 #define GPU_MEMORY_ALLOCATOR_H
 
+#include <array>
 #include <cstdint>
-#include <list>
-#include <vector>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
 
 #ifdef GPU_MEMORY_ALLOCATOR_CPP
-	#include <queue>
 	#include <algorithm>
 	#include <iostream>
-	
+	#include <sstream>
+
 	//#include "deng/Api.h"
 	#define DENG_API
 #endif
 
+// allocation sizes are grouped into power of two size classes, class i holds sizes in range [2^i, 2^(i + 1))
+#ifndef MEMORY_HISTOGRAM_SIZE
+#define MEMORY_HISTOGRAM_SIZE 32
+#endif
+
 namespace DENG {
+	struct DENG_API MemoryStatistics {
+		// bytes of offset space, which are covered by either used or unused blocks
+		size_t uCapacity = 0;
+		size_t uUsedBytes = 0;
+		size_t uFreeBytes = 0;
+		size_t uLargestFreeBlock = 0;
+		// number of separate unused blocks
+		size_t uFragmentCount = 0;
+		size_t uAllocationCount = 0;
+		// peak of used bytes over the allocator lifetime
+		size_t uHighWaterMark = 0;
+		// live allocation count per size class
+		std::array<size_t, MEMORY_HISTOGRAM_SIZE> allocationHistogram = {};
+
+		// share of unused bytes, which are not part of the largest unused block
+		inline float GetFragmentation() const {
+			return uFreeBytes ? 1.f - static_cast<float>(uLargestFreeBlock) / static_cast<float>(uFreeBytes) : 0.f;
+		}
+
+		void Accumulate(const MemoryStatistics& _statistics);
+		std::string ToJson() const;
+	};
+
 	struct MemoryRegion {
 		MemoryRegion() = default;
 		MemoryRegion(const MemoryRegion&) = default;
@@ -32,33 +64,44 @@ namespace DENG {
 		size_t uSize;
 	};
 
+	// Best fit allocator over an unbounded offset space, both allocation and freeing are O(log n) in the number of blocks.
+	// Every block, used or unused, is indexed by its offset, which makes neighbouring blocks available for coalescing on free.
+	// Unused blocks are additionally indexed by their size. Unused space at the end of the offset space is never kept as a block.
 	class DENG_API GPUMemoryAllocator {
 		private:
-			struct UnusedMemoryFragment {
-				std::list<MemoryRegion>::iterator region1;
-				std::list<MemoryRegion>::iterator region2;
-
-				size_t uOffset = 0;
+			struct _Block {
 				size_t uSize = 0;
-
-				struct Compare {
-					bool operator()(const UnusedMemoryFragment& _frag1, const UnusedMemoryFragment& _frag2) const {
-						return _frag1.uSize > _frag2.uSize;
-					}
-				};
+				bool bIsFree = false;
 			};
 
-			std::vector<UnusedMemoryFragment> m_storageFragments;
-			std::list<MemoryRegion> m_memoryRegions;
+			// offset -> block
+			std::map<size_t, _Block> m_blocks;
+			// (size, offset) of each unused block
+			std::set<std::pair<size_t, size_t>> m_freeBlocks;
+			size_t m_uEndOffset = 0;
+
+			// running counters, the rest of statistics is derived from blocks on request
+			size_t m_uUsedBytes = 0;
+			size_t m_uHighWaterMark = 0;
+			std::array<size_t, MEMORY_HISTOGRAM_SIZE> m_allocationHistogram = {};
+
+		private:
+			static size_t _GetSizeClass(size_t _uSize);
+			void _InsertFreeBlock(size_t _uOffset, size_t _uSize);
+			std::map<size_t, _Block>::iterator _FindFreeBlock(size_t _uSize, size_t _uAlignment);
 
 		public:
 			GPUMemoryAllocator() = default;
-			
+
 #ifdef _DEBUG
 			void DbPrintMemoryRegions();
 #endif
 			MemoryRegion RequestMemory(size_t _uSize, size_t _uMinimalAlignmentOffset);
 			bool FreeMemory(size_t _uOffset);
+
+			MemoryStatistics GetStatistics() const;
+			inline size_t GetUsedSize() const { return m_uUsedBytes; }
+			inline size_t GetEndOffset() const { return m_uEndOffset; }
 	};
 }
 
@@ -7,14 +7,15 @@
 #define IRENDERER_H
 
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
 #include <cvar/SID.h>
 
 #include "deng/Api.h"
+#include "deng/GPUMemoryAllocator.h"
 #include "deng/IWindowContext.h"
 #include "deng/IFramebuffer.h"
-#include "deng/GPUMemoryAllocator.h"
 
 #ifndef MAX_FRAMES_IN_FLIGHT
 #define MAX_FRAMES_IN_FLIGHT 2
@@ -32,15 +33,34 @@ namespace DENG {
 
     enum class BufferDataType { Vertex, Index, Uniform };
 
+    // buffer upload counters of a single frame
+    struct UploadStatistics {
+        size_t uBytesUploaded = 0;
+        uint32_t uCopyCount = 0;
+        uint32_t uSubmitCount = 0;
+    };
+
+    // single source region, which is copied into buffer at uDstOffset
+    struct BufferRegion {
+        const void* pData = nullptr;
+        size_t uSize = 0;
+        size_t uDstOffset = 0;
+    };
+
     class DENG_API IRenderer {
         protected:
 			IWindowContext* m_pWindowContext = nullptr;
-            GPUMemoryAllocator m_gpuMemoryAllocator;
             std::vector<IFramebuffer*> m_framebuffers;
 
             cvar::hash_t m_hshMissing2DTexture = 0;
 			cvar::hash_t m_hshMissing3DTexture = 0;
 
+            UploadStatistics m_uploadStatistics;
+            MemoryStatistics m_memoryStatistics;
+
+            // shader -> shader, whose pipeline is drawn with while the shader pipeline is being created
+            std::unordered_map<cvar::hash_t, cvar::hash_t, cvar::NoHash> m_fallbackShaders;
+
         public:
             IRenderer() = default;
 			virtual ~IRenderer() {};
@@ -48,11 +68,25 @@ namespace DENG {
             virtual void DeleteTextureHandles() = 0;
             virtual void UpdateViewport(uint32_t _uWidth, uint32_t _uHeight) = 0;
             virtual void DestroyPipeline(cvar::hash_t _hshShader) = 0;
+            // Creates pipelines of all shaders in the resource manager for the given framebuffer or for all framebuffers if it is nullptr,
+            // blocks until they are ready. Meant to be called behind a loading screen, pipelines are otherwise created on first draw.
+            virtual void PrecompilePipelines(IFramebuffer* _pFramebuffer = nullptr) = 0;
+            // true if block compressed textures can be sampled directly, otherwise textures have to be loaded as raw texels
+            virtual bool IsTextureCompressionSupported() const { return false; }
             virtual IFramebuffer* CreateFramebuffer(uint32_t _uWidth, uint32_t _uHeight) = 0;
             virtual IFramebuffer* CreateContext(IWindowContext* _pWindow) = 0;
             virtual size_t AllocateMemory(size_t _uSize, BufferDataType _eType) = 0;
 			virtual void DeallocateMemory(size_t _uOffset) = 0;
+            // Allocates memory from the current frame's linear region, which is reclaimed as a whole once the frame is no longer in flight.
+            // Returned offset must not be used past the current frame and it must not be given to DeallocateMemory().
+            virtual size_t AllocateFrameMemory(size_t _uSize, BufferDataType _eType) = 0;
+            // Returns staging memory, which is copied into buffer region [_uOffset, _uOffset + _uSize) before the current frame is rendered.
+            // Region has to be filled before any other buffer update call, writing into it directly avoids an intermediate copy.
+            virtual void* MapBufferRegion(size_t _uSize, size_t _uOffset) = 0;
             virtual void UpdateBuffer(const void* _pData, size_t _uSize, size_t _uOffset) = 0;
+            // Packs all regions into one staging allocation, which is copied into buffer with a single copy command.
+            // Source data is read before the call returns.
+            virtual void UpdateBufferRegions(const BufferRegion* _pRegions, size_t _uCount) = 0;
 			virtual bool SetupFrame() = 0;
 			virtual void DrawInstance(
                 cvar::hash_t _hshMesh,
@@ -61,6 +95,17 @@ namespace DENG {
                 uint32_t _uInstanceCount,
                 uint32_t _uFirstInstance = 0,
                 cvar::hash_t _hshMaterial = 0) = 0;
+
+            // Fallback shader must have the same vertex attributes, uniform data layouts, material sampler count and push constants.
+            // Without a fallback, draws are skipped until the shader pipeline is ready.
+            inline void SetFallbackShader(cvar::hash_t _hshShader, cvar::hash_t _hshFallbackShader) {
+                m_fallbackShaders[_hshShader] = _hshFallbackShader;
+            }
+
+            // counters of the previously set up frame
+            inline const UploadStatistics& GetUploadStatistics() const { return m_uploadStatistics; }
+            // main buffer allocator state at the start of the current frame
+            inline const MemoryStatistics& GetMemoryStatistics() const { return m_memoryStatistics; }
     };
 }
 
@@ -10,6 +10,7 @@
 #include <vector>
 #include <cvar/SID.h>
 #include "deng/Api.h"
+#include "deng/ProgramFilesManager.h"
 
 #include <bitset>
 
@@ -260,11 +261,18 @@ namespace DENG {
 			}
 
 
-			virtual std::vector<uint32_t>&& GetVertexShaderSpirv() const = 0;
-			virtual std::vector<uint32_t>&& GetGeometryShaderSpirv() const { return std::move(std::vector<uint32_t>()); }
-			virtual std::vector<uint32_t>&& GetFragmentShaderSpirv() const = 0;
+			virtual ~IShader() = default;
+
+			// Starts compiling stage modules in the background, SPIR-V getters block until their module is available
+			virtual void CompileSpirvAsync() {}
+			// true once no background compilation is running, SPIR-V getters do not block on compilation jobs afterwards
+			virtual bool IsSpirvReady() const { return true; }
+			virtual void WaitForSpirv() const {}
+			virtual std::vector<uint32_t> GetVertexShaderSpirv() const = 0;
+			virtual std::vector<uint32_t> GetGeometryShaderSpirv() const { return std::vector<uint32_t>(); }
+			virtual std::vector<uint32_t> GetFragmentShaderSpirv() const = 0;
 	
-			virtual std::vector<char>&& GetPipelineCache(RendererType) const { return std::move(std::vector<char>()); }
+			virtual FileView GetPipelineCache(RendererType) const { return FileView(); }
 			virtual void CachePipeline(RendererType, const void*, size_t) const {}
 			virtual PipelineCacheStatusBits GetPipelineCacheStatus() const { return PipelineCacheStatusBit_NoCache; }
 	};
@@ -18,6 +18,8 @@
 #include "deng/InputEvents.h"
 
 #ifdef IMGUI_LAYER_CPP
+	#include <array>
+	#include <fstream>
 	#include "deng/ImGuiResourceBuilders.h"
 	#include "deng/RenderResources.h"	
 	#include "deng/Exceptions.h"
@@ -27,6 +29,10 @@
 	#define MOUSE_BTN_LOOKUP(btn) s_ImGuiMouseCodes[static_cast<size_t>(btn) - 1]
 #endif
 
+#ifndef MEMORY_STATISTICS_DUMP_FILE
+#define MEMORY_STATISTICS_DUMP_FILE "MemoryStatistics.json"
+#endif
+
 namespace DENG {
 
 	class DENG_API ImGuiLayer : public ILayer {
@@ -46,9 +52,6 @@ namespace DENG {
 			size_t m_uUniformRegionOffset = 0;
 			float m_fDeltaTime = 0.f;
 
-			char* m_pDataBuffer = nullptr;
-			size_t m_uDataBufferSize = 0;
-
 			uint32_t m_uTextureHandle = 0;
 			bool m_bIsInit = false;
 
@@ -72,6 +75,11 @@ namespace DENG {
 				_CallbackLambda = [=]() { (*_pInstance.*_pfnMethod)(); };
 			}
 
+			// Draws a diagnostics window for allocator statistics, which can be dumped into MEMORY_STATISTICS_DUMP_FILE
+			static void DrawMemoryStatistics(const MemoryStatistics& _statistics);
+			// Draws a diagnostics window, which toggles EventManager profiling and shows per event type and per listener costs
+			static void DrawEventProfile();
+
 			bool OnKeyboardEvent(KeyboardEvent& _event);
 			bool OnMouseButtonEvent(MouseButtonEvent& _event);
 			bool OnMouseMovedEvent(MouseMovedEvent& _event);
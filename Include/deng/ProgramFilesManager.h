@@ -8,32 +8,81 @@
 
 #include <string>
 #include <cstdint>
+#include <ctime>
 #include <vector>
 
+#include "deng/Api.h"
+
 #ifdef PROGRAM_FILES_MANAGER_CPP
 	#include <filesystem>
 	#include <fstream>
+	#include <functional>
+	#include <thread>
 
-	#include <Windows.h>
+	#ifdef _WIN32
+		#include <Windows.h>
+	#else
+		#include <fcntl.h>
+		#include <sys/mman.h>
+		#include <sys/stat.h>
+		#include <unistd.h>
+	#endif
 
 	#include "deng/Exceptions.h"
 #endif
 
 namespace DENG {
 
+	// Read-only memory mapped view of a file, contents are valid for as long as the view is alive
+	class DENG_API FileView {
+		private:
+			const char* m_pData = nullptr;
+			size_t m_uSize = 0;
+#ifdef _WIN32
+			void* m_hFile = nullptr;
+			void* m_hMapping = nullptr;
+#endif
+
+		private:
+			void _Unmap();
+
+		public:
+			FileView() = default;
+			FileView(const std::string& _sAbsolutePath);
+			FileView(const FileView&) = delete;
+			FileView(FileView&& _view) noexcept;
+			~FileView();
+
+			FileView& operator=(const FileView&) = delete;
+			FileView& operator=(FileView&& _view) noexcept;
+
+			inline const char* Data() const { return m_pData; }
+			inline size_t Size() const { return m_uSize; }
+			inline bool Empty() const { return m_uSize == 0; }
+	};
+
+
 	class ProgramFilesManager {
 		private:
 			std::string m_sParentDirectory;
 
+		private:
+			std::string _GetAbsolutePath(const std::string& _sPath) const;
+
 		public:
 			ProgramFilesManager();
 			bool ExistsFile(const std::string& _sPath) const;
 			size_t FileSize(const std::string& _sPath) const;
 			time_t GetFileTimestamp(const std::string& _sPath) const;
-			std::vector<char>&& GetProgramFileContent(const std::string &_sPath) const;
+			std::vector<char> GetProgramFileContent(const std::string &_sPath) const;
+			// empty view is returned if the file does not exist or cannot be mapped
+			FileView MapProgramFile(const std::string& _sPath) const;
 			void WriteProgramFile(const std::vector<char>& _bytes, const std::string& _sFilePath) const;
 			void WriteProgramFile(const char* _pBytes, size_t _uByteCount, const std::string& _sFilePath) const;
+			// Writes into a temporary file next to the target and renames it over the target,
+			// thus readers observe either the old or the new file contents but never a partial write
+			void ReplaceProgramFile(const char* _pBytes, size_t _uByteCount, const std::string& _sFilePath) const;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -12,10 +12,14 @@
 #include <cvar/SID.h>
 
 #include "deng/Api.h"
+#include "deng/ErrorDefinitions.h"
 #include "deng/IShader.h"
 #include "deng/ResourceEvents.h"
+#include "deng/ThreadPool.h"
 
+#include <future>
 #include <mutex>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 #include <optional>
@@ -88,6 +92,7 @@ namespace DENG {
 		MaterialPBR() = default;
 		MaterialPBR(const MaterialPBR&) = default;
 		MaterialPBR(MaterialPBR&&) = default;
+		MaterialPBR& operator=(const MaterialPBR&) = default;
 
 		TRS::Vector4<float> vAlbedoFactor = { 1.f, 1.f, 1.f, 1.f };
 		TRS::Vector4<float> vEmissiveFactor = { 0.f, 0.f, 0.f, 1.f };
@@ -109,6 +114,7 @@ namespace DENG {
 		MaterialPhong() = default;
 		MaterialPhong(const MaterialPhong&) = default;
 		MaterialPhong(MaterialPhong&&) = default;
+		MaterialPhong& operator=(const MaterialPhong&) = default;
 
 		TRS::Vector4<float> vDiffuse = { 1.0f, 0.f, 0.f, 1.f };
 		TRS::Vector4<float> vSpecular = { 1.0f, 0.f, 0.f, 1.f };
@@ -134,7 +140,18 @@ namespace DENG {
 		External_TIFF,
 		External_BMP,
 		External_TGA,
-		External_GIF
+		External_GIF,
+		External_DDS
+	};
+
+	// Raw textures contain 8 bit per channel data with uBitDepth channels,
+	// block compressed textures contain 4x4 texel blocks for every mip level, face by face
+	enum class TextureFormat {
+		Raw,
+		BC1,
+		BC3,
+		BC5,
+		BC7
 	};
 
 	struct Texture {
@@ -144,6 +161,11 @@ namespace DENG {
 
 		TextureType eResourceType = TextureType::None;
 		TextureLoadType eLoadType = TextureLoadType::None;
+		TextureFormat eFormat = TextureFormat::Raw;
+
+		// only used by block compressed textures, raw textures get their mipmaps generated by the renderer
+		uint32_t uMipLevels = 1;
+		size_t uDataSize = 0;
 
 		char* pRGBAData = nullptr;
 		bool bHeapAllocationFlag = false;
@@ -157,7 +179,8 @@ namespace DENG {
 
 	class DENG_API ResourceManager {
 		private:
-			std::mutex m_mutex;
+			// resource events are posted instead of dispatched, thus listeners never run while this is held
+			mutable std::mutex m_mutex;
 
 			std::unordered_map<cvar::hash_t, MeshCommands, cvar::NoHash> m_meshes;
 			std::unordered_map<cvar::hash_t, Material<MaterialPBR, MAX_PBR_SAMPLERS>, cvar::NoHash> m_pbrMaterials;
@@ -165,6 +188,19 @@ namespace DENG {
 			std::unordered_map<cvar::hash_t, IShader*, cvar::NoHash> m_shaders;
 			std::unordered_map<cvar::hash_t, Texture, cvar::NoHash> m_textures;
 
+			// textures requested with AddTextureAsync that are not yet published
+			struct _LoadedTexture {
+				cvar::hash_t hshTexture = 0;
+				uint64_t uTicket = 0;
+				std::optional<Texture> texture;
+				std::string sErrorMessage;
+			};
+
+			std::unordered_map<cvar::hash_t, uint64_t, cvar::NoHash> m_pendingTextures;
+			uint64_t m_uTextureTicket = 0;
+			std::mutex m_loadedTexturesMutex;
+			std::vector<_LoadedTexture> m_loadedTextures;
+
 			EventManager& m_eventManager;
 			static ResourceManager m_sResourceManager;
 
@@ -176,6 +212,12 @@ namespace DENG {
 				for (auto it = m_shaders.begin(); it != m_shaders.end(); it++) {
 					delete it->second;
 				}
+
+				// ThreadPool is destroyed first, thus every decode has finished, free results that were never published
+				for (auto it = m_loadedTextures.begin(); it != m_loadedTextures.end(); it++) {
+					if (it->texture && it->texture->bHeapAllocationFlag)
+						delete[] it->texture->pRGBAData;
+				}
 			}
 
 			static ResourceManager& GetInstance() {
@@ -188,7 +230,7 @@ namespace DENG {
 				Builder meshBuilder(std::forward<Args>(args)...);
 				m_meshes.insert(std::make_pair(_hshMesh, meshBuilder.Get()));
 
-				m_eventManager.Dispatch<ResourceAddedEvent>(_hshMesh, ResourceType::Mesh);
+				m_eventManager.Post<ResourceAddedEvent>(_hshMesh, ResourceType::Mesh);
 				return m_meshes[_hshMesh];
 			}
 
@@ -215,7 +257,7 @@ namespace DENG {
 			}
 
 			inline void RemoveMesh(cvar::hash_t _hshMesh) {
-				m_eventManager.Dispatch<ResourceRemoveEvent>(_hshMesh, ResourceType::Mesh);
+				m_eventManager.Post<ResourceRemoveEvent>(_hshMesh, ResourceType::Mesh);
 				m_meshes.erase(_hshMesh);
 			}
 
@@ -225,7 +267,7 @@ namespace DENG {
 				Builder materialBuilder(std::forward<Args>(args)...);
 				m_pbrMaterials.insert(std::make_pair(_hshMaterial, materialBuilder.Get()));
 
-				m_eventManager.Dispatch<ResourceAddedEvent>(_hshMaterial, ResourceType::Material_PBR);
+				m_eventManager.Post<ResourceAddedEvent>(_hshMaterial, ResourceType::Material_PBR);
 				return m_pbrMaterials[_hshMaterial];
 			}
 
@@ -252,7 +294,7 @@ namespace DENG {
 			}
 
 			inline void RemoveMaterialPBR(cvar::hash_t _hshMaterial) {
-				m_eventManager.Dispatch<ResourceRemoveEvent>(_hshMaterial, ResourceType::Material_PBR);
+				m_eventManager.Post<ResourceRemoveEvent>(_hshMaterial, ResourceType::Material_PBR);
 				m_pbrMaterials.erase(_hshMaterial);
 			}
 
@@ -262,7 +304,7 @@ namespace DENG {
 				Builder materialBuilder(std::forward<Args>(args)...);
 				m_phongMaterials.insert(std::make_pair(_uHash, materialBuilder.Get()));
 
-				m_eventManager.Dispatch<ResourceAddedEvent>(_hshMaterial, ResourceType::Material_Phong);
+				m_eventManager.Post<ResourceAddedEvent>(_hshMaterial, ResourceType::Material_Phong);
 				return m_phongMaterials[_uHash];
 			}
 
@@ -282,7 +324,7 @@ namespace DENG {
 			}
 
 			inline void RemoveMaterialPhong(cvar::hash_t _hshMaterial) {
-				m_eventManager.Dispatch<ResourceRemoveEvent>(_hshMaterial, ResourceType::Material_Phong);
+				m_eventManager.Post<ResourceRemoveEvent>(_hshMaterial, ResourceType::Material_Phong);
 				m_phongMaterials.erase(_hshMaterial);
 			}
 
@@ -290,7 +332,10 @@ namespace DENG {
 			inline const IShader* AddShader(cvar::hash_t _hshShader, Args&&... args) {
 				std::scoped_lock lock(m_mutex);
 				Builder shaderBuilder(std::forward<Args>(args)...);
-				m_shaders.insert(std::make_pair(_hshShader, shaderBuilder.Get()));
+				IShader* pShader = shaderBuilder.Get();
+				// stages compile on the thread pool while the rest of resources are created, pipeline creation waits for them
+				pShader->CompileSpirvAsync();
+				m_shaders.insert(std::make_pair(_hshShader, pShader));
 				return m_shaders[_hshShader];
 			}
 
@@ -317,7 +362,7 @@ namespace DENG {
 			}
 
 			inline void RemoveShader(cvar::hash_t _hshShader) {
-				m_eventManager.Dispatch<ResourceRemoveEvent>(_hshShader, ResourceType::Shader);
+				m_eventManager.Post<ResourceRemoveEvent>(_hshShader, ResourceType::Shader);
 				
 				if (m_shaders.find(_hshShader) != m_shaders.end())
 					delete m_shaders[_hshShader];
@@ -330,10 +375,94 @@ namespace DENG {
 				Builder textureBuilder(std::forward<Args>(args)...);
 				m_textures.insert(std::make_pair(_hshTexture, textureBuilder.Get()));
 				
-				m_eventManager.Dispatch<ResourceAddedEvent>(_hshTexture, ResourceType::Texture);
+				m_eventManager.Post<ResourceAddedEvent>(_hshTexture, ResourceType::Texture);
 				return m_textures[_hshTexture];
 			}
 
+			// Decodes the texture on a worker thread, until PublishLoadedTextures() picks up the result the texture is
+			// an empty placeholder which renderers substitute with the missing texture.
+			// Builder arguments are copied, returned future rethrows any exception thrown by the builder.
+			template<typename Builder, typename... Args>
+			inline std::future<void> AddTextureAsync(cvar::hash_t _hshTexture, Args&&... args) {
+				uint64_t uTicket = 0;
+				{
+					std::scoped_lock lock(m_mutex);
+					DENG_ASSERT(m_textures.find(_hshTexture) == m_textures.end() || m_pendingTextures.find(_hshTexture) != m_pendingTextures.end());
+					uTicket = ++m_uTextureTicket;
+					m_textures[_hshTexture] = Texture();
+					m_pendingTextures[_hshTexture] = uTicket;
+				}
+
+				auto builderArgs = std::make_tuple(std::decay_t<Args>(std::forward<Args>(args))...);
+				return ThreadPool::GetInstance().Submit([this, _hshTexture, uTicket, builderArgs = std::move(builderArgs)]() mutable {
+					_LoadedTexture loadedTexture;
+					loadedTexture.hshTexture = _hshTexture;
+					loadedTexture.uTicket = uTicket;
+
+					try {
+						Builder textureBuilder = std::make_from_tuple<Builder>(std::move(builderArgs));
+						loadedTexture.texture = textureBuilder.Get();
+					}
+					catch (const std::exception& e) {
+						// failed loads are still reported, so that the texture stops being pending
+						loadedTexture.sErrorMessage = e.what();
+						std::scoped_lock lock(m_loadedTexturesMutex);
+						m_loadedTextures.push_back(std::move(loadedTexture));
+						throw;
+					}
+
+					std::scoped_lock lock(m_loadedTexturesMutex);
+					m_loadedTextures.push_back(std::move(loadedTexture));
+				});
+			}
+
+			// Moves textures decoded by AddTextureAsync into the texture table and posts ResourceAddedEvent for each of them.
+			// Must be called from the thread that renders, App::Run does this once per frame.
+			inline void PublishLoadedTextures() {
+				std::vector<_LoadedTexture> loadedTextures;
+				{
+					std::scoped_lock lock(m_loadedTexturesMutex);
+					if (m_loadedTextures.empty())
+						return;
+					loadedTextures.swap(m_loadedTextures);
+				}
+
+				for (auto it = loadedTextures.begin(); it != loadedTextures.end(); it++) {
+					{
+						std::scoped_lock lock(m_mutex);
+						auto pendingIt = m_pendingTextures.find(it->hshTexture);
+
+						// texture was removed or requested again while decoding
+						if (pendingIt == m_pendingTextures.end() || pendingIt->second != it->uTicket) {
+							if (it->texture && it->texture->bHeapAllocationFlag)
+								delete[] it->texture->pRGBAData;
+							continue;
+						}
+
+						m_pendingTextures.erase(pendingIt);
+						
+						// failed loads keep the placeholder
+						if (!it->texture) {
+							DISPATCH_ERROR_MESSAGE("TextureLoadError", it->sErrorMessage, ErrorSeverity::NON_CRITICAL);
+							continue;
+						}
+						m_textures[it->hshTexture] = *it->texture;
+					}
+
+					m_eventManager.Post<ResourceAddedEvent>(it->hshTexture, ResourceType::Texture);
+				}
+			}
+
+			inline bool IsTexturePending(cvar::hash_t _hshTexture) const {
+				std::scoped_lock lock(m_mutex);
+				return m_pendingTextures.find(_hshTexture) != m_pendingTextures.end();
+			}
+
+			inline bool HasPendingTextures() const {
+				std::scoped_lock lock(m_mutex);
+				return !m_pendingTextures.empty();
+			}
+
 			inline const Texture* GetTexture(cvar::hash_t _hshTexture) const {
 				auto it = m_textures.find(_hshTexture);
 				if (it == m_textures.end())
@@ -350,12 +479,20 @@ namespace DENG {
 			}
 
 			inline void RemoveTexture(cvar::hash_t _hshTexture) {
-				m_eventManager.Dispatch<ResourceRemoveEvent>(_hshTexture, ResourceType::Texture);
+				m_eventManager.Post<ResourceRemoveEvent>(_hshTexture, ResourceType::Texture);
+				std::scoped_lock lock(m_mutex);
 				m_textures.erase(_hshTexture);
+				m_pendingTextures.erase(_hshTexture);
 			}
 
 			inline void FreeTextureHeapData(cvar::hash_t _hshTexture) {
-				delete[] m_textures[_hshTexture].pRGBAData;
+				auto it = m_textures.find(_hshTexture);
+				if (it == m_textures.end())
+					return;
+
+				delete[] it->second.pRGBAData;
+				it->second.pRGBAData = nullptr;
+				it->second.bHeapAllocationFlag = false;
 			}
 	};
 }
@@ -30,11 +30,11 @@ namespace DENG {
 				m_eType(_eType) {}
 			ResourceEvent(const ResourceEvent&) = default;
 
-			inline cvar::hash_t GetResourceHash() {
+			inline cvar::hash_t GetResourceHash() const {
 				return m_hshResource;
 			}
 
-			inline ResourceType GetType() {
+			inline ResourceType GetType() const {
 				return m_eType;
 			}
 
@@ -47,6 +47,11 @@ namespace DENG {
 				ResourceEvent(_hshResource, _eType) {}
 			ResourceModifiedEvent(const ResourceModifiedEvent&) = default;
 
+			// posted modifications of the same resource collapse into one
+			inline uint64_t GetCoalescingKey() const {
+				return static_cast<uint64_t>(GetResourceHash()) ^ static_cast<uint64_t>(GetType());
+			}
+
 			EVENT_CLASS_TYPE_NO_ID_CHECK("ResourceModifiedEvent", ResourceEvent);
 	};
 
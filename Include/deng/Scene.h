@@ -8,10 +8,12 @@
 
 #include <chrono>
 #include <future>
+#include <map>
+#include <tuple>
 #include <type_traits>
-#include <set>
 
 #include "deng/Api.h"
+#include "deng/DirtyBitset.h"
 #include "deng/IRenderer.h"
 #include "deng/SceneRenderer.h"
 #include "deng/IRenderer.h"
@@ -19,6 +21,8 @@
 #include "deng/RenderResources.h"
 #include "deng/SceneEvents.h"
 #include "deng/ResourceEvents.h"
+#include "deng/ThreadPool.h"
+#include "deng/TransformKernels.h"
 
 #ifdef SCENE_CPP
 	#include "deng/ErrorDefinitions.h"
@@ -34,6 +38,8 @@ namespace DENG {
 		std::vector<MaterialPBR> pbrMaterials;
 		std::vector<MaterialPhong> phongMaterials;
 		std::vector<DrawDescriptorIndices> drawDescriptorIndices;
+		std::vector<Entity> descriptorOwners;
+		std::vector<Entity> transformOwners;
 	};
 
 	struct Lights {
@@ -52,6 +58,20 @@ namespace DENG {
 
 	typedef uint8_t RendererCopyFlagBits;
 
+#define INVALID_INSTANCE_SLOT UINT32_MAX
+#define INSTANCE_BATCH_MIN_CAPACITY 8
+
+#ifndef TRANSFORM_JOB_CHUNK_SIZE
+#define TRANSFORM_JOB_CHUNK_SIZE 1024
+#endif
+
+	// per entity location of instanced data
+	struct RenderableSlot {
+		uint32_t uBatch = INVALID_INSTANCE_SLOT;		// index into Instances::instanceInfos
+		uint32_t uDescriptor = INVALID_INSTANCE_SLOT;	// index into Instances::drawDescriptorIndices
+		uint32_t uTransform = INVALID_INSTANCE_SLOT;	// index into Instances::transforms
+	};
+
 	class DENG_API Scene {
 		private:
 			SceneRenderer m_sceneRenderer;
@@ -63,13 +83,25 @@ namespace DENG {
 			Instances m_instances;
 			Lights m_lights;
 
-			std::unordered_map<Entity, std::pair<std::size_t, std::size_t>> m_renderableInstanceLookup;
-			std::set<std::size_t> m_modifiedTransforms;
+			using _BatchKey = std::tuple<cvar::hash_t, cvar::hash_t, cvar::hash_t>;
+
+			// entity index -> instanced data location
+			std::vector<RenderableSlot> m_renderableSlots;
+			std::map<_BatchKey, uint32_t> m_batchLookup;
+			std::unordered_map<cvar::hash_t, std::size_t, cvar::NoHash> m_materialIndexLookup;
+			std::vector<uint32_t> m_freeTransformSlots;
+			std::size_t m_uInstanceCount = 0;
+
+			DirtyBitset m_modifiedTransforms;
+			std::vector<std::pair<std::size_t, std::size_t>> m_transformJobs;
+			DirtyBitset m_modifiedDrawDescriptors;
+			DirtyBitset m_modifiedPbrMaterials;
+			DirtyBitset m_modifiedPhongMaterials;
 
 			std::unordered_map<Entity, std::size_t> m_lightLookup;
-			std::set<std::size_t> m_modifiedDirLights;
-			std::set<std::size_t> m_modifiedSpotLights;
-			std::set<std::size_t> m_modifiedPointLights;
+			DirtyBitset m_modifiedDirLights;
+			DirtyBitset m_modifiedSpotLights;
+			DirtyBitset m_modifiedPointLights;
 
 			std::chrono::time_point<std::chrono::high_resolution_clock> m_tpBegin =
 				std::chrono::high_resolution_clock::now();
@@ -81,6 +113,39 @@ namespace DENG {
 			RendererCopyFlagBits m_bmCopyFlags = RendererCopyFlagBit_None;
 
 		private:
+			inline RenderableSlot& _GetRenderableSlot(Entity _idEntity) {
+				const std::size_t uEntityIndex = static_cast<std::size_t>(entt::to_entity(_idEntity));
+				if (uEntityIndex >= m_renderableSlots.size())
+					m_renderableSlots.resize(uEntityIndex + 1);
+				return m_renderableSlots[uEntityIndex];
+			}
+
+			inline const RenderableSlot* _FindRenderableSlot(Entity _idEntity) const {
+				const std::size_t uEntityIndex = static_cast<std::size_t>(entt::to_entity(_idEntity));
+				if (uEntityIndex >= m_renderableSlots.size() || m_renderableSlots[uEntityIndex].uBatch == INVALID_INSTANCE_SLOT)
+					return nullptr;
+				return &m_renderableSlots[uEntityIndex];
+			}
+
+			template <typename T>
+			void _UploadRegions(const std::vector<std::pair<std::size_t, std::size_t>>& _regions, const std::vector<T>& _data, void (SceneRenderer::*_pfnUpdateRegion)(const T*, std::size_t, std::size_t)) {
+				for (auto it = _regions.begin(); it != _regions.end(); it++) {
+					(m_sceneRenderer.*_pfnUpdateRegion)(
+						_data.data() + it->first,
+						it->first,
+						it->second - it->first + 1);
+				}
+			}
+
+			template <typename T>
+			void _UploadDirtyRegions(DirtyBitset& _dirtyBitset, const std::vector<T>& _data, void (SceneRenderer::*_pfnUpdateRegion)(const T*, std::size_t, std::size_t)) {
+				if (!_dirtyBitset.Any())
+					return;
+
+				_UploadRegions(_dirtyBitset.MakeRegions(), _data, _pfnUpdateRegion);
+				_dirtyBitset.Clear();
+			}
+
 			template <typename T>
 			void _ApplyLightSourceTransforms() {
 				auto view = m_registry.view<T, TransformComponent>();
@@ -118,7 +183,15 @@ namespace DENG {
 				}
 			}
 
-			std::vector<std::pair<std::size_t, std::size_t>> _MakeMemoryRegions(const std::set<std::size_t>& _updateSet);
+			uint32_t _FindOrCreateBatch(const _BatchKey& _key, uint32_t _uCapacity);
+			void _GrowBatch(uint32_t _uBatch);
+			int32_t _IndexMaterial(cvar::hash_t _hshMaterial);
+			uint32_t _AllocateTransformSlot();
+			void _CalculateTransforms(const std::vector<std::pair<std::size_t, std::size_t>>& _regions);
+			void _AddInstance(Entity _idEntity);
+			void _RemoveInstance(Entity _idEntity);
+			void _ResetInstances();
+			void _ClearInstanceDirtyFlags();
 			void _CorrectMeshResources();
 			void _CorrectLightResources();
 			void _InstanceRenderablesMSM();
@@ -169,11 +242,24 @@ namespace DENG {
 				m_vAmbient = _vAmbient;
 			}
 
+			// modified elements closer than _uMergeGap are uploaded as one region
+			inline void SetUploadMergeGap(std::size_t _uMergeGap) {
+				m_modifiedTransforms.SetMergeGap(_uMergeGap);
+				m_modifiedDrawDescriptors.SetMergeGap(_uMergeGap);
+				m_modifiedPbrMaterials.SetMergeGap(_uMergeGap);
+				m_modifiedPhongMaterials.SetMergeGap(_uMergeGap);
+				m_modifiedDirLights.SetMergeGap(_uMergeGap);
+				m_modifiedSpotLights.SetMergeGap(_uMergeGap);
+				m_modifiedPointLights.SetMergeGap(_uMergeGap);
+			}
+
 			void AttachComponents();
 			void RenderScene();
 			void DestroyComponents();
 
 			bool OnComponentModifiedEvent(ComponentModifiedEvent& _event);
+			bool OnComponentAddedEvent(ComponentAddedEvent& _event);
+			bool OnComponentRemoveEvent(ComponentRemoveEvent& _event);
 			bool OnResourceModifiedEvent(ResourceModifiedEvent& _event);
 	};
 }
@@ -69,11 +69,11 @@ namespace DENG {
 				m_eType(_eType) {}
 			ComponentEvent(const ComponentEvent&) = default;
 
-			inline Entity GetEntity() {
+			inline Entity GetEntity() const {
 				return m_idEntity;
 			}
 
-			inline ComponentType GetComponentType() {
+			inline ComponentType GetComponentType() const {
 				return m_eType;
 			}
 
@@ -86,6 +86,11 @@ namespace DENG {
 				ComponentEvent(_idEntity, _eType) {}
 			ComponentModifiedEvent(const ComponentModifiedEvent&) = default;
 
+			// posted modifications of the same entity components collapse into one
+			inline uint64_t GetCoalescingKey() const {
+				return (static_cast<uint64_t>(GetEntity()) << 32) | static_cast<uint64_t>(GetComponentType());
+			}
+
 			EVENT_CLASS_TYPE_NO_ID_CHECK("ComponentModifiedEvent", ComponentEvent);
 	};
 
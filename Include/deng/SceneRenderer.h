@@ -42,8 +42,10 @@ namespace DENG {
 			// skybox
 			size_t m_uSkyboxScaleOffset = 0;
 
-			char* m_pIntermediateStorageBuffer = nullptr;
-			size_t m_uIntermediateStorageBufferSize = 0;
+			size_t m_uLightsRegionSize = 0;
+
+			// sparse region updates are gathered and uploaded together in FlushRegionUpdates()
+			std::vector<BufferRegion> m_pendingRegions;
 
 		public:
 			SceneRenderer(IRenderer* _pRenderer, IFramebuffer* _pFramebuffer);
@@ -62,10 +64,21 @@ namespace DENG {
 								 const std::vector<DrawDescriptorIndices>& _drawDescriptorIndices,
 								 const CameraComponent& _camera);
 
+			// Region updates are queued until FlushRegionUpdates() is called, source data must stay unchanged until then
 			void UpdateTransformRegion(const TransformComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount);
 			void UpdateDirLightRegion(const DirectionalLightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount);
 			void UpdatePointLightRegion(const PointLightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount);
 			void UpdateSpotLightRegion(const SpotlightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount);
+			void UpdatePbrMaterialRegion(const MaterialPBR* _pData, std::size_t _uDstOffset, std::size_t _uCount);
+			void UpdatePhongMaterialRegion(const MaterialPhong* _pData, std::size_t _uDstOffset, std::size_t _uCount);
+			void UpdateDrawDescriptorIndicesRegion(const DrawDescriptorIndices* _pData, std::size_t _uDstOffset, std::size_t _uCount);
+			void FlushRegionUpdates();
+
+			// true if any of the given storage arrays no longer fits into its device allocation
+			bool IsStorageReallocationRequired(const std::vector<TransformComponent>& _transforms,
+											   const std::vector<MaterialPBR>& _pbrMaterials,
+											   const std::vector<MaterialPhong>& _phongMaterials,
+											   const std::vector<DrawDescriptorIndices>& _drawDescriptorIndices) const;
 
 			void UpdateStorageBuffers(const std::vector<TransformComponent>& _transforms,
 									  const std::vector<MaterialPBR>& _pbrMaterials,
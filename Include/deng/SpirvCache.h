@@ -0,0 +1,71 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: SpirvCache.h - content addressed SPIR-V module cache class header
+// author: Karl-Mihkel Ott
+
+#ifndef SPIRV_CACHE_H
+#define SPIRV_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cvar/SID.h>
+#include "deng/Api.h"
+#include "deng/ProgramFilesManager.h"
+
+#ifdef SPIRV_CACHE_CPP
+	#include <iomanip>
+	#include <sstream>
+
+	#include "deng/ErrorDefinitions.h"
+	#include "deng/Exceptions.h"
+#endif
+
+// bump whenever the key derivation or the module file format changes
+#ifndef SPIRV_CACHE_FORMAT_VERSION
+#define SPIRV_CACHE_FORMAT_VERSION 1
+#endif
+
+#define SPIRV_MAGIC_NUMBER 0x07230203u
+
+namespace DENG {
+
+	// Process wide cache of compiled SPIR-V modules, which are addressed by a 64 bit key that the caller derives from
+	// everything that affects the compilation output (preprocessed source, macro definitions, shader stage and compiler options).
+	// Modules are kept in memory and persisted as Shaders/SPV/Cache/<key>.spv, files are written atomically thus
+	// concurrent writers of the same key and readers in other processes never observe partially written modules.
+	class DENG_API SpirvCache {
+		private:
+			const std::string m_csCachePath = "Shaders/SPV/Cache";
+
+			ProgramFilesManager m_programFilesManager;
+			std::mutex m_mutex;
+			std::unordered_map<cvar::hash_t, std::vector<uint32_t>, cvar::NoHash> m_modules;
+
+			static SpirvCache m_sSpirvCache;
+
+		private:
+			SpirvCache() = default;
+			std::string _GetModulePath(cvar::hash_t _hshKey) const;
+
+		public:
+			static SpirvCache& GetInstance() {
+				return m_sSpirvCache;
+			}
+
+			// 64 bit FNV-1a, pass the previous digest as a seed to hash multiple buffers
+			static cvar::hash_t Hash(const void* _pData, size_t _uLength, cvar::hash_t _hshSeed = 14695981039346656037ull);
+
+			// Looks the module up from memory and then from disk, returns false if it is not cached or the cached file is invalid
+			bool Find(cvar::hash_t _hshKey, std::vector<uint32_t>& _spirv);
+			bool Contains(cvar::hash_t _hshKey);
+			void Store(cvar::hash_t _hshKey, const std::vector<uint32_t>& _spirv);
+			// drops in-memory modules, files on disk are kept
+			void Clear();
+	};
+}
+
+#endif
@@ -0,0 +1,52 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: TextureCooker.h - block compressed texture cooking and DDS container class header
+// author: Karl-Mihkel Ott
+
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "deng/Api.h"
+#include "deng/RenderResources.h"
+
+#ifdef TEXTURE_COOKER_CPP
+	#include <algorithm>
+	#include <cfloat>
+	#include <cmath>
+	#include <cstring>
+
+	#include "deng/Exceptions.h"
+	#include "deng/ThreadPool.h"
+#endif
+
+namespace DENG {
+
+	// Offline texture compression into DDS containers.
+	// BC1, BC3 and BC5 can be encoded, BC7 textures are only loaded, since they have to be cooked with an external tool.
+	class DENG_API TextureCooker {
+		private:
+			static void _EncodeBC1Block(const uint8_t* _pRGBA, uint8_t* _pBlock);
+			static void _EncodeBC4Block(const uint8_t* _pRGBA, size_t _uChannel, uint8_t* _pBlock);
+			static void _EncodeBlock(TextureFormat _eFormat, const uint8_t* _pRGBA, uint8_t* _pBlock);
+			static void _EncodeMipLevel(TextureFormat _eFormat, const uint8_t* _pRGBA, uint32_t _uWidth, uint32_t _uHeight, uint8_t* _pDst);
+			static std::vector<uint8_t> _Downsample(const uint8_t* _pRGBA, uint32_t _uWidth, uint32_t _uHeight);
+
+		public:
+			// 8 bytes for BC1, 16 bytes for others
+			static size_t GetBlockSize(TextureFormat _eFormat);
+			static size_t CalculateMipLevelSize(TextureFormat _eFormat, uint32_t _uWidth, uint32_t _uHeight);
+			static uint32_t CalculateMipLevelCount(uint32_t _uWidth, uint32_t _uHeight);
+
+			// compresses RGBA8 image and its full mip chain into a DDS container
+			static std::vector<char> Cook(const char* _pRGBA, uint32_t _uWidth, uint32_t _uHeight, TextureFormat _eFormat);
+
+			// parses a DDS container with BC1, BC3, BC5 or BC7 data, texel data is copied into a new[] allocated buffer
+			static Texture LoadDDS(const char* _pData, size_t _uSize);
+	};
+}
+
+#endif
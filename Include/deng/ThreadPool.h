@@ -0,0 +1,120 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: ThreadPool.h - worker thread pool class header
+// author: Karl-Mihkel Ott
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "deng/Api.h"
+
+namespace DENG {
+
+	class DENG_API ThreadPool {
+		private:
+			std::vector<std::thread> m_workers;
+			std::queue<std::function<void()>> m_jobs;
+			std::mutex m_mutex;
+			std::condition_variable m_cvJobAvailable;
+			std::once_flag m_startFlag;
+			bool m_bIsTerminating = false;
+
+			static ThreadPool m_sThreadPool;
+
+			// shared between the caller and helper jobs of one ParallelFor call
+			struct _ParallelForState {
+				std::atomic<std::size_t> uNextChunk = 0;
+				std::size_t uCompletedChunks = 0;
+				std::mutex mutex;
+				std::condition_variable cvCompleted;
+			};
+
+		private:
+			ThreadPool() = default;
+			void _Start();
+			void _WorkerLoop();
+			void _Push(std::function<void()>&& _job);
+
+			template<typename F>
+			static void _RunChunks(_ParallelForState& _state, std::size_t _uCount, std::size_t _uGrain, std::size_t _uChunkCount, F& _fn) {
+				std::size_t uChunk = _state.uNextChunk.fetch_add(1);
+				std::size_t uProcessed = 0;
+				for (; uChunk < _uChunkCount; uChunk = _state.uNextChunk.fetch_add(1)) {
+					const std::size_t uBegin = uChunk * _uGrain;
+					const std::size_t uEnd = uBegin + _uGrain < _uCount ? uBegin + _uGrain : _uCount;
+					_fn(uBegin, uEnd);
+					uProcessed++;
+				}
+
+				if (uProcessed) {
+					std::scoped_lock lock(_state.mutex);
+					_state.uCompletedChunks += uProcessed;
+					if (_state.uCompletedChunks == _uChunkCount)
+						_state.cvCompleted.notify_all();
+				}
+			}
+
+		public:
+			~ThreadPool();
+
+			static ThreadPool& GetInstance() {
+				return m_sThreadPool;
+			}
+
+			// workers are started lazily, the calling thread is not counted
+			std::size_t GetWorkerCount();
+
+			template<typename F>
+			auto Submit(F&& _fn) -> std::future<std::invoke_result_t<F>> {
+				using R = std::invoke_result_t<F>;
+				auto pTask = std::make_shared<std::packaged_task<R()>>(std::forward<F>(_fn));
+				std::future<R> result = pTask->get_future();
+				_Push([pTask]() { (*pTask)(); });
+				return result;
+			}
+
+			// calls _fn(uBegin, uEnd) over [0, _uCount) in chunks of _uGrain elements, blocks until all chunks are processed
+			// the calling thread processes chunks as well, so it is safe to call from inside a worker job
+			template<typename F>
+			void ParallelFor(std::size_t _uCount, std::size_t _uGrain, F&& _fn) {
+				if (!_uCount)
+					return;
+
+				if (!_uGrain)
+					_uGrain = 1;
+
+				const std::size_t uChunkCount = (_uCount + _uGrain - 1) / _uGrain;
+				if (uChunkCount == 1 || !GetWorkerCount()) {
+					_fn(0, _uCount);
+					return;
+				}
+
+				auto pState = std::make_shared<_ParallelForState>();
+				const std::size_t uHelperCount = uChunkCount - 1 < GetWorkerCount() ? uChunkCount - 1 : GetWorkerCount();
+				for (std::size_t i = 0; i < uHelperCount; i++) {
+					_Push([pState, _uCount, _uGrain, uChunkCount, &_fn]() {
+						_RunChunks(*pState, _uCount, _uGrain, uChunkCount, _fn);
+					});
+				}
+
+				_RunChunks(*pState, _uCount, _uGrain, uChunkCount, _fn);
+
+				std::unique_lock lock(pState->mutex);
+				pState->cvCompleted.wait(lock, [&]() { return pState->uCompletedChunks == uChunkCount; });
+			}
+	};
+}
+
+#endif
@@ -0,0 +1,78 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: TransformKernels.h - batched transform math kernels header
+// author: Karl-Mihkel Ott
+
+#ifndef TRANSFORM_KERNELS_H
+#define TRANSFORM_KERNELS_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "deng/Api.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define DENG_X86
+#endif
+
+#ifdef TRANSFORM_KERNELS_CPP
+	#ifdef DENG_X86
+		#include <immintrin.h>
+		#ifdef _MSC_VER
+			#include <intrin.h>
+		#endif
+	#endif
+#endif
+
+namespace DENG {
+
+	enum class SimdInstructionSet {
+		Scalar,
+		SSE41,
+		AVX2
+	};
+
+	// 3x3 matrices in structure of arrays form, element (row, column) of the i-th matrix is arrElements[row * 3 + column][i]
+	struct Matrix3SoA {
+		std::array<float*, 9> arrElements = {};
+	};
+
+	// Euler rotation (in radians) to rotation and normal matrix conversion for N transforms at once.
+	// Rotation matrix is Rx * Ry * Rz, which is the same as expanding qX * qY * qZ quaternion product,
+	// normal matrix is the inverse of the rotation matrix, which for a pure rotation is just its transpose.
+	class DENG_API TransformKernels {
+		private:
+			static void _CalculateRotationsScalar(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+												  std::size_t _uBegin, std::size_t _uEnd, Matrix3SoA& _rotations, Matrix3SoA& _normals);
+#ifdef DENG_X86
+			static void _CalculateRotationsSSE41(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+												 std::size_t _uCount, Matrix3SoA& _rotations, Matrix3SoA& _normals);
+			static void _CalculateRotationsAVX2(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+												std::size_t _uCount, Matrix3SoA& _rotations, Matrix3SoA& _normals);
+#endif
+
+		public:
+			// row major Rx * Ry * Rz of a single transform, scalar reference for the batched kernels and TransformComponent
+			static inline std::array<float, 9> CalculateRotation(float _fX, float _fY, float _fZ) {
+				const float sa = std::sin(_fX), ca = std::cos(_fX);
+				const float sb = std::sin(_fY), cb = std::cos(_fY);
+				const float sc = std::sin(_fZ), cc = std::cos(_fZ);
+
+				return {
+					cb * cc,				-cb * sc,				sb,
+					ca * sc + sa * sb * cc,	ca * cc - sa * sb * sc,	-sa * cb,
+					sa * sc - ca * sb * cc,	sa * cc + ca * sb * sc,	ca * cb
+				};
+			}
+
+			// best instruction set supported by both the build and the running cpu
+			static SimdInstructionSet GetInstructionSet();
+
+			static void CalculateRotations(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ, std::size_t _uCount,
+										   Matrix3SoA& _rotations, Matrix3SoA& _normals, SimdInstructionSet _eInstructionSet = GetInstructionSet());
+	};
+}
+
+#endif
@@ -0,0 +1,81 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanBufferArena.h - Vulkan multi-block device buffer arena class header
+// author: Karl-Mihkel Ott
+
+#ifndef VULKAN_BUFFER_ARENA_H
+#define VULKAN_BUFFER_ARENA_H
+
+#ifdef VULKAN_BUFFER_ARENA_CPP
+    #include <algorithm>
+    #include "deng/ErrorDefinitions.h"
+#endif
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "deng/IRenderer.h"
+#include "deng/GPUMemoryAllocator.h"
+#include "deng/VulkanDeletionQueue.h"
+#include "deng/VulkanHelpers.h"
+#include "deng/VulkanInstanceCreator.h"
+
+// block sizes are kept as multiples of this value, which keeps block local offsets aligned the same way as arena offsets
+#ifndef BUFFER_ARENA_BLOCK_ALIGNMENT
+#define BUFFER_ARENA_BLOCK_ALIGNMENT 256
+#endif
+
+namespace DENG {
+    namespace Vulkan {
+
+        // Device local buffer memory made out of separate buffer blocks, which are laid out one after another in a single offset space.
+        // Arena grows by appending new blocks, existing blocks are never copied or moved, thus allocated offsets stay valid for their whole lifetime.
+        // Blocks that become empty are retired into the deletion queue.
+        class BufferArena {
+            private:
+                struct _Block {
+                    size_t uBaseOffset = 0;
+                    size_t uSize = 0;
+                    size_t uAllocationCount = 0;
+                    // null buffer handle marks a retired block, whose offset range can be reused by a new buffer of the same size
+                    BufferData buffer;
+                    GPUMemoryAllocator allocator;
+                };
+
+                const InstanceCreator* m_pInstanceCreator = nullptr;
+                DeletionQueue& m_deletionQueue;
+                const VkBufferUsageFlags m_bmUsage;
+                const VkDeviceSize m_uDefaultBlockSize;
+
+                std::vector<_Block> m_blocks;
+                size_t m_uArenaSize = 0;
+                size_t m_uUsedSize = 0;
+                size_t m_uHighWaterMark = 0;
+
+            private:
+                void _CreateBlockBuffer(_Block& _block);
+                bool _TryAllocate(_Block& _block, size_t _uSize, size_t _uAlignment, size_t& _uOffset);
+                size_t _FindBlockIndex(size_t _uOffset) const;
+
+            public:
+                BufferArena(const InstanceCreator* _pInstanceCreator, DeletionQueue& _deletionQueue, VkBufferUsageFlags _bmUsage, VkDeviceSize _uDefaultBlockSize = DEFAULT_BUFFER_SIZE);
+                BufferArena(const BufferArena&) = delete;
+                ~BufferArena();
+
+                size_t Allocate(size_t _uSize, size_t _uAlignment);
+                void Free(size_t _uOffset);
+
+                // Finds the buffer block containing arena offset _uOffset, block local offset is written into _uLocalOffset
+                VkBuffer Resolve(size_t _uOffset, VkDeviceSize& _uLocalOffset) const;
+
+                // Statistics over all live blocks, unused space past the last region of a block counts as a free fragment
+                MemoryStatistics GetStatistics() const;
+
+                inline size_t GetBlockCount() const { return m_blocks.size(); }
+                inline size_t GetSize() const { return m_uArenaSize; }
+        };
+    }
+}
+
+#endif
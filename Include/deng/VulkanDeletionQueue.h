@@ -0,0 +1,78 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanDeletionQueue.h - Vulkan frame deferred object deletion queue class header
+// author: Karl-Mihkel Ott
+
+#ifndef VULKAN_DELETION_QUEUE_H
+#define VULKAN_DELETION_QUEUE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "deng/IRenderer.h"
+#include "deng/VulkanHelpers.h"
+
+namespace DENG {
+    namespace Vulkan {
+
+        // Collects Vulkan objects, which are no longer used by the host but might still be referenced by command buffers in flight.
+        // Objects retired during frame N are destroyed at the start of frame N + MAX_FRAMES_IN_FLIGHT + 1,
+        // by which point the frame fence of N has been waited for.
+        class DeletionQueue {
+            private:
+                struct _RetiredObjects {
+                    std::vector<VkBuffer> buffers;
+                    std::vector<VkImage> images;
+                    std::vector<VkImageView> imageViews;
+                    std::vector<VkSampler> samplers;
+                    std::vector<VkPipeline> pipelines;
+                    std::vector<VkPipelineLayout> pipelineLayouts;
+                    std::vector<VkDescriptorPool> descriptorPools;
+                    // memory is freed after all buffers and images that were bound to it are destroyed
+                    std::vector<VkDeviceMemory> memory;
+                };
+
+                VkDevice m_hDevice = VK_NULL_HANDLE;
+                std::array<_RetiredObjects, MAX_FRAMES_IN_FLIGHT + 1> m_frames;
+                uint64_t m_uFrameCounter = 0;
+
+            private:
+                void _DestroyObjects(_RetiredObjects& _objects);
+
+                inline _RetiredObjects& _GetCurrentFrame() {
+                    return m_frames[m_uFrameCounter % m_frames.size()];
+                }
+
+            public:
+                DeletionQueue(VkDevice _hDevice);
+                DeletionQueue(const DeletionQueue&) = delete;
+                // destroys every retired object, device must be idle
+                ~DeletionQueue();
+
+                inline void RetireBuffer(const BufferData& _buffer) {
+                    _GetCurrentFrame().buffers.push_back(_buffer.hBuffer);
+                    _GetCurrentFrame().memory.push_back(_buffer.hMemory);
+                }
+
+                inline void RetireTexture(const TextureData& _texture) {
+                    _GetCurrentFrame().samplers.push_back(_texture.hSampler);
+                    _GetCurrentFrame().imageViews.push_back(_texture.hImageView);
+                    _GetCurrentFrame().images.push_back(_texture.hImage);
+                    _GetCurrentFrame().memory.push_back(_texture.hMemory);
+                }
+
+                inline void RetirePipeline(VkPipeline _hPipeline) { _GetCurrentFrame().pipelines.push_back(_hPipeline); }
+                inline void RetirePipelineLayout(VkPipelineLayout _hPipelineLayout) { _GetCurrentFrame().pipelineLayouts.push_back(_hPipelineLayout); }
+                inline void RetireDescriptorPool(VkDescriptorPool _hDescriptorPool) { _GetCurrentFrame().descriptorPools.push_back(_hDescriptorPool); }
+
+                // Must be called once per rendered frame before any command buffer recording, destroys objects that are no longer in flight
+                void NextFrame();
+
+                inline uint64_t GetFrameCounter() const { return m_uFrameCounter; }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanFrameAllocator.h - Vulkan per-frame linear buffer allocator class header
+// author: Karl-Mihkel Ott
+
+#ifndef VULKAN_FRAME_ALLOCATOR_H
+#define VULKAN_FRAME_ALLOCATOR_H
+
+#ifdef VULKAN_FRAME_ALLOCATOR_CPP
+    #include "deng/ErrorDefinitions.h"
+#endif
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "deng/IRenderer.h"
+#include "deng/VulkanBufferArena.h"
+
+#ifndef DEFAULT_FRAME_ALLOCATOR_SLICE_SIZE
+#define DEFAULT_FRAME_ALLOCATOR_SLICE_SIZE (1 << 20)
+#endif
+
+namespace DENG {
+    namespace Vulkan {
+
+        // Bump allocator over a single main buffer arena region, which is split into MAX_FRAMES_IN_FLIGHT + 1 slices.
+        // Each frame allocates linearly from its own slice and the slice is reset when it is used again MAX_FRAMES_IN_FLIGHT + 1 frames later,
+        // by which point the frame fence that last read the slice has been waited for. Nothing is ever freed individually.
+        // Requests that overflow the slice fall back to the arena and are freed on reset, the slice size is grown to fit the next frame.
+        class FrameAllocator {
+            private:
+                struct _Slice {
+                    size_t uUsedSize = 0;
+                    // arena regions which are freed once the slice is reset
+                    std::vector<size_t> overflowRegions;
+                };
+
+                BufferArena& m_bufferArena;
+                std::array<_Slice, MAX_FRAMES_IN_FLIGHT + 1> m_slices;
+
+                size_t m_uRegionOffset = 0;
+                size_t m_uSliceSize = 0;
+                // bytes requested during the current frame, including overflowing requests
+                size_t m_uRequestedSize = 0;
+                uint64_t m_uFrameCounter = 0;
+
+            private:
+                inline _Slice& _GetCurrentSlice() { return m_slices[m_uFrameCounter % m_slices.size()]; }
+                void _AllocateRegion(size_t _uSliceSize);
+
+            public:
+                FrameAllocator(BufferArena& _bufferArena, size_t _uSliceSize = DEFAULT_FRAME_ALLOCATOR_SLICE_SIZE);
+                FrameAllocator(const FrameAllocator&) = delete;
+                ~FrameAllocator();
+
+                // Returns an arena offset, which stays valid until the end of the current frame
+                size_t Allocate(size_t _uSize, size_t _uAlignment);
+                void NextFrame();
+
+                inline size_t GetSliceSize() const { return m_uSliceSize; }
+        };
+    }
+}
+
+#endif
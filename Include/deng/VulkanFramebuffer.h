@@ -16,6 +16,7 @@
     #include <functional>
     #include <sstream>
     #include <iomanip>
+    #include <chrono>
 #ifdef __DEBUG
     #include <iostream>
 #endif
@@ -39,23 +40,46 @@
     #include "deng/VulkanInstanceCreator.h"
     #include "deng/VulkanSwapchainCreator.h"
     #include "deng/VulkanPipelineCreator.h"
+    #include "deng/ThreadPool.h"
 #endif
 
+#include <future>
+#include <unordered_set>
+
+#include "deng/VulkanBufferArena.h"
+#include "deng/VulkanDeletionQueue.h"
+#include "deng/VulkanStagingRing.h"
+
 namespace DENG {
     namespace Vulkan {
 
         class Framebuffer : public IFramebuffer {
             private:
+                struct _DeferredPipelineCreator {
+                    const IShader* pShader = nullptr;
+                    VkDescriptorSetLayout hShaderDescriptorSetLayout = VK_NULL_HANDLE;
+                    VkDescriptorSetLayout hMaterialDescriptorSetLayout = VK_NULL_HANDLE;
+                };
+
                 const InstanceCreator* m_pInstanceCreator = nullptr;
                 SwapchainCreator* m_pSwapchainCreator = nullptr;
 
-                VkBuffer& m_hMainBuffer;
+                const BufferArena& m_mainBufferArena;
+                StagingRing* m_pStagingRing = nullptr;
                 VkSampleCountFlagBits m_uSampleCountBits;
                 
                 Vulkan::TextureData m_framebufferImageHandles;
                 Vulkan::TextureData m_depthImageHandles;
 
                 std::unordered_map<cvar::hash_t, Vulkan::PipelineCreator, cvar::NoHash> m_pipelineCreators;
+                // pipelines, which are being created on the thread pool
+                std::unordered_map<cvar::hash_t, std::future<Vulkan::PipelineCreator>, cvar::NoHash> m_pendingPipelineCreators;
+                // pipelines, whose shaders are still being compiled, creation jobs are submitted once SPIR-V is ready
+                std::unordered_map<cvar::hash_t, _DeferredPipelineCreator, cvar::NoHash> m_deferredPipelineCreators;
+                // pipelines, whose creation failed, are reported once and not requested again until they are destroyed
+                std::unordered_set<cvar::hash_t, cvar::NoHash> m_failedPipelines;
+                // fallback shader hash -> keys of its pipelines built with layouts of the requesting shaders
+                std::unordered_map<cvar::hash_t, std::unordered_set<cvar::hash_t, cvar::NoHash>, cvar::NoHash> m_fallbackPipelineKeys;
 
                 VkCommandPool m_hCommandPool;
                 std::vector<VkCommandBuffer> m_commandBuffers;
@@ -78,20 +102,53 @@ namespace DENG {
                 void _AllocateCommandBuffers();
                 void _RecreateSwapchain();
                 void _DestroyFramebuffer();
+                // returns nullptr while the pipeline is being created or if its creation failed, creation is started by the first call
+                PipelineCreator* _GetPipelineCreator(
+                    cvar::hash_t _hshPipeline,
+                    const IShader* _pShader,
+                    VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout);
+                void _SubmitPipelineCreator(
+                    cvar::hash_t _hshPipeline,
+                    const IShader* _pShader,
+                    VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout);
+                // fallback pipelines are built with descriptor set layouts of the requesting shader, thus every layout pair gets its own pipeline
+                cvar::hash_t _GetFallbackPipelineKey(
+                    cvar::hash_t _hshFallbackShader,
+                    VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout);
+                void _RetirePipeline(cvar::hash_t _hshPipeline, DeletionQueue& _deletionQueue);
 
             public:
                 Framebuffer(
                     const InstanceCreator* _pInstanceCreator,
-                    VkBuffer& _hMainBuffer,
+                    const BufferArena& _mainBufferArena,
                     VkSampleCountFlagBits _uSampleCountBits,
                     TRS::Point2D<uint32_t> _extent,
-                    bool _bIsSwapchain = false);
+                    bool _bIsSwapchain = false,
+                    StagingRing* _pStagingRing = nullptr);
                 Framebuffer(Framebuffer &&_fb) noexcept = default;
                 ~Framebuffer();
 
                 void RecreateFramebuffer(uint32_t _uWidth, uint32_t _uHeight);
+                // pipeline objects are retired into the deletion queue, since draw commands in flight might still use them,
+                // fallback pipelines built from the shader are retired as well
+                void DestroyPipeline(cvar::hash_t _hshShader, DeletionQueue& _deletionQueue);
+
+                // Starts creating the shader pipeline on the thread pool, unless it exists, is already being created or has failed.
+                // If shader modules are still being compiled the creation job is submitted by a later draw or wait call,
+                // so pipeline jobs never block workers on compilation jobs.
+                void RequestPipelineCreator(
+                    cvar::hash_t _hshShader,
+                    const IShader* _pShader,
+                    VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout);
+                // blocks until all requested pipelines are created, failed pipelines are reported once
+                void WaitForPipelineCreators();
 
                 virtual void BeginCommandBufferRecording(TRS::Vector4<float> _vClearColor) override;
+                // While the shader pipeline is being created the fallback shader pipeline is used, if neither is ready the draw is skipped
                 void Draw(
                     cvar::hash_t _hshMesh, 
                     cvar::hash_t _hshShader, 
@@ -100,31 +157,11 @@ namespace DENG {
                     VkDescriptorSet _hShaderDescriptorSet, 
                     VkDescriptorSet _hMaterialDescriptorSet,
                     VkDescriptorSetLayout _hShaderDescriptorSetLayout,
-                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout);
+                    VkDescriptorSetLayout _hMaterialDescriptorSetLayout,
+                    cvar::hash_t _hshFallbackShader = 0);
                 virtual void EndCommandBufferRecording() override;
                 virtual void RenderToFramebuffer() override;
 
-                inline void UpdatePipelineCreator(cvar::hash_t _hshShader, VkDescriptorSetLayout _hShaderDescriptorSetLayout, VkDescriptorSetLayout _hMaterialDescriptorSetLayout) {
-                    if (m_pipelineCreators.find(_hshShader) == m_pipelineCreators.end()) {
-                        ResourceManager& resourceManager = ResourceManager::GetInstance();
-                        auto pShader = resourceManager.GetShader(_hshShader);
-                        DENG_ASSERT(pShader);
-
-                        m_pipelineCreators.emplace(
-                            std::piecewise_construct,
-                            std::forward_as_tuple(_hshShader),
-                            std::forward_as_tuple(
-                                m_pInstanceCreator->GetDevice(),
-                                m_hRenderpass,
-                                _hShaderDescriptorSetLayout,
-                                _hMaterialDescriptorSetLayout,
-                                m_uSampleCountBits,
-                                m_pInstanceCreator->GetPhysicalDeviceInformation(),
-                                pShader
-                            ));
-                    }
-                }
-
                 inline uint32_t GetCurrentFrameIndex() {
                     return m_uCurrentFrameIndex;
                 }
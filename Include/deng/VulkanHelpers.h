@@ -8,6 +8,7 @@
 #define VULKAN_HELPERS_H
 
 #ifdef VULKAN_HELPERS_CPP
+    #include <algorithm>
     #include "deng/ErrorDefinitions.h"
 #endif
 
@@ -36,6 +37,7 @@ namespace DENG {
 
             uint32_t uMinimalUniformBufferAlignment = 0;
             float fMaxSamplerAnisotropy = 0.f;
+            bool bTextureCompressionBC = false;
 
             PhysicalDeviceType eDeviceType = PhysicalDeviceType::OTHER;
         };
@@ -44,6 +46,8 @@ namespace DENG {
             VkBuffer hBuffer = VK_NULL_HANDLE;
             VkDeviceMemory hMemory = VK_NULL_HANDLE;
             VkDeviceSize uSize = 0;
+            // host visible buffers stay mapped for their whole lifetime, null for device local buffers
+            char* pMappedMemory = nullptr;
         };
 
 
@@ -109,8 +113,39 @@ namespace DENG {
             uint32_t _width, 
             uint32_t _height,
             uint32_t _array_count);
+        // Copies a block compressed image with all of its mip levels, buffer data is expected to be layer major
+        // with mip levels of each layer stored from largest to smallest
+        void _CopyBufferToImageMips(
+            VkDevice _dev,
+            VkCommandPool _cmd_pool,
+            VkQueue _graphics_queue,
+            VkBuffer _src,
+            VkImage _dst,
+            uint32_t _width,
+            uint32_t _height,
+            uint32_t _mip_l,
+            uint32_t _array_count,
+            VkDeviceSize _block_size);
         VkSampler _CreateTextureSampler(VkDevice _dev, float _max_sampler_anisotropy, uint32_t _mip_levels);
 
+        // mipmaps are generated with linear filtered blits, which not every format supports
+        bool _IsLinearBlitSupported(VkPhysicalDevice _gpu, VkFormat _format);
+        // Expects all mip levels to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level 0 containing image data,
+        // every level is left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        void _GenerateMipmaps(
+            VkDevice _dev,
+            VkCommandPool _cmd_pool,
+            VkQueue _graphics_q,
+            VkImage _img,
+            uint32_t _width,
+            uint32_t _height,
+            uint32_t _mip_l,
+            uint32_t _array_count);
+
+        // creates a host visible and coherent buffer, which is mapped until _DestroyMappedBuffer() is called
+        BufferData _CreateMappedBuffer(VkDevice _dev, VkPhysicalDevice _gpu, VkDeviceSize _size, VkBufferUsageFlags _flags);
+        void _DestroyMappedBuffer(VkDevice _dev, BufferData& _buffer);
+
         void _CopyToBufferMemory(VkDevice _dev, VkDeviceSize _size, const void *_src, VkDeviceMemory _dst, VkDeviceSize _offset);
         // using malloc
         void *_CopyToDeviceMemory(VkDevice _dev, VkDeviceSize _size, VkDeviceMemory _src, VkDeviceSize _offset);
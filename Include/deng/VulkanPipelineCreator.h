@@ -78,6 +78,11 @@ namespace DENG {
                 ~PipelineCreator() noexcept;
 
                 void DestroyPipelineData();
+                // pipeline and its layout are no longer destroyed by this object, caller takes over their ownership
+                inline void ReleasePipelineHandles() {
+                    m_hPipeline = VK_NULL_HANDLE;
+                    m_hPipelineLayout = VK_NULL_HANDLE;
+                }
                 
                 inline VkPipelineCache GetPipelineCache() { return m_hPipelineCache; }
                 inline VkPipelineLayout GetPipelineLayout() { return m_hPipelineLayout; }
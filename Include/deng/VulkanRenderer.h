@@ -32,6 +32,7 @@
     #include "deng/Missing.h"
     #include "deng/RenderResources.h"
     #include "deng/MissingTextureBuilder.h"
+    #include "deng/TextureCooker.h"
 
     #define CALC_MIPLVL(_x, _y) (static_cast<uint32_t>(std::floor(std::log2(std::max(static_cast<double>(_x), static_cast<double>(_y))))))
 #endif
@@ -48,6 +49,10 @@
 #include "deng/VulkanSwapchainCreator.h"
 #include "deng/VulkanPipelineCreator.h"
 #include "deng/VulkanFramebuffer.h"
+#include "deng/VulkanBufferArena.h"
+#include "deng/VulkanDeletionQueue.h"
+#include "deng/VulkanFrameAllocator.h"
+#include "deng/VulkanStagingRing.h"
 #include "deng/ResourceEvents.h"
 
 
@@ -58,11 +63,17 @@ namespace DENG {
             const VkSampleCountFlagBits m_uSampleCountBits = VK_SAMPLE_COUNT_1_BIT;
 
             Vulkan::InstanceCreator* m_pInstanceCreator = nullptr;
-            std::unordered_map<cvar::hash_t, Vulkan::PipelineCreator, cvar::NoHash> m_pipelineCreators;
             std::unordered_map<cvar::hash_t, Vulkan::TextureData, cvar::NoHash> m_textureHandles;
 
-            Vulkan::BufferData m_mainBuffer;
+            // objects that are destroyed once frames in flight no longer use them
+            Vulkan::DeletionQueue* m_pDeletionQueue = nullptr;
+            // device local vertex, index and uniform memory
+            Vulkan::BufferArena* m_pMainBufferArena = nullptr;
+            // transient main buffer memory, which is valid only for the frame it was allocated in
+            Vulkan::FrameAllocator* m_pFrameAllocator = nullptr;
+            // persistently mapped, used for texture uploads
             Vulkan::BufferData m_stagingBuffer;
+            Vulkan::StagingRing* m_pStagingRing = nullptr;
 
             VkDescriptorPool m_hMainDescriptorPool = VK_NULL_HANDLE;
             uint32_t m_uDescriptorPoolUsage = 0;
@@ -72,10 +83,11 @@ namespace DENG {
 
             std::unordered_map<size_t, VkDescriptorSetLayout> m_materialDescriptorSetLayouts;
             std::unordered_map<cvar::hash_t, std::array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT>, cvar::NoHash> m_materialDescriptors;
+            // material -> bitmask of frame descriptor sets already rewritten with loaded textures
+            std::unordered_map<cvar::hash_t, uint32_t, cvar::NoHash> m_placeholderMaterialDescriptors;
             std::unordered_map<cvar::hash_t, bool, cvar::NoHash> m_shaderDescriptorUpdateTable;
 
             std::vector<VkDescriptorPool> m_fullDescriptorPools;
-            std::vector<Vulkan::BufferData> m_deletedBuffers;
 
             uint32_t m_uResizedViewportWidth = 0;
             uint32_t m_uResizedViewportHeight = 0;
@@ -88,10 +100,62 @@ namespace DENG {
 
         private:
             void _CreateApiImageHandles(cvar::hash_t _id);
-            void _CheckAndReallocateBufferResources(size_t _uSize, size_t _uOffset);
+            void _CheckAndReallocateStagingBuffer(size_t _uSize);
             void _CreateMaterialDescriptorSetLayout(size_t _uCount);
             void _CreateShaderDescriptorSetLayout(VkDescriptorSetLayout* _pDescriptorSetLayout, cvar::hash_t _hshShader);
             void _AllocateShaderDescriptors(cvar::hash_t _hshShader);
+            // creates descriptor set layouts, which shader pipelines are created with, and allocates shader descriptor sets
+            void _CreateShaderDescriptors(cvar::hash_t _hshShader, const IShader* _pShader);
+
+            // writes material samplers into descriptor set, textures that are still loading are substituted with the missing texture
+            // returns true if every sampler got its own texture
+            template<typename T, size_t N>
+            bool _WriteMaterialDescriptorSet(VkDescriptorSet _hDescriptorSet, const Material<T, N>& _material) {
+                ResourceManager& resourceManager = ResourceManager::GetInstance();
+                auto missing2DTextureHandles = m_textureHandles.find(m_hshMissing2DTexture);
+                DENG_ASSERT(missing2DTextureHandles != m_textureHandles.end());
+
+                bool bIsComplete = true;
+                std::array<VkDescriptorImageInfo, N> descriptorImageInfos = {};
+                for (size_t i = 0; i < N; i++) {
+                    auto textureHandles = m_textureHandles.find(_material.textures[i]);
+                    
+                    // create api texture handles if necessary
+                    if (textureHandles == m_textureHandles.end()) {
+                        const Texture* pTexture = resourceManager.GetTexture(_material.textures[i]);
+                        if (pTexture && pTexture->pRGBAData) {
+                            _CreateApiImageHandles(_material.textures[i]);
+                            textureHandles = m_textureHandles.find(_material.textures[i]);
+                        }
+                        else {
+                            textureHandles = missing2DTextureHandles;
+                            bIsComplete = false;
+                        }
+                    }
+
+                    descriptorImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                    descriptorImageInfos[i].imageView = textureHandles->second.hImageView;
+                    descriptorImageInfos[i].sampler = textureHandles->second.hSampler;
+                }
+
+                std::array<VkWriteDescriptorSet, N> writeDescriptors = {};
+                for (size_t i = 0; i < N; i++) {
+                    writeDescriptors[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    writeDescriptors[i].dstSet = _hDescriptorSet;
+                    writeDescriptors[i].dstBinding = static_cast<uint32_t>(i);
+                    writeDescriptors[i].descriptorCount = 1;
+                    writeDescriptors[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writeDescriptors[i].pImageInfo = &descriptorImageInfos[i];
+                }
+
+                vkUpdateDescriptorSets(
+                    m_pInstanceCreator->GetDevice(),
+                    static_cast<uint32_t>(writeDescriptors.size()),
+                    writeDescriptors.data(),
+                    0, nullptr);
+
+                return bIsComplete;
+            }
 
             template<typename T, size_t N>
             void _AllocateMaterialDescriptors(cvar::hash_t _hshMaterial, const Material<T, N>& _material) {
@@ -105,12 +169,6 @@ namespace DENG {
                     _CreateMaterialDescriptorSetLayout(N);
                 }
 
-                // create api texture handles if necessary
-                for (auto it = _material.textures.begin(); it != _material.textures.end(); it++) {
-                    if (m_textureHandles.find(*it) == m_textureHandles.end())
-                        _CreateApiImageHandles(*it);
-                }
-
                 std::array<VkDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT> descriptorSetLayouts = {};
                 for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
                     descriptorSetLayouts[i] = m_materialDescriptorSetLayouts[N];
@@ -124,32 +182,31 @@ namespace DENG {
                 if (vkAllocateDescriptorSets(m_pInstanceCreator->GetDevice(), &descriptorSetAllocateInfo, descriptorSets.data()))
                     throw RendererException("vkAllocateDescriptorSets() failed to allocate material descriptor sets");
             
-                std::array<VkDescriptorImageInfo, N> descriptorImageInfos = {};
-                for (size_t i = 0; i < N; i++) {
-                    Vulkan::TextureData& texture = m_textureHandles[_material.textures[i]];
+                bool bIsComplete = true;
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+                    bIsComplete = _WriteMaterialDescriptorSet<T, N>(descriptorSets[i], _material) && bIsComplete;
 
-                    descriptorImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    descriptorImageInfos[i].imageView = texture.hImageView;
-                    descriptorImageInfos[i].sampler = texture.hSampler;
-                }
+                if (!bIsComplete)
+                    m_placeholderMaterialDescriptors[_hshMaterial] = 0;
+            }
 
-                std::array<VkWriteDescriptorSet, N* MAX_FRAMES_IN_FLIGHT> writeDescriptors = {};
-                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                    for (size_t j = 0; j < N; j++) {
-                        writeDescriptors[i * N + j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                        writeDescriptors[i * N + j].dstSet = descriptorSets[i];
-                        writeDescriptors[i * N + j].dstBinding = static_cast<uint32_t>(j);
-                        writeDescriptors[i * N + j].descriptorCount = 1;
-                        writeDescriptors[i * N + j].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                        writeDescriptors[i * N + j].pImageInfo = &descriptorImageInfos[j];
-                    }
+            // rewrites current frame's descriptor set of a material that was created with placeholder textures, once its textures are loaded
+            template<typename T, size_t N>
+            void _RefreshPlaceholderMaterialDescriptors(cvar::hash_t _hshMaterial, const Material<T, N>& _material, uint32_t _uFrameIndex) {
+                ResourceManager& resourceManager = ResourceManager::GetInstance();
+                for (size_t i = 0; i < N; i++) {
+                    if (resourceManager.IsTexturePending(_material.textures[i]))
+                        return;
                 }
 
-                vkUpdateDescriptorSets(
-                    m_pInstanceCreator->GetDevice(),
-                    static_cast<uint32_t>(writeDescriptors.size()),
-                    writeDescriptors.data(),
-                    0, nullptr);
+                auto it = m_placeholderMaterialDescriptors.find(_hshMaterial);
+                if (it->second & (1u << _uFrameIndex))
+                    return;
+
+                _WriteMaterialDescriptorSet<T, N>(m_materialDescriptors[_hshMaterial][_uFrameIndex], _material);
+                it->second |= (1u << _uFrameIndex);
+                if (it->second == (1u << MAX_FRAMES_IN_FLIGHT) - 1)
+                    m_placeholderMaterialDescriptors.erase(it);
             }
             
             void _UpdateShaderDescriptorSet(VkDescriptorSet _hDescriptorSet, const IShader* _pShader);
@@ -164,11 +221,16 @@ namespace DENG {
             virtual void DeleteTextureHandles() override;
             virtual void UpdateViewport(uint32_t _uWidth, uint32_t _uHeight) override;
             virtual void DestroyPipeline(cvar::hash_t _hshShader) override;
+            virtual void PrecompilePipelines(IFramebuffer* _pFramebuffer = nullptr) override;
+            virtual bool IsTextureCompressionSupported() const override;
             virtual IFramebuffer* CreateFramebuffer(uint32_t _uWidth, uint32_t _uHeight) override;
             virtual IFramebuffer* CreateContext(IWindowContext* _pWindow) override;
             virtual size_t AllocateMemory(size_t _uSize, BufferDataType _eType) override;
             virtual void DeallocateMemory(size_t _uOffset) override;
+            virtual size_t AllocateFrameMemory(size_t _uSize, BufferDataType _eType) override;
+            virtual void* MapBufferRegion(size_t _uSize, size_t _uOffset) override;
             virtual void UpdateBuffer(const void* _pData, size_t _uSize, size_t _uOffset) override;
+            virtual void UpdateBufferRegions(const BufferRegion* _pRegions, size_t _uCount) override;
             virtual bool SetupFrame() override;
             virtual void DrawInstance(
                 cvar::hash_t _hshMesh,
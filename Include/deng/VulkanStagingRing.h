@@ -0,0 +1,109 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanStagingRing.h - Vulkan per frame staging ring class header
+// author: Karl-Mihkel Ott
+
+#ifndef VULKAN_STAGING_RING_H
+#define VULKAN_STAGING_RING_H
+
+#ifdef VULKAN_STAGING_RING_CPP
+    #include "deng/Exceptions.h"
+    #include "deng/ErrorDefinitions.h"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "deng/IRenderer.h"
+#include "deng/VulkanBufferArena.h"
+#include "deng/VulkanHelpers.h"
+#include "deng/VulkanInstanceCreator.h"
+
+#ifndef STAGING_RING_SEGMENT_SIZE
+#define STAGING_RING_SEGMENT_SIZE (1 << 22)
+#endif
+
+#ifndef STAGING_RING_ALIGNMENT
+#define STAGING_RING_ALIGNMENT 16
+#endif
+
+namespace DENG {
+    namespace Vulkan {
+
+        // Persistently mapped staging memory split into segments, one of which takes the uploads of the current frame.
+        // Uploads are sub-allocated from the segment and queued as copy regions in arena offsets, which are recorded into
+        // the segment command buffer and submitted in the same batch right before frame's draw commands. Uploads that do not fit
+        // into the segment spill into additional mapped buffers, which are kept for following frames while they are in use.
+        // Segment is reused once its fence has signaled, if it has not the ring grows by one segment instead of waiting.
+        class StagingRing {
+            private:
+                struct _CopyRegion {
+                    VkBuffer hSrcBuffer = VK_NULL_HANDLE;
+                    VkBufferCopy copy = {};
+                };
+
+                struct _Segment {
+                    BufferData buffer;
+                    VkDeviceSize uUsed = 0;
+                    VkCommandBuffer hCommandBuffer = VK_NULL_HANDLE;
+                    VkFence hFence = VK_NULL_HANDLE;
+                    // copy regions in upload order
+                    std::vector<_CopyRegion> copyRegions;
+                    std::vector<BufferData> spillBuffers;
+                    size_t uSpillBufferCount = 0;
+                    VkDeviceSize uSpillUsed = 0;
+                };
+
+                const InstanceCreator* m_pInstanceCreator = nullptr;
+                const BufferArena& m_dstArena;
+                const VkDeviceSize m_uSegmentSize;
+
+                VkCommandPool m_hCommandPool = VK_NULL_HANDLE;
+
+                std::vector<_Segment> m_segments;
+                uint32_t m_uSegmentIndex = 0;
+                std::vector<std::pair<VkDeviceSize, VkDeviceSize>> m_sortedDstRanges;
+                std::vector<VkBufferCopy> m_copyBatch;
+
+                UploadStatistics m_statistics;
+
+            private:
+                _Segment _CreateSegment();
+                void _DestroySegment(_Segment& _segment);
+                // spill buffers, which were not used since the previous release, are destroyed
+                void _ReleaseSegment(_Segment& _segment);
+                // returns staging buffer and offset of _uSize bytes, which are taken from a spill buffer if the segment is full
+                std::pair<const BufferData*, VkDeviceSize> _Reserve(_Segment& _segment, VkDeviceSize _uSize);
+                bool _HasOverlappingDstRegions(const _Segment& _segment);
+                void _PushCopyRegion(_Segment& _segment, VkBuffer _hSrcBuffer, VkDeviceSize _uSrcOffset, VkDeviceSize _uDstOffset, VkDeviceSize _uSize);
+                void _RecordCopies(_Segment& _segment);
+
+            public:
+                StagingRing(const InstanceCreator* _pInstanceCreator, const BufferArena& _dstArena, VkDeviceSize _uSegmentSize = STAGING_RING_SEGMENT_SIZE);
+                StagingRing(const StagingRing&) = delete;
+                ~StagingRing();
+
+                // Returns mapped memory of _uSize bytes, which is copied into destination arena at _uDstOffset with the next frame.
+                // Memory must be written before the next Flush() call.
+                void* Allocate(VkDeviceSize _uSize, VkDeviceSize _uDstOffset);
+                // Copies all regions tightly packed into the current segment, each region becomes a copy region of the same copy command
+                void WriteRegions(const BufferRegion* _pRegions, size_t _uCount);
+
+                // Records queued copies and returns the command buffer, which has to be submitted right before the frame command buffer
+                // of the same batch. VK_NULL_HANDLE is returned if there is nothing to copy.
+                VkCommandBuffer Flush();
+                // Fences the flushed segment behind the batch submitted to _hQueue and moves on to the next segment
+                void EndSegment(VkQueue _hQueue);
+
+                inline VkDeviceSize GetSegmentSize() const { return m_uSegmentSize; }
+                inline UploadStatistics& GetStatistics() { return m_statistics; }
+        };
+    }
+}
+
+#endif
@@ -25,8 +25,16 @@ namespace DENG {
 	void App::Run() {
 		DENG_ASSERT(m_pWindowContext);
 
+		ResourceManager& resourceManager = ResourceManager::GetInstance();
+		EventManager& eventManager = EventManager::GetInstance();
 		while (m_pWindowContext->IsAlive()) {
+			if (eventManager.IsProfiling())
+				eventManager.GetProfiler().NextFrame();
+
 			m_pWindowContext->Update();
+			// events posted during the previous frame and by worker threads
+			eventManager.DispatchQueuedEvents();
+			resourceManager.PublishLoadedTextures();
 
 			try {
 				bool bSuccessBit = m_pRenderer->SetupFrame();
@@ -0,0 +1,88 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: EventProfiler.cpp - event dispatch profiler class implementation
+// author: Karl-Mihkel Ott
+
+#define EVENT_PROFILER_CPP
+#include "deng/EventProfiler.h"
+
+namespace DENG {
+
+	void EventProfiler::RecordDispatch(cvar::hash_t _hshEventType, const char* _szName, uint32_t _uPropagationSteps, uint32_t _uListenerInvocationCount, uint64_t _uNanoseconds) {
+		std::scoped_lock lock(m_mutex);
+		EventTypeProfile& profile = m_eventTypeProfiles[_hshEventType];
+		profile.hshEventType = _hshEventType;
+		profile.szName = _szName;
+		profile.uPropagationSteps = _uPropagationSteps;
+		profile.uFrameDispatchCount++;
+		profile.uTotalDispatchCount++;
+		profile.uListenerInvocationCount += _uListenerInvocationCount;
+		profile.uTotalNanoseconds += _uNanoseconds;
+	}
+
+
+	void EventProfiler::RecordListener(cvar::hash_t _hshEventType, const char* _szEventName, const void* _pInstance, uint64_t _uNanoseconds) {
+		size_t uCostClass = 0;
+		for (uint64_t uNanoseconds = _uNanoseconds; uNanoseconds >>= 1;)
+			uCostClass++;
+		uCostClass = std::min(uCostClass, static_cast<size_t>(EVENT_PROFILE_HISTOGRAM_SIZE - 1));
+
+		std::scoped_lock lock(m_mutex);
+		ListenerProfile& profile = m_listenerProfiles[std::make_pair(_hshEventType, _pInstance)];
+		profile.hshEventType = _hshEventType;
+		profile.szEventName = _szEventName;
+		profile.pInstance = _pInstance;
+		profile.uInvocationCount++;
+		profile.uTotalNanoseconds += _uNanoseconds;
+		profile.uMaxNanoseconds = std::max(profile.uMaxNanoseconds, _uNanoseconds);
+		profile.costHistogram[uCostClass]++;
+	}
+
+
+	void EventProfiler::NextFrame() {
+		std::scoped_lock lock(m_mutex);
+		for (auto it = m_eventTypeProfiles.begin(); it != m_eventTypeProfiles.end(); it++) {
+			it->second.uLastFrameDispatchCount = it->second.uFrameDispatchCount;
+			it->second.uFrameDispatchCount = 0;
+		}
+	}
+
+
+	void EventProfiler::Reset() {
+		std::scoped_lock lock(m_mutex);
+		m_eventTypeProfiles.clear();
+		m_listenerProfiles.clear();
+	}
+
+
+	std::vector<EventTypeProfile> EventProfiler::GetEventTypeProfiles() const {
+		std::vector<EventTypeProfile> profiles;
+		{
+			std::scoped_lock lock(m_mutex);
+			profiles.reserve(m_eventTypeProfiles.size());
+			for (auto it = m_eventTypeProfiles.begin(); it != m_eventTypeProfiles.end(); it++)
+				profiles.push_back(it->second);
+		}
+
+		std::sort(profiles.begin(), profiles.end(), [](const EventTypeProfile& _lhs, const EventTypeProfile& _rhs) {
+			return _lhs.uLastFrameDispatchCount > _rhs.uLastFrameDispatchCount;
+		});
+		return profiles;
+	}
+
+
+	std::vector<ListenerProfile> EventProfiler::GetListenerProfiles() const {
+		std::vector<ListenerProfile> profiles;
+		{
+			std::scoped_lock lock(m_mutex);
+			profiles.reserve(m_listenerProfiles.size());
+			for (auto it = m_listenerProfiles.begin(); it != m_listenerProfiles.end(); it++)
+				profiles.push_back(it->second);
+		}
+
+		std::sort(profiles.begin(), profiles.end(), [](const ListenerProfile& _lhs, const ListenerProfile& _rhs) {
+			return _lhs.uTotalNanoseconds > _rhs.uTotalNanoseconds;
+		});
+		return profiles;
+	}
+}
@@ -42,279 +42,326 @@ namespace DENG {
 	}
 
 
-	vector<uint32_t>&& FileSystemShader::_CompileVertexShaderToSpirv() const {
-		shaderc::Compiler compiler;
-		shaderc::CompileOptions options;
-		options.SetOptimizationLevel(shaderc_optimization_level_performance);
-
-		for (auto it = m_vertexShaderMacros.begin(); it != m_vertexShaderMacros.end(); it++) {
-			if (it->second != "")
-				options.AddMacroDefinition(it->first, it->second);
-			else options.AddMacroDefinition(it->first);
+	FileSystemShader::~FileSystemShader() {
+		// jobs reference the program files manager of this shader
+		std::scoped_lock lock(m_spirvJobMutex);
+		for (auto& job : m_spirvJobs) {
+			if (job.valid())
+				job.wait();
 		}
+	}
 
-		const string csVertexShaderSourcePath =
-			string{ m_csVertexShaderSourcePath } + '/' + m_csVertexShaderSourceName + ".vert";
-		
-		vector<char> sSourceCode = m_programFilesManager.GetProgramFileContent(csVertexShaderSourcePath);
-		shaderc::CompilationResult module = compiler.CompileGlslToSpv(
-			sSourceCode.data(), 
-			sSourceCode.size(), 
-			shaderc_vertex_shader, 
-			fs::path(csVertexShaderSourcePath).filename().u8string().c_str(),
-			options);
 
-		if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
-			throw ShaderException(module.GetErrorMessage());
-			return move(vector<uint32_t>());
-		}
+	static shaderc_shader_kind _GetShaderKind(ShaderStageBits _bmStage) {
+		switch (_bmStage) {
+			case ShaderStageBit_Vertex:
+				return shaderc_vertex_shader;
 
-		vector<uint32_t> spirv(module.cbegin(), module.cend());
-	
-		try {
-			m_programFilesManager.WriteProgramFile(
-				(const char*)spirv.data(),
-				spirv.size() * sizeof(uint32_t),
-				string{ m_csVertexShaderSpirvPath } + '/' + m_csVertexShaderSpirvName + ".vert.spv");
-		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), ErrorSeverity::WARNING);
-		}
+			case ShaderStageBit_Geometry:
+				return shaderc_geometry_shader;
 
-		return move(spirv);
+			default:
+				return shaderc_fragment_shader;
+		}
 	}
 
 
-	vector<uint32_t>&& FileSystemShader::_CompileGeometryShaderToSpirv() const {
-		shaderc::Compiler compiler;
+	// everything set here, besides macro definitions, must be reflected in the options tag of the cache key
+	static shaderc::CompileOptions _CreateCompileOptions(const vector<pair<string, string>>& _macros) {
 		shaderc::CompileOptions options;
 		options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
-		for (auto it = m_geometryShaderMacros.begin(); it != m_geometryShaderMacros.end(); it++) {
+		for (auto it = _macros.begin(); it != _macros.end(); it++) {
 			if (it->second != "")
 				options.AddMacroDefinition(it->first, it->second);
 			else options.AddMacroDefinition(it->first);
 		}
 
-		const string csGeometryShaderSourcePath =
-			string{ m_csGeometryShaderSourcePath } + '/' + m_csGeometryShaderSourceName + ".geom";
+		return options;
+	}
 
-		vector<char> sSourceCode = m_programFilesManager.GetProgramFileContent(csGeometryShaderSourcePath);
-		shaderc::CompilationResult module = compiler.CompileGlslToSpv(
-			sSourceCode.data(),
-			sSourceCode.size(),
-			shaderc_geometry_shader,
-			fs::path(csGeometryShaderSourcePath).filename().u8string().c_str(),
-			options);
 
-		if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
-			throw ShaderException(module.GetErrorMessage());
-			return move(vector<uint32_t>());
-		}
+	// each thread reuses its own compiler instead of rebuilding compiler state for every module
+	static const shaderc::Compiler& _GetCompiler() {
+		thread_local const shaderc::Compiler s_compiler;
+		return s_compiler;
+	}
 
-		vector<uint32_t> spirv(module.cbegin(), module.cend());
 
-		try {
-			m_programFilesManager.WriteProgramFile(
-				(const char*)spirv.data(),
-				spirv.size() * sizeof(uint32_t),
-				string{ m_csGeometryShaderSpirvPath } + '/' + m_csGeometryShaderSpirvName + ".geom.spv");
-		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), NON_CRITICAL);
-		}
+	static size_t _GetStageIndex(ShaderStageBits _bmStage) {
+		switch (_bmStage) {
+			case ShaderStageBit_Vertex:
+				return 0;
 
-		return move(spirv);
+			case ShaderStageBit_Geometry:
+				return 1;
+
+			default:
+				return 2;
+		}
 	}
 
 
-	vector<uint32_t>&& FileSystemShader::_CompileFragmentShaderToSpirv() const {
-		shaderc::Compiler compiler;
-		shaderc::CompileOptions options;
-		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+	string FileSystemShader::_GetSourcePath(ShaderStageBits _bmStage) const {
+		switch (_bmStage) {
+			case ShaderStageBit_Vertex:
+				return string{ m_csVertexShaderSourcePath } + '/' + m_csVertexShaderSourceName + ".vert";
 
-		for (auto it = m_fragmentShaderMacros.begin(); it != m_fragmentShaderMacros.end(); it++) {
-			if (it->second != "")
-				options.AddMacroDefinition(it->first, it->second);
-			else options.AddMacroDefinition(it->first);
+			case ShaderStageBit_Geometry:
+				return string{ m_csGeometryShaderSourcePath } + '/' + m_csGeometryShaderSourceName + ".geom";
+
+			default:
+				return string{ m_csFragmentShaderSourcePath } + '/' + m_csFragmentShaderSourceName + ".frag";
 		}
+	}
 
-		const string csFragmentShaderSourcePath =
-			string{ m_csFragmentShaderSourcePath } + '/' + m_csFragmentShaderSourceName + ".frag";
-		vector<char> sSourceCode = m_programFilesManager.GetProgramFileContent(csFragmentShaderSourcePath);
-		shaderc::CompilationResult module = compiler.CompileGlslToSpv(
-			sSourceCode.data(),
-			sSourceCode.size(),
-			shaderc_fragment_shader,
-			fs::path(csFragmentShaderSourcePath).filename().u8string().c_str(),
-			options);
 
-		if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
-			throw ShaderException(module.GetErrorMessage());
-			return move(vector<uint32_t>());
-		}
+	const vector<pair<string, string>>& FileSystemShader::_GetMacros(ShaderStageBits _bmStage) const {
+		switch (_bmStage) {
+			case ShaderStageBit_Vertex:
+				return m_vertexShaderMacros;
 
-		vector<uint32_t> spirv(module.cbegin(), module.cend());
+			case ShaderStageBit_Geometry:
+				return m_geometryShaderMacros;
 
-		try {
-			m_programFilesManager.WriteProgramFile(
-				(const char*)spirv.data(),
-				spirv.size() * sizeof(uint32_t),
-				string{ m_csFragmentShaderSpirvPath } + '/' + m_csFragmentShaderSpirvName + ".frag.spv");
+			default:
+				return m_fragmentShaderMacros;
 		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), NON_CRITICAL);
+	}
+
+
+	cvar::hash_t FileSystemShader::_PreprocessSource(
+		const ProgramFilesManager& _programFilesManager,
+		const string& _sSourcePath,
+		ShaderStageBits _bmStage,
+		const vector<pair<string, string>>& _macros,
+		string& _sPreprocessedSource)
+	{
+		if (!_programFilesManager.ExistsFile(_sSourcePath))
+			throw IOException("Shader source file '" + _sSourcePath + "' does not exist");
+
+		// empty files can not be mapped, thus they are rejected before mapping as invalid source rather than as a read failure
+		if (!_programFilesManager.FileSize(_sSourcePath))
+			throw ShaderException("Shader source file '" + _sSourcePath + "' is empty");
+
+		const FileView sourceCode = _programFilesManager.MapProgramFile(_sSourcePath);
+		if (sourceCode.Empty())
+			throw IOException("Failed to map shader source file '" + _sSourcePath + "'");
+
+		const shaderc_shader_kind eKind = _GetShaderKind(_bmStage);
+		shaderc::PreprocessedSourceCompilationResult result = _GetCompiler().PreprocessGlsl(
+			sourceCode.Data(),
+			sourceCode.Size(),
+			eKind,
+			fs::path(_sSourcePath).filename().u8string().c_str(),
+			_CreateCompileOptions(_macros));
+
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			throw ShaderException(result.GetErrorMessage());
+			return 0;
 		}
 
-		return move(spirv);
+		_sPreprocessedSource.assign(result.cbegin(), result.cend());
+
+		// macros are already expanded in the preprocessed source, but they are hashed as well to keep keys of distinct variants apart
+		uint32_t uSpirvVersion = 0, uSpirvRevision = 0;
+		shaderc_get_spv_version(&uSpirvVersion, &uSpirvRevision);
+
+		stringstream ss;
+		ss << "format=" << SPIRV_CACHE_FORMAT_VERSION << ";spv=" << uSpirvVersion << '.' << uSpirvRevision <<
+			";kind=" << static_cast<int>(eKind) << ";optimization=performance;";
+		for (auto it = _macros.begin(); it != _macros.end(); it++)
+			ss << "-D" << it->first << '=' << it->second << ';';
+
+		const string sOptionsTag = ss.str();
+		const cvar::hash_t hshOptions = SpirvCache::Hash(sOptionsTag.data(), sOptionsTag.size());
+		return SpirvCache::Hash(_sPreprocessedSource.data(), _sPreprocessedSource.size(), hshOptions);
 	}
 
 
-	vector<uint32_t>&& FileSystemShader::GetVertexShaderSpirv() const {
-		const string csVertexShaderSpirvFilePath = 
-			string{ m_csVertexShaderSpirvPath } + '/' + m_csVertexShaderSpirvName + ".vert.spv";
-		const string csVertexShaderSourceFilePath = 
-			string{ m_csVertexShaderSourcePath } + '/' + m_csVertexShaderSourceName + ".vert";
-		
-		time_t tSpvWriteTimestamp = 0, tSourceWriteTimestamp = 0;
-		tSourceWriteTimestamp = m_programFilesManager.GetFileTimestamp(csVertexShaderSourceFilePath);
+	vector<uint32_t> FileSystemShader::_CompileSpirv(
+		const ProgramFilesManager& _programFilesManager,
+		const string& _sSourcePath,
+		ShaderStageBits _bmStage,
+		const vector<pair<string, string>>& _macros,
+		cvar::hash_t& _hshKey)
+	{
+		string sPreprocessedSource;
+		const cvar::hash_t hshKey = _PreprocessSource(_programFilesManager, _sSourcePath, _bmStage, _macros, sPreprocessedSource);
+		_hshKey = hshKey;
+
+		SpirvCache& spirvCache = SpirvCache::GetInstance();
+		vector<uint32_t> spirv;
+		if (spirvCache.Find(hshKey, spirv))
+			return spirv;
+
+		// macros were expanded and #line directives keep diagnostics pointing to the original source
+		shaderc::CompilationResult module = _GetCompiler().CompileGlslToSpv(
+			sPreprocessedSource.data(),
+			sPreprocessedSource.size(),
+			_GetShaderKind(_bmStage),
+			fs::path(_sSourcePath).filename().u8string().c_str(),
+			_CreateCompileOptions({}));
 
-		try {
-			tSpvWriteTimestamp = m_programFilesManager.GetFileTimestamp(csVertexShaderSpirvFilePath);
-		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), ErrorSeverity::WARNING);
+		if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
+			throw ShaderException(module.GetErrorMessage());
+			return {};
 		}
 
-		if (tSpvWriteTimestamp > tSourceWriteTimestamp) {
-			auto input = m_programFilesManager.GetProgramFileContent(csVertexShaderSpirvFilePath);
-			vector<uint32_t> output(input.size() / sizeof(uint32_t));
-			for (size_t i = 0; i < output.size(); i++)
-				output[i] = reinterpret_cast<uint32_t*>(input.data())[i];
-			
-			return move(output);
-		}
-		else {
-			return _CompileVertexShaderToSpirv();
+		spirv.assign(module.cbegin(), module.cend());
+		spirvCache.Store(hshKey, spirv);
+		return spirv;
+	}
+
+
+	vector<uint32_t> FileSystemShader::_GetSpirv(ShaderStageBits _bmStage) const {
+		const size_t uStageIndex = _GetStageIndex(_bmStage);
+		future<vector<uint32_t>> job;
+		{
+			std::scoped_lock lock(m_spirvJobMutex);
+			job = std::move(m_spirvJobs[uStageIndex]);
 		}
+
+		// compilation exceptions are rethrown from the job
+		if (job.valid())
+			return job.get();
+
+		// stage was already loaded, its module can be looked up without preprocessing the source again
+		vector<uint32_t> spirv;
+		const cvar::hash_t hshKey = m_spirvKeys[uStageIndex].load();
+		if (hshKey && SpirvCache::GetInstance().Find(hshKey, spirv))
+			return spirv;
+
+		cvar::hash_t hshNewKey = 0;
+		spirv = _CompileSpirv(m_programFilesManager, _GetSourcePath(_bmStage), _bmStage, _GetMacros(_bmStage), hshNewKey);
+		m_spirvKeys[uStageIndex].store(hshNewKey);
+		return spirv;
 	}
-	
-	
-	vector<uint32_t>&& FileSystemShader::GetGeometryShaderSpirv() const {
-		const string csGeometryShaderSpirvFilePath =
-			string{ m_csGeometryShaderSpirvPath } + '/' + m_csGeometryShaderSpirvName + ".geom.spv";
-		const string csGeometryShaderSourceFilePath =
-			string{ m_csGeometryShaderSourcePath } + '/' + m_csGeometryShaderSourceName + ".geom";
 
-		time_t tSpvWriteTimestamp = 0, tSourceWriteTimestamp = 0;
-		tSourceWriteTimestamp = m_programFilesManager.GetFileTimestamp(csGeometryShaderSourceFilePath);
 
-		try {
-			tSpvWriteTimestamp = m_programFilesManager.GetFileTimestamp(csGeometryShaderSpirvFilePath);
+	void FileSystemShader::_DiscardSpirvJob(ShaderStageBits _bmStage) {
+		future<vector<uint32_t>> job;
+		{
+			std::scoped_lock lock(m_spirvJobMutex);
+			job = std::move(m_spirvJobs[_GetStageIndex(_bmStage)]);
 		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), WARNING);
+
+		if (job.valid())
+			job.wait();
+		m_spirvKeys[_GetStageIndex(_bmStage)].store(0);
+	}
+
+
+	void FileSystemShader::CompileSpirvAsync() {
+		ThreadPool& threadPool = ThreadPool::GetInstance();
+		const ShaderStageBits arrStages[] = { ShaderStageBit_Vertex, ShaderStageBit_Geometry, ShaderStageBit_Fragment };
+
+		std::scoped_lock lock(m_spirvJobMutex);
+		for (ShaderStageBits bmStage : arrStages) {
+			future<vector<uint32_t>>& job = m_spirvJobs[_GetStageIndex(bmStage)];
+			const string sSourcePath = _GetSourcePath(bmStage);
+			// geometry stage is optional, missing source is reported once the module is requested
+			if (job.valid() || (bmStage == ShaderStageBit_Geometry && !m_programFilesManager.ExistsFile(sSourcePath)))
+				continue;
+
+			// macro definitions are copied, since they may be modified while the job runs
+			job = threadPool.Submit([this, sSourcePath, bmStage, macros = _GetMacros(bmStage)]() {
+				cvar::hash_t hshKey = 0;
+				vector<uint32_t> spirv = _CompileSpirv(m_programFilesManager, sSourcePath, bmStage, macros, hshKey);
+				m_spirvKeys[_GetStageIndex(bmStage)].store(hshKey);
+				return spirv;
+			});
 		}
-	
-		if (tSpvWriteTimestamp > tSourceWriteTimestamp) {
-			auto input = m_programFilesManager.GetProgramFileContent(csGeometryShaderSpirvFilePath);
-			vector<uint32_t> output(input.size() / sizeof(uint32_t));
-			for (size_t i = 0; i < output.size(); i++)
-				output[i] = reinterpret_cast<uint32_t*>(input.data())[i];
-	
-			return move(output);
+	}
+
+
+	bool FileSystemShader::IsSpirvReady() const {
+		std::scoped_lock lock(m_spirvJobMutex);
+		for (const auto& job : m_spirvJobs) {
+			if (job.valid() && job.wait_for(chrono::seconds(0)) != future_status::ready)
+				return false;
 		}
-		else {
-			return _CompileGeometryShaderToSpirv();
+
+		return true;
+	}
+
+
+	void FileSystemShader::WaitForSpirv() const {
+		std::scoped_lock lock(m_spirvJobMutex);
+		for (const auto& job : m_spirvJobs) {
+			if (job.valid())
+				job.wait();
 		}
 	}
+
+
+	vector<uint32_t> FileSystemShader::GetVertexShaderSpirv() const {
+		return _GetSpirv(ShaderStageBit_Vertex);
+	}
 	
 	
-	vector<uint32_t>&& FileSystemShader::GetFragmentShaderSpirv() const {
-		const string csFragmentShaderSpirvFilePath =
-			string{ m_csFragmentShaderSpirvPath } + '/' + m_csFragmentShaderSourceName + ".frag.spv";
-		const string csFragmentShaderSourceFilePath =
-			string{ m_csFragmentShaderSourcePath } + '/' + m_csFragmentShaderSourceName + ".frag";
+	vector<uint32_t> FileSystemShader::GetGeometryShaderSpirv() const {
+		return _GetSpirv(ShaderStageBit_Geometry);
+	}
 	
-		time_t tSpvWriteTimestamp = 0, tSourceWriteTimestamp = 0;
-		tSourceWriteTimestamp = m_programFilesManager.GetFileTimestamp(csFragmentShaderSourceFilePath);
-
-		try {
-			tSpvWriteTimestamp = m_programFilesManager.GetFileTimestamp(csFragmentShaderSpirvFilePath);
-		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), WARNING);
-		}
-
-		if (tSpvWriteTimestamp > tSourceWriteTimestamp) {
-			auto input = m_programFilesManager.GetProgramFileContent(csFragmentShaderSpirvFilePath);
-			vector<uint32_t> output(input.size() / sizeof(uint32_t));
-			for (size_t i = 0; i < output.size(); i++)
-				output[i] = reinterpret_cast<uint32_t*>(input.data())[i];
 	
-			return move(output);
-		}
-		else {
-			return _CompileFragmentShaderToSpirv();
-		}
+	vector<uint32_t> FileSystemShader::GetFragmentShaderSpirv() const {
+		return _GetSpirv(ShaderStageBit_Fragment);
 	}
 
 
-	vector<char>&& FileSystemShader::GetPipelineCache(RendererType _eRendererType) const {
-		string sPipelineCacheFilePath = m_csPipelineCachePath;
+	string FileSystemShader::_GetPipelineCachePath(RendererType _eRendererType) const {
+		fs::path pipelineCachePath = m_csPipelineCachePath;
 
 		switch (_eRendererType) {
 			case RendererType::OpenGL:
-				sPipelineCacheFilePath += "/OpenGL";
+				pipelineCachePath /= "OpenGL";
 				break;
 
 			case RendererType::Vulkan:
-				sPipelineCacheFilePath += "/Vulkan";
+				pipelineCachePath /= "Vulkan";
 				break;
 
 			case RendererType::DirectX:
-				sPipelineCacheFilePath += "/DirectX";
+				pipelineCachePath /= "DirectX";
 				break;
 
 			default:
-				return move(vector<char>());
+				return "";
 		}
 
-		sPipelineCacheFilePath += '/' + m_bProperties.to_string() + ".cache";
+		pipelineCachePath /= string{ _Props2HexString() } + ".cache";
+		return pipelineCachePath.generic_string();
+	}
+
+
+	bool FileSystemShader::_ExistsPipelineCache(RendererType _eRendererType) const {
+		// empty cache files are left behind by failed writes and can not be mapped
+		const string sPipelineCacheFilePath = _GetPipelineCachePath(_eRendererType);
+		return m_programFilesManager.ExistsFile(sPipelineCacheFilePath) && m_programFilesManager.FileSize(sPipelineCacheFilePath);
+	}
+
 
-		if (!m_programFilesManager.ExistsFile(sPipelineCacheFilePath)) {
+	FileView FileSystemShader::GetPipelineCache(RendererType _eRendererType) const {
+		if (!_ExistsPipelineCache(_eRendererType)) {
 			stringstream ss;
 			ss << "Pipeline cache for shader module '" << _Props2HexString() << "' does not exist";
 			throw ShaderException(ss.str());
 			return {};
 		}
 
-		return m_programFilesManager.GetProgramFileContent(sPipelineCacheFilePath);
+		return m_programFilesManager.MapProgramFile(_GetPipelineCachePath(_eRendererType));
 	}
 
 
 	void FileSystemShader::CachePipeline(RendererType _eRendererType, const void* _pData, size_t _uLength) const {
 		DENG_ASSERT(_eRendererType == RendererType::Vulkan || _eRendererType == RendererType::OpenGL || _eRendererType == RendererType::DirectX);
-		string sPipelineCacheFilePath = m_csPipelineCachePath;
-
-		switch (_eRendererType) {
-			case RendererType::Vulkan:
-				sPipelineCacheFilePath += "\\Vulkan";
-				break;
-
-			case RendererType::OpenGL:
-				sPipelineCacheFilePath += "\\OpenGL";
-				break;
-
-			case RendererType::DirectX:
-				sPipelineCacheFilePath += "\\DirectX";
-				break;
-		}
-
-		sPipelineCacheFilePath += '/' + string{ _Props2HexString() } + ".cache";
+		if (!_uLength)
+			return;
 
 		try {
-			m_programFilesManager.WriteProgramFile((const char*)_pData, _uLength, sPipelineCacheFilePath);
+			// pipelines of other shader instances might be reading the same cache file
+			m_programFilesManager.ReplaceProgramFile((const char*)_pData, _uLength, _GetPipelineCachePath(_eRendererType));
 		}
 		catch (const IOException& e) {
 			DISPATCH_ERROR_MESSAGE("IOException", e.what(), NON_CRITICAL);
@@ -325,43 +372,33 @@ namespace DENG {
 	PipelineCacheStatusBits FileSystemShader::GetPipelineCacheStatus() const {
 		PipelineCacheStatusBits uMask = 0;
 		// check if pipeline cache exists
-		const char* szHexProps = _Props2HexString();
-		
-		const string sDirectXPipelineCacheFilePath = m_csPipelineCachePath + "/DirectX/" + szHexProps + ".cache";
-		const string sOpenGLPipelineCacheFilePath = m_csPipelineCachePath + "/OpenGL/" + szHexProps + ".cache";
-		const string sVulkanPipelineCacheFilePath = m_csPipelineCachePath + "/Vulkan/" + szHexProps + ".cache";
-		
-		if (m_programFilesManager.ExistsFile(sOpenGLPipelineCacheFilePath))
+		if (_ExistsPipelineCache(RendererType::OpenGL))
 			uMask |= PipelineCacheStatusBit_OpenGLCache;
-		else if (m_programFilesManager.ExistsFile(sVulkanPipelineCacheFilePath))
+		if (_ExistsPipelineCache(RendererType::Vulkan))
 			uMask |= PipelineCacheStatusBit_VulkanCache;
-		else if (m_programFilesManager.ExistsFile(sDirectXPipelineCacheFilePath))
+		if (_ExistsPipelineCache(RendererType::DirectX))
 			uMask |= PipelineCacheStatusBit_DirectXCache;
 
 		if (uMask) return uMask;
 		
-		// check if spirv exists
-		const string sVertexShaderSpirvPath = 
-			string{ m_csVertexShaderSpirvPath } + '/' + m_csVertexShaderSpirvName + ".vert.spv";
-		const string sGeometryShaderSourcePath =
-			string{ m_csGeometryShaderSourcePath } + '/' + m_csGeometryShaderSourceName + ".geom";
-		const string sGeometryShaderSpirvPath = 
-			string{ m_csGeometryShaderSpirvPath } + '/' + m_csGeometryShaderSpirvName + ".geom.spv";
-		const string sFragmentShaderSpirvPath =
-			string{ m_csFragmentShaderSpirvPath } + '/' + m_csFragmentShaderSpirvName + ".frag.spv";
-		
-		if (m_programFilesManager.ExistsFile(sVertexShaderSpirvPath) &&
-			(!m_programFilesManager.ExistsFile(sGeometryShaderSourcePath) || m_programFilesManager.ExistsFile(sGeometryShaderSpirvPath)) &&
-			m_programFilesManager.ExistsFile(sFragmentShaderSpirvPath))
-		{
-			return PipelineCacheStatusBit_Spirv;
+		// check if spirv modules of loaded stages are cached, stages that were not loaded yet have no known key
+		SpirvCache& spirvCache = SpirvCache::GetInstance();
+		const ShaderStageBits arrStages[] = { ShaderStageBit_Vertex, ShaderStageBit_Geometry, ShaderStageBit_Fragment };
+		size_t uStageCount = 0, uCachedStageCount = 0;
+		for (ShaderStageBits bmStage : arrStages) {
+			if (bmStage == ShaderStageBit_Geometry && !m_programFilesManager.ExistsFile(_GetSourcePath(bmStage)))
+				continue;
+
+			uStageCount++;
+			const cvar::hash_t hshKey = m_spirvKeys[_GetStageIndex(bmStage)].load();
+			if (hshKey && spirvCache.Contains(hshKey))
+				uCachedStageCount++;
 		}
-		else if (m_programFilesManager.ExistsFile(sVertexShaderSpirvPath) ||
-			(!m_programFilesManager.ExistsFile(sGeometryShaderSourcePath) || m_programFilesManager.ExistsFile(sGeometryShaderSpirvPath)) ||
-			m_programFilesManager.ExistsFile(sFragmentShaderSpirvPath))
-		{
+
+		if (uCachedStageCount == uStageCount)
+			return PipelineCacheStatusBit_Spirv;
+		else if (uCachedStageCount)
 			return PipelineCacheStatusBit_PartialSpirv;
-		}
 		else return PipelineCacheStatusBit_NoCache;
 	}
 }
\ No newline at end of file
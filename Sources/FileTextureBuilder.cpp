@@ -36,14 +36,14 @@ namespace DENG {
 		Texture texture;
 		ProgramFilesManager programFilesManager;
 
-		auto imageData = programFilesManager.GetProgramFileContent(m_sFileName);
-		if (imageData.empty())
+		const FileView imageData = programFilesManager.MapProgramFile(m_sFileName);
+		if (imageData.Empty())
 			throw IOException("Failed to read contents from " + m_sFileName);
 
 		int x, y, depth;
 		stbi_uc* pTexels = stbi_load_from_memory(
-			(stbi_uc*)imageData.data(),
-			static_cast<int>(imageData.size()),
+			(const stbi_uc*)imageData.Data(),
+			static_cast<int>(imageData.Size()),
 			&x, &y, &depth, 4);
 
 		texture.bHeapAllocationFlag = true;
@@ -57,18 +57,89 @@ namespace DENG {
 		return texture;
 	}
 
+	std::string FileCompressedTextureBuilder::_GetCookedFileName() {
+		switch (m_eFormat) {
+			case TextureFormat::BC1:
+				return "Textures/Cooked/" + m_sFileName + ".bc1.dds";
+
+			case TextureFormat::BC5:
+				return "Textures/Cooked/" + m_sFileName + ".bc5.dds";
+
+			default:
+				return "Textures/Cooked/" + m_sFileName + ".bc3.dds";
+		}
+	}
+
+
+	Texture FileCompressedTextureBuilder::Get() {
+		ProgramFilesManager programFilesManager;
+
+		if (m_sFileName.size() > 4 && m_sFileName.compare(m_sFileName.size() - 4, 4, ".dds") == 0) {
+			const FileView ddsData = programFilesManager.MapProgramFile(m_sFileName);
+			if (ddsData.Empty())
+				throw IOException("Failed to read contents from " + m_sFileName);
+
+			return TextureCooker::LoadDDS(ddsData.Data(), ddsData.Size());
+		}
+
+		if (!m_bCompressionSupported)
+			return FileTextureBuilder(m_sFileName).Get();
+
+		const std::string sCookedFileName = _GetCookedFileName();
+		time_t tCookedTimestamp = 0;
+		const time_t tSourceTimestamp = programFilesManager.GetFileTimestamp(m_sFileName);
+		if (programFilesManager.ExistsFile(sCookedFileName))
+			tCookedTimestamp = programFilesManager.GetFileTimestamp(sCookedFileName);
+
+		if (tCookedTimestamp <= tSourceTimestamp) {
+			const FileView imageData = programFilesManager.MapProgramFile(m_sFileName);
+			if (imageData.Empty())
+				throw IOException("Failed to read contents from " + m_sFileName);
+
+			int x, y, depth;
+			stbi_uc* pTexels = stbi_load_from_memory(
+				(const stbi_uc*)imageData.Data(),
+				static_cast<int>(imageData.Size()),
+				&x, &y, &depth, 4);
+
+			if (!pTexels)
+				throw IOException("Failed to decode " + m_sFileName);
+
+			std::vector<char> cooked;
+			try {
+				cooked = TextureCooker::Cook(reinterpret_cast<const char*>(pTexels), static_cast<uint32_t>(x), static_cast<uint32_t>(y), m_eFormat);
+			}
+			catch (...) {
+				stbi_image_free(pTexels);
+				throw;
+			}
+
+			stbi_image_free(pTexels);
+			// other processes or loader threads might be reading the previously cooked file
+			programFilesManager.ReplaceProgramFile(cooked.data(), cooked.size(), sCookedFileName);
+			return TextureCooker::LoadDDS(cooked.data(), cooked.size());
+		}
+
+		const FileView ddsData = programFilesManager.MapProgramFile(sCookedFileName);
+		if (ddsData.Empty())
+			throw IOException("Failed to read contents from " + sCookedFileName);
+
+		return TextureCooker::LoadDDS(ddsData.Data(), ddsData.Size());
+	}
+
+
 	Texture FileMonochromeTextureBuilder::Get() {
 		Texture texture;
 		ProgramFilesManager programFilesManager;
 
-		auto imageData = programFilesManager.GetProgramFileContent(m_sFileName);
-		if (imageData.empty())
+		const FileView imageData = programFilesManager.MapProgramFile(m_sFileName);
+		if (imageData.Empty())
 			throw IOException("Failed to read contents from " + m_sFileName);
 
 		int x, y, depth;
 		stbi_uc* pTexels = stbi_load_from_memory(
-			(stbi_uc*)imageData.data(),
-			static_cast<int>(imageData.size()),
+			(const stbi_uc*)imageData.Data(),
+			static_cast<int>(imageData.Size()),
 			&x, &y, &depth, 1);
 
 		texture.bHeapAllocationFlag = true;
@@ -87,14 +158,14 @@ namespace DENG {
 		Texture texture;
 		ProgramFilesManager programFilesManager;
 
-		auto imageData = programFilesManager.GetProgramFileContent(m_sFileName);
-		if (imageData.empty())
+		const FileView imageData = programFilesManager.MapProgramFile(m_sFileName);
+		if (imageData.Empty())
 			throw IOException("Failed to read contents from " + m_sFileName);
 
 		int x, y, depth;
 		stbi_uc* pTexels = stbi_load_from_memory(
-			(stbi_uc*)imageData.data(),
-			static_cast<int>(imageData.size()),
+			(const stbi_uc*)imageData.Data(),
+			static_cast<int>(imageData.Size()),
 			&x, &y, &depth, 4);
 
 		texture.bHeapAllocationFlag = true;
@@ -114,40 +185,62 @@ namespace DENG {
 			m_sPosXFileName, m_sNegXFileName,
 			m_sPosYFileName, m_sNegYFileName,
 			m_sPosZFileName, m_sNegZFileName };
-		std::array<stbi_uc*, 6> arrTexels = {};
+		std::array<FileView, 6> arrImageData;
 
 		Texture texture;
 		ProgramFilesManager programFilesManager;
 
-		for (auto it = arrFileNames.begin(); it != arrFileNames.end(); it++) {
-			auto imageData = programFilesManager.GetProgramFileContent(*it);
-			if (imageData.empty())
-				throw IOException("Failed to read contents from " + *it);
+		// read face resolutions from image headers first, so that the whole cube map can be allocated once
+		for (size_t i = 0; i < arrFileNames.size(); i++) {
+			arrImageData[i] = programFilesManager.MapProgramFile(arrFileNames[i]);
+			if (arrImageData[i].Empty())
+				throw IOException("Failed to read contents from " + arrFileNames[i]);
 			
 			int x, y, depth;
-			stbi_uc* pTexels = stbi_load_from_memory(
-				(stbi_uc*)imageData.data(),
-				static_cast<int>(imageData.size()),
-				&x, &y, &depth, 4);
+			if (!stbi_info_from_memory((const stbi_uc*)arrImageData[i].Data(), static_cast<int>(arrImageData[i].Size()), &x, &y, &depth))
+				throw IOException("Failed to read image header from " + arrFileNames[i]);
 
 			if ((texture.uWidth || texture.uHeight) && (texture.uWidth != static_cast<uint32_t>(x) || texture.uHeight != static_cast<uint32_t>(y)))
 				throw LogicException("Conflicting cube map resolutions");
 			
 			texture.uWidth = static_cast<uint32_t>(x);
 			texture.uHeight = static_cast<uint32_t>(y);
-			texture.uBitDepth = 4;
-			texture.eLoadType = GetLoadType(*it);
-			texture.eResourceType = TextureType::Image_3D_Array;
-			arrTexels[it - arrFileNames.begin()] = pTexels;
 		}
 
+		texture.uBitDepth = 4;
+		texture.eLoadType = GetLoadType(arrFileNames[0]);
+		texture.eResourceType = TextureType::Image_3D_Array;
 		texture.bHeapAllocationFlag = true;
-		texture.pRGBAData = new char[texture.uWidth * texture.uHeight * texture.uBitDepth * 6] {};
-		for (uint32_t i = 0; i < 6; i++)
-			std::memcpy(texture.pRGBAData + i * texture.uWidth * texture.uHeight * texture.uBitDepth, arrTexels[i], texture.uWidth * texture.uHeight * texture.uBitDepth);
-	
-		for (auto ptr : arrTexels)
-			stbi_image_free(ptr);
+
+		const size_t uFaceSize = static_cast<size_t>(texture.uWidth) * texture.uHeight * texture.uBitDepth;
+		texture.pRGBAData = new char[uFaceSize * 6];
+
+		// faces are decoded in parallel, each decoded face is copied into its slice and released right away
+		std::array<std::string, 6> arrErrors;
+		ThreadPool::GetInstance().ParallelFor(arrFileNames.size(), 1, [&](size_t _uBegin, size_t _uEnd) {
+			for (size_t i = _uBegin; i < _uEnd; i++) {
+				int x, y, depth;
+				stbi_uc* pTexels = stbi_load_from_memory(
+					(const stbi_uc*)arrImageData[i].Data(),
+					static_cast<int>(arrImageData[i].Size()),
+					&x, &y, &depth, 4);
+
+				if (!pTexels) {
+					arrErrors[i] = "Failed to decode " + arrFileNames[i] + ": " + stbi_failure_reason();
+					continue;
+				}
+
+				std::memcpy(texture.pRGBAData + i * uFaceSize, pTexels, uFaceSize);
+				stbi_image_free(pTexels);
+			}
+		});
+
+		for (auto it = arrErrors.begin(); it != arrErrors.end(); it++) {
+			if (!it->empty()) {
+				delete[] texture.pRGBAData;
+				throw IOException(*it);
+			}
+		}
 
 		return texture;
 	}
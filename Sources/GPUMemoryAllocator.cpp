@@ -10,200 +10,198 @@ using namespace std;
 
 namespace DENG {
 
-#ifdef _DEBUG
-	void GPUMemoryAllocator::DbPrintMemoryRegions() {
-		for (auto it = m_memoryRegions.begin(); it != m_memoryRegions.end(); it++) {
-			if (it != m_memoryRegions.begin()) {
-				auto itPrevious = it;
-				itPrevious--;
-				size_t uFragmentSize = it->uOffset - itPrevious->uOffset - itPrevious->uSize;
-
-				if (uFragmentSize) {
-					cout << '[';
-					for (uint32_t i = 0; i < uFragmentSize; i++)
-						cout << '-';
-					cout << "] ";
-				}
-			}
+	static inline size_t _AlignOffset(size_t _uOffset, size_t _uAlignment) {
+		if (_uAlignment < 2)
+			return _uOffset;
+		return (_uOffset + _uAlignment - 1) & ~(_uAlignment - 1);
+	}
 
-			cout << '[';
-			for (uint32_t i = 0; i < it->uSize; i++) {
-				cout << '*';
-			}
-			cout << "] ";
+
+	void MemoryStatistics::Accumulate(const MemoryStatistics& _statistics) {
+		uCapacity += _statistics.uCapacity;
+		uUsedBytes += _statistics.uUsedBytes;
+		uFreeBytes += _statistics.uFreeBytes;
+		uLargestFreeBlock = std::max(uLargestFreeBlock, _statistics.uLargestFreeBlock);
+		uFragmentCount += _statistics.uFragmentCount;
+		uAllocationCount += _statistics.uAllocationCount;
+		// peaks of separate allocators need not coincide, thus their sum is only an upper bound
+		uHighWaterMark += _statistics.uHighWaterMark;
+
+		for (size_t i = 0; i < allocationHistogram.size(); i++)
+			allocationHistogram[i] += _statistics.allocationHistogram[i];
+	}
+
+
+	std::string MemoryStatistics::ToJson() const {
+		std::stringstream ss;
+		ss << "{\"capacity\":" << uCapacity <<
+			",\"usedBytes\":" << uUsedBytes <<
+			",\"freeBytes\":" << uFreeBytes <<
+			",\"largestFreeBlock\":" << uLargestFreeBlock <<
+			",\"fragmentCount\":" << uFragmentCount <<
+			",\"fragmentation\":" << GetFragmentation() <<
+			",\"allocationCount\":" << uAllocationCount <<
+			",\"highWaterMark\":" << uHighWaterMark <<
+			",\"allocationHistogram\":[";
+
+		// trailing empty size classes are omitted
+		size_t uHistogramSize = allocationHistogram.size();
+		while (uHistogramSize && !allocationHistogram[uHistogramSize - 1])
+			uHistogramSize--;
+
+		for (size_t i = 0; i < uHistogramSize; i++) {
+			if (i) ss << ',';
+			ss << allocationHistogram[i];
 		}
 
+		ss << "]}";
+		return ss.str();
+	}
+
+
+#ifdef _DEBUG
+	void GPUMemoryAllocator::DbPrintMemoryRegions() {
+		// one entry per block: '*' marks used and '-' unused blocks
+		for (auto it = m_blocks.begin(); it != m_blocks.end(); it++)
+			cout << '[' << (it->second.bIsFree ? '-' : '*') << ' ' << it->first << '+' << it->second.uSize << "] ";
+
 		cout << '\n';
 	}
 #endif
-	
-	MemoryRegion GPUMemoryAllocator::RequestMemory(size_t _uSize, size_t _uMinimalAlignmentOffset) {
-		if (_uMinimalAlignmentOffset) {
-			_uSize = (_uSize + _uMinimalAlignmentOffset - 1) & ~(_uMinimalAlignmentOffset - 1);
+
+
+	size_t GPUMemoryAllocator::_GetSizeClass(size_t _uSize) {
+		size_t uClass = 0;
+		while (_uSize >>= 1)
+			uClass++;
+		return std::min(uClass, static_cast<size_t>(MEMORY_HISTOGRAM_SIZE - 1));
+	}
+
+
+	void GPUMemoryAllocator::_InsertFreeBlock(size_t _uOffset, size_t _uSize) {
+		m_blocks.emplace(_uOffset, _Block{ _uSize, true });
+		m_freeBlocks.emplace(_uSize, _uOffset);
+	}
+
+
+	std::map<size_t, GPUMemoryAllocator::_Block>::iterator GPUMemoryAllocator::_FindFreeBlock(size_t _uSize, size_t _uAlignment) {
+		// smallest block that is large enough
+		auto itFreeBlock = m_freeBlocks.lower_bound({ _uSize, 0 });
+		if (itFreeBlock == m_freeBlocks.end())
+			return m_blocks.end();
+
+		if (_AlignOffset(itFreeBlock->second, _uAlignment) - itFreeBlock->second + _uSize <= itFreeBlock->first)
+			return m_blocks.find(itFreeBlock->second);
+
+		// alignment padding did not fit, any block with room for the worst case padding does
+		if (_uAlignment > 1) {
+			itFreeBlock = m_freeBlocks.lower_bound({ _uSize + _uAlignment - 1, 0 });
+			if (itFreeBlock != m_freeBlocks.end())
+				return m_blocks.find(itFreeBlock->second);
 		}
 
-		// check if there are any fragmented regions available
+		return m_blocks.end();
+	}
+
+
+	MemoryRegion GPUMemoryAllocator::RequestMemory(size_t _uSize, size_t _uMinimalAlignmentOffset) {
+		// empty regions would share their offset with the next region
+		if (!_uSize)
+			_uSize = 1;
+		_uSize = _AlignOffset(_uSize, _uMinimalAlignmentOffset);
+
 		size_t uOffset = 0;
-		if (m_storageFragments.size()) {
-			pop_heap(m_storageFragments.begin(), m_storageFragments.end(), UnusedMemoryFragment::Compare());
-			
-			// assuming that the heap has already been constructed
-			uOffset = m_storageFragments.back().uOffset;
-			size_t uAvailableSize = m_storageFragments.back().uSize;
-
-			if (_uMinimalAlignmentOffset > 0) {
-				uOffset = (uOffset + _uMinimalAlignmentOffset - 1) & ~(_uMinimalAlignmentOffset - 1);
-				uAvailableSize -= uOffset - m_storageFragments.back().uOffset;
+		auto itBlock = _FindFreeBlock(_uSize, _uMinimalAlignmentOffset);
+		if (itBlock != m_blocks.end()) {
+			const size_t uBlockOffset = itBlock->first;
+			const size_t uBlockSize = itBlock->second.uSize;
+			uOffset = _AlignOffset(uBlockOffset, _uMinimalAlignmentOffset);
+			m_freeBlocks.erase({ uBlockSize, uBlockOffset });
+
+			// alignment padding stays unused in front of the region
+			if (uOffset > uBlockOffset) {
+				itBlock->second.uSize = uOffset - uBlockOffset;
+				m_freeBlocks.emplace(itBlock->second.uSize, uBlockOffset);
+				m_blocks.emplace_hint(std::next(itBlock), uOffset, _Block{ _uSize, false });
 			}
-
-			if (uAvailableSize >= _uSize) {
-				auto itRegion1 = m_storageFragments.back().region1;
-				auto itRegion2 = m_storageFragments.back().region2;
-				std::list<MemoryRegion>::iterator itEmplacedArea;
-
-				if (itRegion1 != itRegion2) {
-					itEmplacedArea = m_memoryRegions.emplace(itRegion2, uOffset, _uSize);
-				}
-				else {
-					itEmplacedArea = m_memoryRegions.emplace(m_memoryRegions.begin(), uOffset, _uSize);
-				}
-
-				// check if there is a fragment before emplaced region
-				if (uOffset > m_storageFragments.back().uOffset) {
-					m_storageFragments.back().region1 = itRegion1;
-					m_storageFragments.back().region2 = itEmplacedArea;
-					m_storageFragments.back().uSize =
-						itEmplacedArea->uOffset - itRegion1->uOffset - itRegion1->uSize;
-
-					// and after
-					if (uOffset + _uSize < itRegion2->uOffset) {
-						m_storageFragments.push_back({
-							itEmplacedArea,
-							itRegion2,
-							itEmplacedArea->uOffset + itEmplacedArea->uSize,
-							itRegion2->uOffset - itEmplacedArea->uOffset - itEmplacedArea->uSize });
-					}
-				}
-				// after
-				else if (uOffset + _uSize < itRegion2->uOffset) {
-					m_storageFragments.back().region1 = itEmplacedArea;
-					m_storageFragments.back().region2 = itRegion2;
-					m_storageFragments.back().uSize =
-						itRegion2->uOffset - itEmplacedArea->uOffset - itEmplacedArea->uSize;
-					m_storageFragments.back().uOffset = itEmplacedArea->uOffset + itEmplacedArea->uSize;
-				}
-				// continuous
-				else {
-					m_storageFragments.pop_back();
-				}
-
-				make_heap(m_storageFragments.begin(), m_storageFragments.end(), UnusedMemoryFragment::Compare());
-				return *itEmplacedArea;
+			else {
+				itBlock->second = _Block{ _uSize, false };
 			}
-		}
 
-		// memory region exists before
-		if (m_memoryRegions.size()) {
-			uOffset = m_memoryRegions.back().uOffset + m_memoryRegions.back().uSize;
-
-			if (uOffset > 0)
-				uOffset = (uOffset + _uMinimalAlignmentOffset - 1) & ~(_uMinimalAlignmentOffset - 1);
-			m_memoryRegions.push_back({ uOffset, _uSize });
-			auto itPreviousRegion = m_memoryRegions.end();
-			--itPreviousRegion;
-			--itPreviousRegion;
-			auto itPushedRegion = m_memoryRegions.end();
-			--itPushedRegion;
-
-			if (uOffset > itPreviousRegion->uOffset + itPreviousRegion->uSize) {
-				m_storageFragments.push_back({
-					itPreviousRegion,
-					itPushedRegion,
-					itPreviousRegion->uOffset + itPreviousRegion->uSize,
-					itPushedRegion->uOffset - itPreviousRegion->uOffset - itPreviousRegion->uSize });
-				make_heap(m_storageFragments.begin(), m_storageFragments.end(), UnusedMemoryFragment::Compare());
-			}
+			const size_t uRemainingSize = uBlockOffset + uBlockSize - uOffset - _uSize;
+			if (uRemainingSize)
+				_InsertFreeBlock(uOffset + _uSize, uRemainingSize);
 		}
 		else {
-			m_memoryRegions.push_back({ uOffset, _uSize });
+			// no unused block is large enough, append to the end
+			uOffset = _AlignOffset(m_uEndOffset, _uMinimalAlignmentOffset);
+			if (uOffset > m_uEndOffset)
+				_InsertFreeBlock(m_uEndOffset, uOffset - m_uEndOffset);
+
+			m_blocks.emplace_hint(m_blocks.end(), uOffset, _Block{ _uSize, false });
+			m_uEndOffset = uOffset + _uSize;
 		}
 
-		return m_memoryRegions.back();
+		m_uUsedBytes += _uSize;
+		m_uHighWaterMark = std::max(m_uHighWaterMark, m_uUsedBytes);
+		m_allocationHistogram[_GetSizeClass(_uSize)]++;
+		return MemoryRegion(uOffset, _uSize);
 	}
 
 
-	// O(n)
 	bool GPUMemoryAllocator::FreeMemory(size_t _uOffset) {
-		bool bIsRemoved = false;
-		std::list<MemoryRegion>::iterator it = m_memoryRegions.begin();
-		for (; it != m_memoryRegions.end(); it++) {
-			if (it->uOffset == _uOffset) {
-				bIsRemoved = true;
-				break;
-			}
+		auto itBlock = m_blocks.find(_uOffset);
+		if (itBlock == m_blocks.end() || itBlock->second.bIsFree)
+			return false;
+
+		size_t uOffset = itBlock->first;
+		size_t uSize = itBlock->second.uSize;
+		m_uUsedBytes -= uSize;
+		m_allocationHistogram[_GetSizeClass(uSize)]--;
+
+		// coalesce with the following unused block
+		auto itNext = std::next(itBlock);
+		if (itNext != m_blocks.end() && itNext->second.bIsFree) {
+			m_freeBlocks.erase({ itNext->second.uSize, itNext->first });
+			uSize += itNext->second.uSize;
+			m_blocks.erase(itNext);
 		}
 
-		if (bIsRemoved) {
-			for (size_t i = 0; i < m_storageFragments.size(); i++) {
-				if (m_storageFragments[i].region1 == it) {
-					if (it == m_memoryRegions.begin()) {
-						m_storageFragments[i].region1 = m_storageFragments[i].region2;
-						m_storageFragments[i].uSize = m_storageFragments[i].region2->uOffset;
-						m_storageFragments[i].uOffset = 0;
-					}
-					else {
-						m_storageFragments[i].region1 = it;
-						m_storageFragments[i].region1--;
-						m_storageFragments[i].uSize = m_storageFragments[i].region2->uOffset -
-							m_storageFragments[i].region1->uOffset - m_storageFragments[i].region1->uSize;
-						m_storageFragments[i].uOffset = m_storageFragments[i].region1->uSize + m_storageFragments[i].region1->uOffset;
-					}
-				}
-				else if (m_storageFragments[i].region2 == it) {
-					if (it == --m_memoryRegions.end()) {
-						m_storageFragments.erase(m_storageFragments.begin() + i);
-						i--;
-					}
-					else {
-						m_storageFragments[i].region2 = it;
-						m_storageFragments[i].region2++;
-						m_storageFragments[i].uSize = m_storageFragments[i].region2->uOffset -
-							m_storageFragments[i].region1->uOffset - m_storageFragments[i].region1->uSize;
-						m_storageFragments[i].uOffset = m_storageFragments[i].region1->uSize + m_storageFragments[i].region1->uOffset;
-					}
-				}
+		// coalesce with the preceding unused block
+		if (itBlock != m_blocks.begin()) {
+			auto itPrevious = std::prev(itBlock);
+			if (itPrevious->second.bIsFree) {
+				m_freeBlocks.erase({ itPrevious->second.uSize, itPrevious->first });
+				uOffset = itPrevious->first;
+				uSize += itPrevious->second.uSize;
+				m_blocks.erase(itBlock);
+				itBlock = itPrevious;
 			}
+		}
 
-			auto itNext = it;
-			itNext++;
-			auto itPrevious = it;
-
-			if (itNext != m_memoryRegions.end() && 
-				it != m_memoryRegions.begin() &&
-				it->uOffset + it->uSize == itNext->uOffset &&
-				(--itPrevious)->uOffset + itPrevious->uSize == it->uOffset)
-			{
-				m_storageFragments.push_back({
-					itPrevious,
-					itNext,
-					it->uOffset,
-					it->uSize });
-			}
-			else if (itNext != m_memoryRegions.end() &&
-				it == m_memoryRegions.begin() &&
-				it->uOffset + it->uSize == it->uOffset)
-			{
-				m_storageFragments.push_back({
-					itNext,
-					itNext,
-					0, 
-					it->uSize + it->uOffset });
-			}
+		// unused space at the end is given back to the offset space
+		if (uOffset + uSize == m_uEndOffset) {
+			m_blocks.erase(itBlock);
+			m_uEndOffset = uOffset;
+			return true;
 		}
 
-		m_memoryRegions.erase(it);
-		make_heap(m_storageFragments.begin(), m_storageFragments.end(), UnusedMemoryFragment::Compare());
+		itBlock->second = _Block{ uSize, true };
+		m_freeBlocks.emplace(uSize, uOffset);
+		return true;
+	}
+
 
-		return bIsRemoved;
+	MemoryStatistics GPUMemoryAllocator::GetStatistics() const {
+		MemoryStatistics statistics;
+		statistics.uCapacity = m_uEndOffset;
+		statistics.uUsedBytes = m_uUsedBytes;
+		statistics.uFreeBytes = m_uEndOffset - m_uUsedBytes;
+		statistics.uLargestFreeBlock = m_freeBlocks.empty() ? 0 : m_freeBlocks.rbegin()->first;
+		statistics.uFragmentCount = m_freeBlocks.size();
+		statistics.uAllocationCount = m_blocks.size() - m_freeBlocks.size();
+		statistics.uHighWaterMark = m_uHighWaterMark;
+		statistics.allocationHistogram = m_allocationHistogram;
+		return statistics;
 	}
-}
\ No newline at end of file
+}
@@ -10,7 +10,8 @@ namespace DENG {
 
 	const char* IShader::_Props2HexString() const {
 		std::size_t uBufCounter = 0;
-		static char s_buffer[N_BITS / 4 + 1]{};
+		// pipelines are created concurrently on worker threads
+		thread_local char s_buffer[N_BITS / 4 + 1]{};
 		
 		const std::array<char, 16> cLookup{
 			'0', '1', '2', '3',
@@ -112,9 +112,6 @@ namespace DENG {
 		DENG_ASSERT(pMesh);
 		pMesh->drawCommands.clear();
 
-		if (m_uVertexRegionOffset)
-			m_pRenderer->DeallocateMemory(m_uVertexRegionOffset);
-
 		size_t uVertexSize = 0;
 		size_t uIndexSize = 0;
 
@@ -128,14 +125,13 @@ namespace DENG {
 		uVertexSize *= sizeof(ImDrawVert);
 		uIndexSize *= sizeof(ImDrawIdx);
 
-		m_uVertexRegionOffset = m_pRenderer->AllocateMemory(uVertexSize + uIndexSize, BufferDataType::Vertex);
+		// geometry is rebuilt every frame, thus it never needs to touch the general purpose heap
+		m_uVertexRegionOffset = m_pRenderer->AllocateFrameMemory(uVertexSize + uIndexSize, BufferDataType::Vertex);
 		
-		// check if data buffer is big enough
-		if (uVertexSize + uIndexSize > m_uDataBufferSize) {
-			delete[] m_pDataBuffer;
-			m_uDataBufferSize = ((uVertexSize + uIndexSize) * 3) >> 1;
-			m_pDataBuffer = new char[m_uDataBufferSize];
-		}
+		// vertices and indices are written straight into staging memory
+		char* pDataRegion = nullptr;
+		if (uVertexSize + uIndexSize)
+			pDataRegion = static_cast<char*>(m_pRenderer->MapBufferRegion(uVertexSize + uIndexSize, m_uVertexRegionOffset));
 
 		// create draw commands and copy data to buffers
 		size_t uOffset = 0;
@@ -147,11 +143,11 @@ namespace DENG {
 			const ImDrawVert* pVertexBuffer = pDrawList->VtxBuffer.Data;
 			const ImDrawIdx* pIndexBuffer = pDrawList->IdxBuffer.Data;
 
-			std::memcpy(m_pDataBuffer + uOffset, pDrawList->VtxBuffer.Data, static_cast<size_t>(pDrawList->VtxBuffer.Size) * sizeof(ImDrawVert));
+			std::memcpy(pDataRegion + uOffset, pDrawList->VtxBuffer.Data, static_cast<size_t>(pDrawList->VtxBuffer.Size) * sizeof(ImDrawVert));
 			uOffset += static_cast<size_t>(pDrawList->VtxBuffer.Size) * sizeof(ImDrawVert);
 			uCommandIndexOffset += static_cast<size_t>(pDrawList->VtxBuffer.Size) * sizeof(ImDrawVert);
 
-			std::memcpy(m_pDataBuffer + uOffset, pDrawList->IdxBuffer.Data, static_cast<size_t>(pDrawList->IdxBuffer.Size) * sizeof(ImDrawIdx));
+			std::memcpy(pDataRegion + uOffset, pDrawList->IdxBuffer.Data, static_cast<size_t>(pDrawList->IdxBuffer.Size) * sizeof(ImDrawIdx));
 			uOffset += static_cast<size_t>(pDrawList->IdxBuffer.Size) * sizeof(ImDrawIdx);
 
 			for (int j = 0; j < pDrawList->CmdBuffer.Size; j++) {
@@ -201,9 +197,83 @@ namespace DENG {
 			uCommandIndexOffset += static_cast<size_t>(pDrawList->IdxBuffer.Size) * sizeof(ImDrawIdx);
 			uCommandVertexOffset = uCommandIndexOffset;
 		}
+	}
 
-		if (uVertexSize + uIndexSize)
-			m_pRenderer->UpdateBuffer(m_pDataBuffer, uVertexSize + uIndexSize, m_uVertexRegionOffset);
+
+	void ImGuiLayer::DrawMemoryStatistics(const MemoryStatistics& _statistics) {
+		ImGui::Begin("Diagnostics/Main buffer memory");
+		ImGui::Text("Capacity: %zu bytes", _statistics.uCapacity);
+		ImGui::Text("Used: %zu bytes in %zu allocations", _statistics.uUsedBytes, _statistics.uAllocationCount);
+		ImGui::Text("Free: %zu bytes, largest free block %zu bytes", _statistics.uFreeBytes, _statistics.uLargestFreeBlock);
+		ImGui::Text("Free fragments: %zu (%.1f%% fragmentation)", _statistics.uFragmentCount, 100.f * _statistics.GetFragmentation());
+		ImGui::Text("High-water mark: %zu bytes", _statistics.uHighWaterMark);
+		ImGui::ProgressBar(_statistics.uCapacity ? static_cast<float>(_statistics.uUsedBytes) / static_cast<float>(_statistics.uCapacity) : 0.f);
+
+		std::array<float, MEMORY_HISTOGRAM_SIZE> histogram = {};
+		for (size_t i = 0; i < histogram.size(); i++)
+			histogram[i] = static_cast<float>(_statistics.allocationHistogram[i]);
+
+		ImGui::PlotHistogram("##histogram", histogram.data(), static_cast<int>(histogram.size()), 0, "Live allocations per 2^n byte size class",
+			0.f, FLT_MAX, ImVec2(0.f, 80.f));
+
+		if (ImGui::Button("Dump as JSON")) {
+			std::ofstream file(MEMORY_STATISTICS_DUMP_FILE);
+			file << _statistics.ToJson() << '\n';
+			LOG("Memory statistics written to " MEMORY_STATISTICS_DUMP_FILE);
+		}
+
+		ImGui::End();
+	}
+
+
+	void ImGuiLayer::DrawEventProfile() {
+		EventManager& eventManager = EventManager::GetInstance();
+		ImGui::Begin("Diagnostics/Event profile");
+
+		bool bIsProfiling = eventManager.IsProfiling();
+		if (ImGui::Checkbox("Profile dispatches", &bIsProfiling))
+			eventManager.SetProfiling(bIsProfiling);
+		ImGui::SameLine();
+		if (ImGui::Button("Reset"))
+			eventManager.GetProfiler().Reset();
+
+		if (ImGui::CollapsingHeader("Event types", ImGuiTreeNodeFlags_DefaultOpen)) {
+			for (const EventTypeProfile& profile : eventManager.GetProfiler().GetEventTypeProfiles()) {
+				const double fAverageMicroseconds = profile.uTotalDispatchCount ?
+					static_cast<double>(profile.uTotalNanoseconds) / static_cast<double>(profile.uTotalDispatchCount) / 1000.0 : 0.0;
+				ImGui::Text("%s: %llu last frame, %llu total, %u propagation steps, %.2f listeners and %.3f us per dispatch",
+					profile.szName, 
+					static_cast<unsigned long long>(profile.uLastFrameDispatchCount),
+					static_cast<unsigned long long>(profile.uTotalDispatchCount),
+					profile.uPropagationSteps,
+					profile.uTotalDispatchCount ? static_cast<double>(profile.uListenerInvocationCount) / static_cast<double>(profile.uTotalDispatchCount) : 0.0,
+					fAverageMicroseconds);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Listeners", ImGuiTreeNodeFlags_DefaultOpen)) {
+			for (const ListenerProfile& profile : eventManager.GetProfiler().GetListenerProfiles()) {
+				ImGui::PushID(profile.pInstance);
+				ImGui::PushID(static_cast<int>(profile.hshEventType));
+				if (ImGui::TreeNode("##listener", "%s listener %p: %.3f ms total", profile.szEventName, profile.pInstance, static_cast<double>(profile.uTotalNanoseconds) / 1e6)) {
+					ImGui::Text("%llu invocations, %.3f us average, %.3f us max",
+						static_cast<unsigned long long>(profile.uInvocationCount),
+						static_cast<double>(profile.uTotalNanoseconds) / static_cast<double>(profile.uInvocationCount) / 1000.0,
+						static_cast<double>(profile.uMaxNanoseconds) / 1000.0);
+
+					std::array<float, EVENT_PROFILE_HISTOGRAM_SIZE> histogram = {};
+					for (size_t i = 0; i < histogram.size(); i++)
+						histogram[i] = static_cast<float>(profile.costHistogram[i]);
+					ImGui::PlotHistogram("##histogram", histogram.data(), static_cast<int>(histogram.size()), 0, "Invocations per 2^n ns cost class",
+						0.f, FLT_MAX, ImVec2(0.f, 80.f));
+					ImGui::TreePop();
+				}
+				ImGui::PopID();
+				ImGui::PopID();
+			}
+		}
+
+		ImGui::End();
 	}
 
 
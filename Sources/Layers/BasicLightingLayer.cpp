@@ -216,8 +216,9 @@ namespace DENG {
 		resourceManager.AddShader<LightSourceShaderBuilder>(dRO_SID("WhiteCubeShader", CubeResourceTable));
 		
 		try {
-			resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("ShadedCubeDiffuseMap", CubeResourceTable), "Textures/Container/diffuse.png");
-			resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("ShadedCubeSpecularMap", CubeResourceTable), "Textures/Container/specular.png");
+			const bool bCompressionSupported = m_pRenderer->IsTextureCompressionSupported();
+			resourceManager.AddTexture<FileCompressedTextureBuilder>(dRO_SID("ShadedCubeDiffuseMap", CubeResourceTable), "Textures/Container/diffuse.png", bCompressionSupported, TextureFormat::BC1);
+			resourceManager.AddTexture<FileCompressedTextureBuilder>(dRO_SID("ShadedCubeSpecularMap", CubeResourceTable), "Textures/Container/specular.png", bCompressionSupported, TextureFormat::BC1);
 		}
 		catch (const IOException& e) {
 			DISPATCH_ERROR_MESSAGE("IOException", e.what(), ErrorSeverity::CRITICAL);
@@ -29,12 +29,12 @@ namespace DENG {
 		Texture texture;
 		ProgramFilesManager programFilesManager;
 
-		auto imageData = programFilesManager.GetProgramFileContent(m_sFileName);
+		const FileView imageData = programFilesManager.MapProgramFile(m_sFileName);
 
 		int x, y, depth;
 		stbi_uc* pTexels = stbi_load_from_memory(
-			(stbi_uc*)imageData.data(),
-			static_cast<int>(imageData.size()),
+			(const stbi_uc*)imageData.Data(),
+			static_cast<int>(imageData.Size()),
 			&x, &y, &depth, 4);
 
 		texture.bHeapAllocationFlag = true;
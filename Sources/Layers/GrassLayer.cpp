@@ -50,26 +50,19 @@ namespace DENG {
 													  dRO_SID("WindTexture", ResourceTable),
 													  dRO_SID("TerrainHeightTexture", ResourceTable));
 
-		// textures
-		try {
-			resourceManager.AddTexture<FileMonochromeTextureBuilder>(dRO_SID("TerrainHeightTexture", ResourceTable), "Textures/Terrain/Height.png");
-			resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("TerrainTexture", ResourceTable), "Textures/Terrain/Foliage.png");
-			resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("GrassTexture", ResourceTable), "Textures/Grass/grass_texture.png");
-			resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("WindTexture", ResourceTable), "Textures/Grass/wind.png");
-			resourceManager.AddTexture<FileCubeTextureBuilder>(dRO_SID("SkyboxTexture", ResourceTable),
-				"Textures/Skybox/right.jpg",
-				"Textures/Skybox/left.jpg",
-				"Textures/Skybox/top.jpg",
-				"Textures/Skybox/bottom.jpg",
-				"Textures/Skybox/front.jpg",
-				"Textures/Skybox/back.jpg");
-		}
-		catch (const IOException& e) {
-			DISPATCH_ERROR_MESSAGE("IOException", e.what(), ErrorSeverity::CRITICAL);
-		}
-		catch (const LogicException& e) {
-			DISPATCH_ERROR_MESSAGE("LogicException", e.what(), ErrorSeverity::CRITICAL);
-		}
+		// textures are decoded in parallel and show up as missing textures until they are loaded
+		resourceManager.AddTextureAsync<FileMonochromeTextureBuilder>(dRO_SID("TerrainHeightTexture", ResourceTable), "Textures/Terrain/Height.png");
+		const bool bCompressionSupported = m_pRenderer->IsTextureCompressionSupported();
+		resourceManager.AddTextureAsync<FileCompressedTextureBuilder>(dRO_SID("TerrainTexture", ResourceTable), "Textures/Terrain/Foliage.png", bCompressionSupported, TextureFormat::BC1);
+		resourceManager.AddTextureAsync<FileCompressedTextureBuilder>(dRO_SID("GrassTexture", ResourceTable), "Textures/Grass/grass_texture.png", bCompressionSupported, TextureFormat::BC3);
+		resourceManager.AddTextureAsync<FileTextureBuilder>(dRO_SID("WindTexture", ResourceTable), "Textures/Grass/wind.png");
+		resourceManager.AddTextureAsync<FileCubeTextureBuilder>(dRO_SID("SkyboxTexture", ResourceTable),
+			"Textures/Skybox/right.jpg",
+			"Textures/Skybox/left.jpg",
+			"Textures/Skybox/top.jpg",
+			"Textures/Skybox/bottom.jpg",
+			"Textures/Skybox/front.jpg",
+			"Textures/Skybox/back.jpg");
 
 		m_idSkybox = m_scene.CreateEntity();
 		auto& skybox = m_scene.EmplaceComponent<SkyboxComponent>(m_idSkybox);
@@ -35,7 +35,8 @@ namespace DENG {
 		ResourceManager& resourceManager = ResourceManager::GetInstance();
 		resourceManager.AddMesh<PBRSphereBuilder>(dRO_SID("SphereMesh", PBRTable), m_pRenderer);
 		resourceManager.AddShader<PBRShaderBuilder>(dRO_SID("PBRShader", PBRTable));
-		resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("RustAlbedo", PBRTable), "Textures/RustPBR/rustediron2_basecolor.png");
+		resourceManager.AddTexture<FileCompressedTextureBuilder>(dRO_SID("RustAlbedo", PBRTable),
+			"Textures/RustPBR/rustediron2_basecolor.png", m_pRenderer->IsTextureCompressionSupported(), TextureFormat::BC1);
 		resourceManager.AddTexture<FileMonochromeTextureBuilder>(dRO_SID("RustMetallic", PBRTable), "Textures/RustPBR/rustediron2_metallic.png");
 		//resourceManager.AddTexture<FileTextureBuilder>(dRO_SID("RustNormal", PBRTable), "Textures/RustPBR/rustediron2_normal.png");
 		resourceManager.AddTexture<FileMonochromeTextureBuilder>(dRO_SID("RustRoughness", PBRTable), "Textures/RustPBR/rustediron2_roughness.png");
@@ -9,35 +9,161 @@
 using namespace std;
 
 namespace DENG {
+
+	FileView::FileView(const string& _sAbsolutePath) {
+#ifdef _WIN32
+		HANDLE hFile = CreateFileW(filesystem::path(_sAbsolutePath).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0) {
+			CloseHandle(hFile);
+			return;
+		}
+
+		HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!hMapping) {
+			CloseHandle(hFile);
+			return;
+		}
+
+		const void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!pData) {
+			CloseHandle(hMapping);
+			CloseHandle(hFile);
+			return;
+		}
+
+		m_hFile = hFile;
+		m_hMapping = hMapping;
+		m_pData = static_cast<const char*>(pData);
+		m_uSize = static_cast<size_t>(size.QuadPart);
+#else
+		const int iFd = open(_sAbsolutePath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (iFd == -1)
+			return;
+
+		struct stat fileStat = {};
+		if (fstat(iFd, &fileStat) == -1 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0) {
+			close(iFd);
+			return;
+		}
+
+		void* pData = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, iFd, 0);
+		// mapping keeps its own reference to the file
+		close(iFd);
+		if (pData == MAP_FAILED)
+			return;
+
+		// files are almost always consumed front to back by decoders and shader compilers
+		madvise(pData, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+		m_pData = static_cast<const char*>(pData);
+		m_uSize = static_cast<size_t>(fileStat.st_size);
+#endif
+	}
+
+
+	FileView::FileView(FileView&& _view) noexcept :
+		m_pData(_view.m_pData),
+		m_uSize(_view.m_uSize)
+#ifdef _WIN32
+		, m_hFile(_view.m_hFile),
+		m_hMapping(_view.m_hMapping)
+#endif
+	{
+		_view.m_pData = nullptr;
+		_view.m_uSize = 0;
+#ifdef _WIN32
+		_view.m_hFile = nullptr;
+		_view.m_hMapping = nullptr;
+#endif
+	}
+
+
+	FileView::~FileView() {
+		_Unmap();
+	}
+
+
+	FileView& FileView::operator=(FileView&& _view) noexcept {
+		if (this != &_view) {
+			_Unmap();
+			std::swap(m_pData, _view.m_pData);
+			std::swap(m_uSize, _view.m_uSize);
+#ifdef _WIN32
+			std::swap(m_hFile, _view.m_hFile);
+			std::swap(m_hMapping, _view.m_hMapping);
+#endif
+		}
+
+		return *this;
+	}
+
+
+	void FileView::_Unmap() {
+		if (!m_pData)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+		CloseHandle(static_cast<HANDLE>(m_hMapping));
+		CloseHandle(static_cast<HANDLE>(m_hFile));
+		m_hFile = nullptr;
+		m_hMapping = nullptr;
+#else
+		munmap(const_cast<char*>(m_pData), m_uSize);
+#endif
+		m_pData = nullptr;
+		m_uSize = 0;
+	}
+
 	
 	ProgramFilesManager::ProgramFilesManager() {
-		wstring sFilePath;
-		sFilePath.reserve(256);
+#ifdef _WIN32
+		wstring sFilePath(256, L'\0');
 
-		DWORD result = 0x7a; // ERROR_INSUFFICIENT_BUFFER
-		while (result == 0x7a) {
-			sFilePath.reserve(sFilePath.capacity() + 256);
-			GetModuleFileNameW(NULL, sFilePath.data(), static_cast<DWORD>(sFilePath.capacity()));
-			result = GetLastError();
+		DWORD uLength = GetModuleFileNameW(NULL, sFilePath.data(), static_cast<DWORD>(sFilePath.size()));
+		while (uLength == static_cast<DWORD>(sFilePath.size())) {
+			sFilePath.resize(sFilePath.size() * 2);
+			uLength = GetModuleFileNameW(NULL, sFilePath.data(), static_cast<DWORD>(sFilePath.size()));
 		}
+		sFilePath.resize(uLength);
 
-		m_sParentDirectory = filesystem::path(sFilePath).parent_path().string();
+		filesystem::path parentPath = filesystem::path(sFilePath).parent_path();
+#else
+		filesystem::path parentPath;
+		try {
+			parentPath = filesystem::read_symlink("/proc/self/exe").parent_path();
+		}
+		catch (const filesystem::filesystem_error&) {
+			parentPath = filesystem::current_path();
+		}
+#endif
 
 #if !defined(DENG_WINDOWS_PACKAGE_CONFIGURATION) && !defined(DENG_PORTABLE) && !defined(DENG_DEBUG)
-		m_sParentDirectory += "..";
+		parentPath /= "..";
 #elif defined(_DEBUG)
-		m_sParentDirectory += "..";
+		parentPath /= "..";
 #endif
+		m_sParentDirectory = parentPath.string();
+	}
+
+
+	string ProgramFilesManager::_GetAbsolutePath(const string& _sPath) const {
+		return (filesystem::path(m_sParentDirectory) / _sPath).string();
 	}
 
+
 	bool ProgramFilesManager::ExistsFile(const string& _sPath) const {
-		const string sAbsolutePath = m_sParentDirectory + '\\' + _sPath;
+		const string sAbsolutePath = _GetAbsolutePath(_sPath);
 		return filesystem::exists(sAbsolutePath) && filesystem::is_regular_file(sAbsolutePath);
 	}
 
 
 	size_t ProgramFilesManager::FileSize(const string& _sPath) const {
-		const string sAbsolutePath = m_sParentDirectory + '\\' + _sPath;
+		const string sAbsolutePath = _GetAbsolutePath(_sPath);
 		size_t size = 0; 
 		try {
 			size = static_cast<size_t>(filesystem::file_size(sAbsolutePath));
@@ -52,7 +178,7 @@ namespace DENG {
 
 
 	time_t ProgramFilesManager::GetFileTimestamp(const string& _sPath) const {
-		const string sAbsolutePath = m_sParentDirectory + '\\' + _sPath;
+		const string sAbsolutePath = _GetAbsolutePath(_sPath);
 		filesystem::file_time_type tTimestamp; 
 		
 		try {
@@ -67,28 +193,19 @@ namespace DENG {
 	}
 
 
-	vector<char>&& ProgramFilesManager::GetProgramFileContent(const string& _sPath) const {
-		vector<char> output;
-		const std::string sAbsolutePath = m_sParentDirectory + '\\' + _sPath;
-
-		if (filesystem::exists(sAbsolutePath) && filesystem::is_regular_file(sAbsolutePath)) {
-			ifstream stream(sAbsolutePath, ios_base::binary);
-			
-			stream.seekg(0, ios_base::end);
-			size_t uFileSize = stream.tellg();
-			stream.seekg(0, ios_base::beg);
+	vector<char> ProgramFilesManager::GetProgramFileContent(const string& _sPath) const {
+		const FileView view = MapProgramFile(_sPath);
+		return vector<char>(view.Data(), view.Data() + view.Size());
+	}
 
-			output.resize(uFileSize);
-			stream.read(output.data(), uFileSize);
-			stream.close();
-		}
 
-		return std::move(output);
+	FileView ProgramFilesManager::MapProgramFile(const string& _sPath) const {
+		return FileView(_GetAbsolutePath(_sPath));
 	}
 
 
 	void ProgramFilesManager::WriteProgramFile(const vector<char>& _data, const string& _sFilePath) const {
-		const string sAbsolutePath = m_sParentDirectory + '\\' + _sFilePath;
+		const string sAbsolutePath = _GetAbsolutePath(_sFilePath);
 		const filesystem::path parentPath = filesystem::path(sAbsolutePath).parent_path();
 
 		if (!filesystem::exists(parentPath)) {
@@ -108,7 +225,7 @@ namespace DENG {
 
 
 	void ProgramFilesManager::WriteProgramFile(const char* _pBytes, size_t _uByteCount, const string& _sFilePath) const {
-		const string sAbsolutePath = m_sParentDirectory + '\\' + _sFilePath;
+		const string sAbsolutePath = _GetAbsolutePath(_sFilePath);
 		const filesystem::path parentPath = filesystem::path(sAbsolutePath).parent_path();
 
 		if (!filesystem::exists(parentPath)) {
@@ -124,4 +241,38 @@ namespace DENG {
 		stream.write(_pBytes, _uByteCount);
 		stream.close();
 	}
+
+
+	void ProgramFilesManager::ReplaceProgramFile(const char* _pBytes, size_t _uByteCount, const string& _sFilePath) const {
+		const string sAbsolutePath = _GetAbsolutePath(_sFilePath);
+		const filesystem::path parentPath = filesystem::path(sAbsolutePath).parent_path();
+
+#ifdef _WIN32
+		const unsigned long uProcessId = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+		const unsigned long uProcessId = static_cast<unsigned long>(getpid());
+#endif
+		// temporary file name is unique per writing thread, so that concurrent writers do not interleave
+		const string sTemporaryPath = sAbsolutePath + '.' + to_string(uProcessId) + '.' +
+			to_string(hash<thread::id>{}(this_thread::get_id())) + ".tmp";
+
+		try {
+			filesystem::create_directories(parentPath);
+
+			ofstream stream(sTemporaryPath, ios_base::binary | ios_base::trunc);
+			stream.write(_pBytes, _uByteCount);
+			stream.close();
+			if (stream.fail()) {
+				filesystem::remove(sTemporaryPath);
+				throw IOException("Failed to write file " + sTemporaryPath);
+			}
+
+			filesystem::rename(sTemporaryPath, sAbsolutePath);
+		}
+		catch (const filesystem::filesystem_error& e) {
+			error_code errorCode;
+			filesystem::remove(sTemporaryPath, errorCode);
+			throw IOException(e.what());
+		}
+	}
 }
\ No newline at end of file
@@ -13,172 +13,333 @@ namespace DENG {
 	{
 		EventManager& eventManager = EventManager::GetInstance();
 		eventManager.AddListener<Scene, ComponentModifiedEvent>(&Scene::OnComponentModifiedEvent, this);
+		eventManager.AddListener<Scene, ComponentAddedEvent>(&Scene::OnComponentAddedEvent, this);
+		eventManager.AddListener<Scene, ComponentRemoveEvent>(&Scene::OnComponentRemoveEvent, this);
 		eventManager.AddListener<Scene, ResourceModifiedEvent>(&Scene::OnResourceModifiedEvent, this);
 	}
 
 	Scene::~Scene() {
 		EventManager& eventManager = EventManager::GetInstance();
 		eventManager.RemoveListener<Scene, ComponentModifiedEvent>(this);
+		eventManager.RemoveListener<Scene, ComponentAddedEvent>(this);
+		eventManager.RemoveListener<Scene, ComponentRemoveEvent>(this);
 		eventManager.RemoveListener<Scene, ResourceModifiedEvent>(this);
 	}
 
 
-	std::vector<std::pair<std::size_t, std::size_t>> Scene::_MakeMemoryRegions(const std::set<std::size_t>& _updateSet) {
-		std::vector<std::pair<std::size_t, std::size_t>> memoryRegions;
-		std::size_t uPrevTransformId = 0;
-		for (auto it = _updateSet.begin(); it != _updateSet.end(); it++) {
-			if (it == _updateSet.begin())
-				memoryRegions.emplace_back(std::make_pair(*it, *it));
-			else if (*it - uPrevTransformId < 3)
-				memoryRegions.back().second = *it;
-			else
-				memoryRegions.emplace_back(std::make_pair(*it, *it));
+	uint32_t Scene::_FindOrCreateBatch(const _BatchKey& _key, uint32_t _uCapacity) {
+		auto it = m_batchLookup.find(_key);
+		if (it != m_batchLookup.end())
+			return it->second;
 
-			uPrevTransformId = *it;
-		}
+		if (_uCapacity < INSTANCE_BATCH_MIN_CAPACITY)
+			_uCapacity = INSTANCE_BATCH_MIN_CAPACITY;
+
+		InstanceInfo& instanceInfo = m_instances.instanceInfos.emplace_back();
+		instanceInfo.hshMesh = std::get<0>(_key);
+		instanceInfo.hshShader = std::get<1>(_key);
+		instanceInfo.hshMaterial = std::get<2>(_key);
+		instanceInfo.uInstanceCount = 0;
+		instanceInfo.uFirstInstance = static_cast<uint32_t>(m_instances.drawDescriptorIndices.size());
+		instanceInfo.uCapacity = _uCapacity;
 
-		return memoryRegions;
+		m_instances.drawDescriptorIndices.resize(m_instances.drawDescriptorIndices.size() + _uCapacity);
+		m_instances.descriptorOwners.resize(m_instances.descriptorOwners.size() + _uCapacity, entt::null);
+
+		const uint32_t uBatch = static_cast<uint32_t>(m_instances.instanceInfos.size() - 1);
+		m_batchLookup.emplace(_key, uBatch);
+		return uBatch;
 	}
 
-	void Scene::_CorrectMeshResources() {
-		// check if meshes have to be reinstanced
-		if (m_bmCopyFlags & RendererCopyFlagBit_Reinstance) {
-			_InstanceRenderablesMSM();
-		}
-		else if (m_modifiedTransforms.size()) {
-			std::vector<std::pair<std::size_t, std::size_t>> transformUpdateAreas =
-				_MakeMemoryRegions(m_modifiedTransforms);
-
-			for (auto it = transformUpdateAreas.begin(); it != transformUpdateAreas.end(); it++) {
-				m_sceneRenderer.UpdateTransformRegion(
-					m_instances.transforms.data() + it->first,
-					it->first,
-					it->second - it->first + 1);
-			}
+	// moves a full batch to the end of the descriptor array with doubled capacity, the old range becomes unused
+	void Scene::_GrowBatch(uint32_t _uBatch) {
+		InstanceInfo& instanceInfo = m_instances.instanceInfos[_uBatch];
+		const uint32_t uFirst = static_cast<uint32_t>(m_instances.drawDescriptorIndices.size());
+		const uint32_t uCapacity = instanceInfo.uCapacity << 1;
+
+		m_instances.drawDescriptorIndices.resize(m_instances.drawDescriptorIndices.size() + uCapacity);
+		m_instances.descriptorOwners.resize(m_instances.descriptorOwners.size() + uCapacity, entt::null);
+
+		for (uint32_t i = 0; i < instanceInfo.uInstanceCount; i++) {
+			const uint32_t uOld = instanceInfo.uFirstInstance + i;
+			const Entity idOwner = m_instances.descriptorOwners[uOld];
 
-			m_modifiedTransforms.clear();
+			m_instances.drawDescriptorIndices[uFirst + i] = m_instances.drawDescriptorIndices[uOld];
+			m_instances.descriptorOwners[uFirst + i] = idOwner;
+			m_instances.descriptorOwners[uOld] = entt::null;
+			_GetRenderableSlot(idOwner).uDescriptor = uFirst + i;
 		}
+
+		m_modifiedDrawDescriptors.SetRange(uFirst, instanceInfo.uInstanceCount);
+		instanceInfo.uFirstInstance = uFirst;
+		instanceInfo.uCapacity = uCapacity;
 	}
 
-	void Scene::_CorrectLightResources() {
-		// check if light sources need to be recopied
-		if (m_bmCopyFlags & (RendererCopyFlagBit_CopyDirectionalLights | RendererCopyFlagBit_CopySpotLights | RendererCopyFlagBit_CopyPointLights)) {
-			_RenderLights();
+	int32_t Scene::_IndexMaterial(cvar::hash_t _hshMaterial) {
+		auto it = m_materialIndexLookup.find(_hshMaterial);
+		if (it != m_materialIndexLookup.end())
+			return static_cast<int32_t>(it->second);
+
+		if (!_hshMaterial)
+			return 0;
+
+		ResourceManager& resourceManager = ResourceManager::GetInstance();
+		std::size_t uMaterialIndex = 0;
+		if (resourceManager.ExistsMaterialPBR(_hshMaterial)) {
+			auto pMaterial = resourceManager.GetMaterialPBR(_hshMaterial);
+			m_instances.pbrMaterials.emplace_back(pMaterial->material);
+			uMaterialIndex = m_instances.pbrMaterials.size() - 1;
+			m_modifiedPbrMaterials.Set(uMaterialIndex);
+		}
+		else if (resourceManager.ExistsMaterialPhong(_hshMaterial)) {
+			auto pMaterial = resourceManager.GetMaterialPhong(_hshMaterial);
+			m_instances.phongMaterials.emplace_back(pMaterial->material);
+			uMaterialIndex = m_instances.phongMaterials.size() - 1;
+			m_modifiedPhongMaterials.Set(uMaterialIndex);
 		}
 		else {
-			if (m_modifiedDirLights.size()) {
-				std::vector<std::pair<std::size_t, std::size_t>> dirLightUpdateAreas =
-					_MakeMemoryRegions(m_modifiedDirLights);
-
-				for (auto it = dirLightUpdateAreas.begin(); it != dirLightUpdateAreas.end(); it++) {
-					m_sceneRenderer.UpdateDirLightRegion(
-						m_lights.dirLights.data() + it->first,
-						it->first,
-						it->second - it->first + 1);
-				}
+			return 0;
+		}
+
+		m_materialIndexLookup[_hshMaterial] = uMaterialIndex;
+		return static_cast<int32_t>(uMaterialIndex);
+	}
+
+	uint32_t Scene::_AllocateTransformSlot() {
+		if (m_freeTransformSlots.size()) {
+			const uint32_t uSlot = m_freeTransformSlots.back();
+			m_freeTransformSlots.pop_back();
+			return uSlot;
+		}
+
+		m_instances.transforms.emplace_back();
+		m_instances.transformOwners.emplace_back(entt::null);
+		return static_cast<uint32_t>(m_instances.transforms.size() - 1);
+	}
+
+	// copies modified TransformComponents into their slots and calculates normal matrices in parallel chunks
+	void Scene::_CalculateTransforms(const std::vector<std::pair<std::size_t, std::size_t>>& _regions) {
+		m_transformJobs.clear();
+		for (auto it = _regions.begin(); it != _regions.end(); it++) {
+			for (std::size_t uFirst = it->first; uFirst <= it->second; uFirst += TRANSFORM_JOB_CHUNK_SIZE) {
+				const std::size_t uLast = uFirst + TRANSFORM_JOB_CHUNK_SIZE - 1 < it->second ? uFirst + TRANSFORM_JOB_CHUNK_SIZE - 1 : it->second;
+				m_transformJobs.emplace_back(uFirst, uLast);
 			}
+		}
 
-			if (m_modifiedPointLights.size()) {
-				std::vector<std::pair<std::size_t, std::size_t>> ptLightUpdateAreas =
-					_MakeMemoryRegions(m_modifiedPointLights);
+		auto view = m_registry.view<TransformComponent>();
+		ThreadPool::GetInstance().ParallelFor(m_transformJobs.size(), 1, [this, &view](std::size_t _uBegin, std::size_t _uEnd) {
+			// per worker scratch space: gathered euler angles followed by rotation and normal matrix elements
+			thread_local std::vector<TransformComponent*> components;
+			thread_local std::vector<uint32_t> slots;
+			thread_local std::vector<float> scratch;
+
+			for (std::size_t i = _uBegin; i < _uEnd; i++) {
+				components.clear();
+				slots.clear();
+				for (std::size_t uSlot = m_transformJobs[i].first; uSlot <= m_transformJobs[i].second; uSlot++) {
+					const Entity idOwner = m_instances.transformOwners[uSlot];
+					if (idOwner == entt::null)
+						continue;
+
+					components.push_back(&view.get<TransformComponent>(idOwner));
+					slots.push_back(static_cast<uint32_t>(uSlot));
+				}
 
-				for (auto it = ptLightUpdateAreas.begin(); it != ptLightUpdateAreas.end(); it++) {
-					m_sceneRenderer.UpdatePointLightRegion(
-						m_lights.pointLights.data() + it->first,
-						it->first,
-						it->second - it->first + 1);
+				const std::size_t uCount = components.size();
+				scratch.resize(uCount * 21);
+				float* pRotationX = scratch.data();
+				float* pRotationY = pRotationX + uCount;
+				float* pRotationZ = pRotationY + uCount;
+				Matrix3SoA rotations, normals;
+				for (std::size_t j = 0; j < 9; j++) {
+					rotations.arrElements[j] = pRotationZ + uCount * (j + 1);
+					normals.arrElements[j] = pRotationZ + uCount * (j + 10);
 				}
-			}
 
-			if (m_modifiedSpotLights.size()) {
-				std::vector<std::pair<std::size_t, std::size_t>> spotLightUpdateAreas =
-					_MakeMemoryRegions(m_modifiedSpotLights);
+				for (std::size_t j = 0; j < uCount; j++) {
+					pRotationX[j] = components[j]->vRotation.first;
+					pRotationY[j] = components[j]->vRotation.second;
+					pRotationZ[j] = components[j]->vRotation.third;
+				}
 
-				for (auto it = spotLightUpdateAreas.begin(); it != spotLightUpdateAreas.end(); it++) {
-					m_sceneRenderer.UpdateSpotLightRegion(
-						m_lights.spotLights.data() + it->first,
-						it->first,
-						it->second - it->first + 1);
+				TransformKernels::CalculateRotations(pRotationX, pRotationY, pRotationZ, uCount, rotations, normals);
+
+				for (std::size_t j = 0; j < uCount; j++) {
+					TransformComponent& transform = *components[j];
+					transform.mNormal = {
+						{ normals.arrElements[0][j], normals.arrElements[1][j], normals.arrElements[2][j], 0.f },
+						{ normals.arrElements[3][j], normals.arrElements[4][j], normals.arrElements[5][j], 0.f },
+						{ normals.arrElements[6][j], normals.arrElements[7][j], normals.arrElements[8][j], 0.f },
+						{ 0.f, 0.f, 0.f, 1.f }
+					};
+					m_instances.transforms[slots[j]] = transform;
 				}
 			}
+		});
+	}
 
-			m_modifiedDirLights.clear();
-			m_modifiedSpotLights.clear();
-			m_modifiedPointLights.clear();
+	// (re)inserts a renderable entity into the batch matching its current mesh, shader and material
+	void Scene::_AddInstance(Entity _idEntity) {
+		_RemoveInstance(_idEntity);
+		if (!m_registry.valid(_idEntity) || !m_registry.all_of<MeshComponent, ShaderComponent, MaterialComponent>(_idEntity))
+			return;
+
+		auto [mesh, shader, material] = m_registry.get<MeshComponent, ShaderComponent, MaterialComponent>(_idEntity);
+		const uint32_t uBatch = _FindOrCreateBatch(std::make_tuple(mesh.hshMesh, shader.hshShader, material.hshMaterial), INSTANCE_BATCH_MIN_CAPACITY);
+		if (m_instances.instanceInfos[uBatch].uInstanceCount == m_instances.instanceInfos[uBatch].uCapacity)
+			_GrowBatch(uBatch);
+
+		InstanceInfo& instanceInfo = m_instances.instanceInfos[uBatch];
+		RenderableSlot slot;
+		slot.uBatch = uBatch;
+		slot.uDescriptor = instanceInfo.uFirstInstance + instanceInfo.uInstanceCount;
+
+		// transform data itself is filled in by _CalculateTransforms before the upload
+		int32_t iTransformIndex = -1;
+		if (m_registry.any_of<TransformComponent>(_idEntity)) {
+			slot.uTransform = _AllocateTransformSlot();
+			m_instances.transformOwners[slot.uTransform] = _idEntity;
+			m_modifiedTransforms.Set(slot.uTransform);
+			iTransformIndex = static_cast<int32_t>(slot.uTransform);
 		}
+
+		m_instances.drawDescriptorIndices[slot.uDescriptor] = DrawDescriptorIndices(iTransformIndex, _IndexMaterial(material.hshMaterial));
+		m_instances.descriptorOwners[slot.uDescriptor] = _idEntity;
+		m_modifiedDrawDescriptors.Set(slot.uDescriptor);
+
+		instanceInfo.uInstanceCount++;
+		m_uInstanceCount++;
+		_GetRenderableSlot(_idEntity) = slot;
 	}
 
-	void Scene::_InstanceRenderablesMSM() {
+	// removes entity from its batch by moving the last instance of the batch into its place
+	void Scene::_RemoveInstance(Entity _idEntity) {
+		if (!_FindRenderableSlot(_idEntity))
+			return;
+
+		RenderableSlot& entitySlot = _GetRenderableSlot(_idEntity);
+		const RenderableSlot slot = entitySlot;
+		entitySlot = RenderableSlot();
+
+		InstanceInfo& instanceInfo = m_instances.instanceInfos[slot.uBatch];
+		const uint32_t uLast = instanceInfo.uFirstInstance + instanceInfo.uInstanceCount - 1;
+		if (slot.uDescriptor != uLast) {
+			const Entity idMoved = m_instances.descriptorOwners[uLast];
+			m_instances.drawDescriptorIndices[slot.uDescriptor] = m_instances.drawDescriptorIndices[uLast];
+			m_instances.descriptorOwners[slot.uDescriptor] = idMoved;
+			_GetRenderableSlot(idMoved).uDescriptor = slot.uDescriptor;
+			m_modifiedDrawDescriptors.Set(slot.uDescriptor);
+		}
+
+		m_instances.descriptorOwners[uLast] = entt::null;
+		instanceInfo.uInstanceCount--;
+		m_uInstanceCount--;
+
+		if (slot.uTransform != INVALID_INSTANCE_SLOT) {
+			m_instances.transformOwners[slot.uTransform] = entt::null;
+			m_freeTransformSlots.push_back(slot.uTransform);
+		}
+	}
+
+	void Scene::_ResetInstances() {
 		m_instances.instanceInfos.clear();
 		m_instances.transforms.clear();
 		m_instances.pbrMaterials.clear();
 		m_instances.phongMaterials.clear();
 		m_instances.drawDescriptorIndices.clear();
-		m_renderableInstanceLookup.clear();
-		
-		std::unordered_map<cvar::hash_t, size_t, cvar::NoHash> materialIndexLookup;
-		ResourceManager& resourceManager = ResourceManager::GetInstance();
+		m_instances.descriptorOwners.clear();
+		m_instances.transformOwners.clear();
+
+		std::fill(m_renderableSlots.begin(), m_renderableSlots.end(), RenderableSlot());
+		m_batchLookup.clear();
+		m_materialIndexLookup.clear();
+		m_freeTransformSlots.clear();
+		m_uInstanceCount = 0;
+	}
+
+	void Scene::_ClearInstanceDirtyFlags() {
+		m_modifiedTransforms.Clear();
+		m_modifiedDrawDescriptors.Clear();
+		m_modifiedPbrMaterials.Clear();
+		m_modifiedPhongMaterials.Clear();
+	}
+
+	void Scene::_CorrectMeshResources() {
+		// compact descriptor storage once relocated batches leave more unused slots than there are instances
+		if (m_instances.drawDescriptorIndices.size() > 2 * m_uInstanceCount + INSTANCE_BATCH_MIN_CAPACITY * m_instances.instanceInfos.size()) {
+			m_bmCopyFlags |= RendererCopyFlagBit_Reinstance;
+		}
+
+		// check if meshes have to be reinstanced
+		if (m_bmCopyFlags & RendererCopyFlagBit_Reinstance) {
+			_InstanceRenderablesMSM();
+			return;
+		}
+
+		if (m_modifiedTransforms.Any())
+			_CalculateTransforms(m_modifiedTransforms.MakeRegions());
+
+		if (m_sceneRenderer.IsStorageReallocationRequired(m_instances.transforms, m_instances.pbrMaterials, m_instances.phongMaterials, m_instances.drawDescriptorIndices)) {
+			m_sceneRenderer.UpdateStorageBuffers(
+				m_instances.transforms,
+				m_instances.pbrMaterials,
+				m_instances.phongMaterials,
+				m_instances.drawDescriptorIndices);
+			_ClearInstanceDirtyFlags();
+		}
+		else {
+			// transform regions were already built for _CalculateTransforms
+			if (m_modifiedTransforms.Any()) {
+				_UploadRegions(m_modifiedTransforms.GetRegions(), m_instances.transforms, &SceneRenderer::UpdateTransformRegion);
+				m_modifiedTransforms.Clear();
+			}
+			_UploadDirtyRegions(m_modifiedDrawDescriptors, m_instances.drawDescriptorIndices, &SceneRenderer::UpdateDrawDescriptorIndicesRegion);
+			_UploadDirtyRegions(m_modifiedPbrMaterials, m_instances.pbrMaterials, &SceneRenderer::UpdatePbrMaterialRegion);
+			_UploadDirtyRegions(m_modifiedPhongMaterials, m_instances.phongMaterials, &SceneRenderer::UpdatePhongMaterialRegion);
+		}
+	}
+
+	void Scene::_CorrectLightResources() {
+		// check if light sources need to be recopied
+		if (m_bmCopyFlags & (RendererCopyFlagBit_CopyDirectionalLights | RendererCopyFlagBit_CopySpotLights | RendererCopyFlagBit_CopyPointLights)) {
+			_RenderLights();
+			m_modifiedDirLights.Clear();
+			m_modifiedSpotLights.Clear();
+			m_modifiedPointLights.Clear();
+		}
+		else {
+			_UploadDirtyRegions(m_modifiedDirLights, m_lights.dirLights, &SceneRenderer::UpdateDirLightRegion);
+			_UploadDirtyRegions(m_modifiedPointLights, m_lights.pointLights, &SceneRenderer::UpdatePointLightRegion);
+			_UploadDirtyRegions(m_modifiedSpotLights, m_lights.spotLights, &SceneRenderer::UpdateSpotLightRegion);
+		}
+	}
+
+	// full rebuild, batches are laid out tightly in mesh, shader and material order
+	void Scene::_InstanceRenderablesMSM() {
+		_ResetInstances();
+
 		auto group = m_registry.group<MeshComponent, ShaderComponent, MaterialComponent>();
 		
-		for (auto it = group.begin(); it != group.end(); it++) {
-			auto& [mesh, shader, material] = group.get<MeshComponent, ShaderComponent, MaterialComponent>(*it);
-			const bool bHasTransform = m_registry.any_of<TransformComponent>(*it);
-
-			if (it != group.begin()) {
-				auto itPrev = it - 1;
-				auto& [prevMesh, prevShader, prevMaterial] = group.get<MeshComponent, ShaderComponent, MaterialComponent>(*itPrev);
-
-				if (mesh == prevMesh && shader == prevShader && material == prevMaterial) {
-					m_renderableInstanceLookup[*it] = std::make_pair(
-						m_instances.instanceInfos.size() - 1,
-						static_cast<size_t>(m_instances.instanceInfos.back().uInstanceCount));
-					m_instances.instanceInfos.back().uInstanceCount++;
-				}
-				else {
-					m_instances.instanceInfos.emplace_back();
-					m_instances.instanceInfos.back().hshMesh = mesh.hshMesh;
-					m_instances.instanceInfos.back().hshShader = shader.hshShader;
-					m_instances.instanceInfos.back().hshMaterial = material.hshMaterial;
-				
-					m_renderableInstanceLookup[*it] = std::make_pair(
-						m_instances.instanceInfos.size() - 1, 0);
-				}
-			}
-			else {
-				m_instances.instanceInfos.emplace_back();
-				m_instances.instanceInfos.back().hshMesh = mesh.hshMesh;
-				m_instances.instanceInfos.back().hshShader = shader.hshShader;
-				m_instances.instanceInfos.back().hshMaterial = material.hshMaterial;
-
-				m_renderableInstanceLookup[*it] = std::make_pair(
-					m_instances.instanceInfos.size() - 1, 0);
-			}
+		std::map<_BatchKey, uint32_t> batchSizes;
+		for (Entity idEntity : group) {
+			auto [mesh, shader, material] = group.get<MeshComponent, ShaderComponent, MaterialComponent>(idEntity);
+			batchSizes[std::make_tuple(mesh.hshMesh, shader.hshShader, material.hshMaterial)]++;
+		}
 
-			// material indexing
-			if (material.hshMaterial && materialIndexLookup.find(material.hshMaterial) == materialIndexLookup.end()) {
-				if (resourceManager.ExistsMaterialPBR(material.hshMaterial)) {
-					auto pMaterial = resourceManager.GetMaterialPBR(material.hshMaterial);
-					m_instances.pbrMaterials.emplace_back(pMaterial->material);
-					materialIndexLookup[material.hshMaterial] = m_instances.pbrMaterials.size() - 1;
-				}
-				else if (resourceManager.ExistsMaterialPhong(material.hshMaterial)) {
-					auto pMaterial = resourceManager.GetMaterialPhong(material.hshMaterial);
-					m_instances.phongMaterials.emplace_back(pMaterial->material);
-					materialIndexLookup[material.hshMaterial] = m_instances.phongMaterials.size() - 1;
-				}
-			}
+		// leave some headroom in each batch for entities spawned later
+		for (auto it = batchSizes.begin(); it != batchSizes.end(); it++) {
+			_FindOrCreateBatch(it->first, it->second + (it->second >> 2));
+		}
 
-			if (bHasTransform) {
-				auto& transform = m_registry.get<TransformComponent>(*it);
-				transform.CalculateNormalMatrix();
-				m_instances.transforms.emplace_back(transform);
-				m_instances.drawDescriptorIndices.emplace_back(
-					static_cast<int32_t>(m_instances.transforms.size() - 1),
-					static_cast<int32_t>(materialIndexLookup[material.hshMaterial]));
-			}
-			else {
-				m_instances.drawDescriptorIndices.emplace_back(-1, static_cast<int32_t>(materialIndexLookup[material.hshMaterial]));
-			}
+		m_instances.transforms.reserve(group.size());
+		m_instances.transformOwners.reserve(group.size());
+		for (Entity idEntity : group) {
+			_AddInstance(idEntity);
+		}
+
+		if (m_instances.transforms.size()) {
+			_CalculateTransforms({ std::make_pair(std::size_t(0), m_instances.transforms.size() - 1) });
 		}
 
 		m_sceneRenderer.UpdateStorageBuffers(
@@ -186,6 +347,10 @@ namespace DENG {
 			m_instances.pbrMaterials,
 			m_instances.phongMaterials,
 			m_instances.drawDescriptorIndices);
+		_ClearInstanceDirtyFlags();
+
+		m_modifiedTransforms.Reserve(m_instances.transforms.size());
+		m_modifiedDrawDescriptors.Reserve(m_instances.drawDescriptorIndices.size());
 	}
 
 	void Scene::_SortRenderableGroup() {
@@ -287,6 +452,7 @@ namespace DENG {
 		_UpdateScripts();
 		_CorrectMeshResources();
 		_CorrectLightResources();
+		m_sceneRenderer.FlushRegionUpdates();
 		_DrawMeshes();
 		m_bmCopyFlags = RendererCopyFlagBit_None;
 	}
@@ -303,38 +469,29 @@ namespace DENG {
 	}
 
 	bool Scene::OnComponentModifiedEvent(ComponentModifiedEvent& _event) {
+		// mesh, shader or material changed, move the entity into its new batch
+		if (_event.GetComponentType() & ComponentType_Renderable) {
+			_AddInstance(_event.GetEntity());
+		}
 		// renderable transform modified
-		if ((_event.GetComponentType() & ComponentType_Transform) && 
+		else if ((_event.GetComponentType() & ComponentType_Transform) && 
 			!m_registry.any_of<DirectionalLightComponent, PointLightComponent, SpotlightComponent>(_event.GetEntity())) 
 		{
-			DENG_ASSERT(m_renderableInstanceLookup.find(_event.GetEntity()) != m_renderableInstanceLookup.end());
-		
-			const std::size_t uDrawCallId = m_renderableInstanceLookup[_event.GetEntity()].first;
-			std::size_t uInstanceId = m_renderableInstanceLookup[_event.GetEntity()].second;
-		
-			for (std::size_t i = 0; i < uDrawCallId; i++) {
-				uInstanceId += static_cast<std::size_t>(m_instances.instanceInfos[i].uInstanceCount);
-			}
-
-			auto& transform = m_registry.get<TransformComponent>(_event.GetEntity());
-			transform.CalculateNormalMatrix();
-			m_instances.transforms[uInstanceId] = transform;
-			m_modifiedTransforms.insert(uInstanceId);
-		}
-		// other renderable component modified
-		else if (_event.GetComponentType() & ComponentType_Renderable) {
-			m_bmCopyFlags |= RendererCopyFlagBit_Reinstance;
+			// normal matrix and slot copy are deferred to the batched transform stage in _CorrectMeshResources
+			const RenderableSlot* pSlot = _FindRenderableSlot(_event.GetEntity());
+			if (pSlot && pSlot->uTransform != INVALID_INSTANCE_SLOT)
+				m_modifiedTransforms.Set(static_cast<std::size_t>(pSlot->uTransform));
 		}
 		// light modified
 		else if (_event.GetComponentType() & ComponentType_Light) {
 			DENG_ASSERT(m_lightLookup.find(_event.GetEntity()) != m_lightLookup.end());
 			
 			if (_event.GetComponentType() & ComponentType_DirectionalLight)
-				m_modifiedDirLights.insert(m_lightLookup[_event.GetEntity()]);
+				m_modifiedDirLights.Set(m_lightLookup[_event.GetEntity()]);
 			if (_event.GetComponentType() & ComponentType_PointLight)
-				m_modifiedPointLights.insert(m_lightLookup[_event.GetEntity()]);
+				m_modifiedPointLights.Set(m_lightLookup[_event.GetEntity()]);
 			if (_event.GetComponentType() & ComponentType_SpotLight)
-				m_modifiedSpotLights.insert(m_lightLookup[_event.GetEntity()]);
+				m_modifiedSpotLights.Set(m_lightLookup[_event.GetEntity()]);
 		}
 		// skybox modified
 		else if (_event.GetComponentType() & ComponentType_Skybox) {
@@ -345,8 +502,37 @@ namespace DENG {
 		return true;
 	}
 
+	bool Scene::OnComponentAddedEvent(ComponentAddedEvent& _event) {
+		if (_event.GetComponentType() & (ComponentType_Renderable | ComponentType_Transform))
+			_AddInstance(_event.GetEntity());
+		return true;
+	}
+
+	// expected to be dispatched after the component (or the whole entity) has been removed from the registry
+	bool Scene::OnComponentRemoveEvent(ComponentRemoveEvent& _event) {
+		if (_event.GetComponentType() & ComponentType_Renderable)
+			_RemoveInstance(_event.GetEntity());
+		else if (_event.GetComponentType() & ComponentType_Transform)
+			_AddInstance(_event.GetEntity());
+		return true;
+	}
+
 	bool Scene::OnResourceModifiedEvent(ResourceModifiedEvent& _event) {
-		m_bmCopyFlags |= RendererCopyFlagBit_Reinstance;
+		// instance data only references meshes, shaders and textures by their hash, so only material data needs patching
+		auto it = m_materialIndexLookup.find(_event.GetResourceHash());
+		if (it == m_materialIndexLookup.end())
+			return true;
+
+		ResourceManager& resourceManager = ResourceManager::GetInstance();
+		if (_event.GetType() == ResourceType::Material_PBR && resourceManager.ExistsMaterialPBR(it->first)) {
+			m_instances.pbrMaterials[it->second] = resourceManager.GetMaterialPBR(it->first)->material;
+			m_modifiedPbrMaterials.Set(it->second);
+		}
+		else if (_event.GetType() == ResourceType::Material_Phong && resourceManager.ExistsMaterialPhong(it->first)) {
+			m_instances.phongMaterials[it->second] = resourceManager.GetMaterialPhong(it->first)->material;
+			m_modifiedPhongMaterials.Set(it->second);
+		}
+
 		return true;
 	}
-}
\ No newline at end of file
+}
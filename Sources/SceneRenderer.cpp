@@ -12,9 +12,7 @@ namespace DENG {
 		m_pRenderer(_pRenderer),
 		m_pFramebuffer(_pFramebuffer) {}
 
-	SceneRenderer::~SceneRenderer() {
-		delete[] m_pIntermediateStorageBuffer;
-	}
+	SceneRenderer::~SceneRenderer() {}
 
 	void SceneRenderer::RenderLights(
 		const std::vector<PointLightComponent>& _pointLights,
@@ -22,29 +20,29 @@ namespace DENG {
 		const std::vector<SpotlightComponent>& _spotLights,
 		const TRS::Vector3<float>& _vAmbient) 
 	{
-		// check if intermediate buffer reallocation is required
+		// check if light region reallocation is required
 		m_uUsedLightsSize = MAX_FRAMES_IN_FLIGHT * (_pointLights.size() * sizeof(PointLightComponent) +
 			_dirLights.size() * sizeof(DirectionalLightComponent) +
 			_spotLights.size() * sizeof(SpotlightComponent) + sizeof(TRS::Vector4<float>) + sizeof(TRS::Vector4<uint32_t>));
 
-		if (m_uUsedLightsSize > m_uIntermediateStorageBufferSize) {
-			delete[] m_pIntermediateStorageBuffer;
-			m_uIntermediateStorageBufferSize = (m_uUsedLightsSize * 3) >> 1;
-			m_pIntermediateStorageBuffer = new char[m_uIntermediateStorageBufferSize]{};
+		if (m_uUsedLightsSize > m_uLightsRegionSize) {
+			m_uLightsRegionSize = (m_uUsedLightsSize * 3) >> 1;
 
 			// deallocate and allocate on device memory
 			if (m_arrLightOffsets[0] != SIZE_MAX)
 				m_pRenderer->DeallocateMemory(m_arrLightOffsets[0]);
-			m_arrLightOffsets[0] = m_pRenderer->AllocateMemory(m_uIntermediateStorageBufferSize, BufferDataType::Uniform);
+			m_arrLightOffsets[0] = m_pRenderer->AllocateMemory(m_uLightsRegionSize, BufferDataType::Uniform);
 		}
 
+		// light data is written straight into staging memory
+		char* pLightsRegion = static_cast<char*>(m_pRenderer->MapBufferRegion(m_uUsedLightsSize, m_arrLightOffsets[0]));
 		size_t uOffset = 0;
 		m_arrLightOffsets[1] = m_arrLightOffsets[0];
 		m_arrLightOffsets[2] = m_arrLightOffsets[0];
 
 		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			TRS::Vector4<float> vAmbient = { _vAmbient[0], _vAmbient[1], _vAmbient[2], 0.f };
-			std::memcpy(m_pIntermediateStorageBuffer + uOffset, &vAmbient, sizeof(TRS::Vector4<float>));
+			std::memcpy(pLightsRegion + uOffset, &vAmbient, sizeof(TRS::Vector4<float>));
 			uOffset += sizeof(TRS::Vector4<float>);
 			TRS::Vector4<uint32_t> vLightCounts = {
 				static_cast<uint32_t>(_pointLights.size()),
@@ -52,30 +50,28 @@ namespace DENG {
 				static_cast<uint32_t>(_spotLights.size()),
 				0
 			};
-			std::memcpy(m_pIntermediateStorageBuffer + uOffset, &vLightCounts, sizeof(TRS::Vector4<uint32_t>));
+			std::memcpy(pLightsRegion + uOffset, &vLightCounts, sizeof(TRS::Vector4<uint32_t>));
 			uOffset += sizeof(TRS::Vector4<uint32_t>);
 
 			for (const PointLightComponent& pointLight : _pointLights) {
-				std::memcpy(m_pIntermediateStorageBuffer + uOffset, &pointLight, sizeof(PointLightComponent));
+				std::memcpy(pLightsRegion + uOffset, &pointLight, sizeof(PointLightComponent));
 				uOffset += sizeof(PointLightComponent);
 			}
 
 			if (i == 0) m_arrLightOffsets[1] += uOffset;
 			
 			for (const DirectionalLightComponent& dirLight : _dirLights) {
-				std::memcpy(m_pIntermediateStorageBuffer + uOffset, &dirLight, sizeof(DirectionalLightComponent));
+				std::memcpy(pLightsRegion + uOffset, &dirLight, sizeof(DirectionalLightComponent));
 				uOffset += sizeof(DirectionalLightComponent);
 			}
 
 			if (i == 0) m_arrLightOffsets[2] += uOffset;
 
 			for (const SpotlightComponent& spotLight : _spotLights) {
-				std::memcpy(m_pIntermediateStorageBuffer + uOffset, &spotLight, sizeof(SpotlightComponent));
+				std::memcpy(pLightsRegion + uOffset, &spotLight, sizeof(SpotlightComponent));
 				uOffset += sizeof(SpotlightComponent);
 			}
 		}
-
-		m_pRenderer->UpdateBuffer(m_pIntermediateStorageBuffer, m_uUsedLightsSize, m_arrLightOffsets[0]);
 	}
 
 
@@ -89,8 +85,10 @@ namespace DENG {
 	{
 		ResourceManager& resourceManager = ResourceManager::GetInstance();
 		
-		uint32_t uFirstInstance = 0;
 		for (auto it = _instanceInfos.begin(); it != _instanceInfos.end(); it++) {
+			if (!it->uInstanceCount)
+				continue;
+
 			IShader* pShader = resourceManager.GetShader(it->hshShader);
 			DENG_ASSERT(pShader);
 
@@ -133,32 +131,71 @@ namespace DENG {
 				pushConstant.pPushConstantData = &_camera;
 			}
 
-			m_pRenderer->DrawInstance(it->hshMesh, it->hshShader, m_pFramebuffer, it->uInstanceCount, uFirstInstance, it->hshMaterial);
-			uFirstInstance += it->uInstanceCount;
+			m_pRenderer->DrawInstance(it->hshMesh, it->hshShader, m_pFramebuffer, it->uInstanceCount, it->uFirstInstance, it->hshMaterial);
 		}
 	}
 
 	void SceneRenderer::UpdateTransformRegion(const TransformComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
 		DENG_ASSERT(_uDstOffset + _uCount < m_uTransformsSize);
-		m_pRenderer->UpdateBuffer(_pData, _uCount * sizeof(TransformComponent), m_uTransformsOffset + _uDstOffset * sizeof(TransformComponent));
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(TransformComponent), m_uTransformsOffset + _uDstOffset * sizeof(TransformComponent) });
 	}
 
 
 	void SceneRenderer::UpdateDirLightRegion(const DirectionalLightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
 		DENG_ASSERT(_uDstOffset + _uCount < m_arrLightOffsets[1]);
-		m_pRenderer->UpdateBuffer(_pData, _uCount * sizeof(DirectionalLightComponent), m_arrLightOffsets[1] + _uDstOffset * sizeof(DirectionalLightComponent));
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(DirectionalLightComponent), m_arrLightOffsets[1] + _uDstOffset * sizeof(DirectionalLightComponent) });
 	}
 
 
 	void SceneRenderer::UpdatePointLightRegion(const PointLightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
 		DENG_ASSERT(_uDstOffset + _uCount < m_arrLightOffsets[0]);
-		m_pRenderer->UpdateBuffer(_pData, _uCount * sizeof(PointLightComponent), m_arrLightOffsets[0] + _uDstOffset * sizeof(PointLightComponent));
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(PointLightComponent), m_arrLightOffsets[0] + _uDstOffset * sizeof(PointLightComponent) });
 	}
 
 
 	void SceneRenderer::UpdateSpotLightRegion(const SpotlightComponent* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
 		DENG_ASSERT(_uDstOffset + _uCount < m_arrLightOffsets[2]);
-		m_pRenderer->UpdateBuffer(_pData, _uCount * sizeof(SpotlightComponent), m_arrLightOffsets[2] + _uDstOffset * sizeof(SpotlightComponent));
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(SpotlightComponent), m_arrLightOffsets[2] + _uDstOffset * sizeof(SpotlightComponent) });
+	}
+
+
+	void SceneRenderer::UpdatePbrMaterialRegion(const MaterialPBR* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
+		DENG_ASSERT(_uDstOffset + _uCount <= m_uPbrMaterialsSize);
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(MaterialPBR), m_uPbrMaterialsOffset + _uDstOffset * sizeof(MaterialPBR) });
+	}
+
+
+	void SceneRenderer::UpdatePhongMaterialRegion(const MaterialPhong* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
+		DENG_ASSERT(_uDstOffset + _uCount <= m_uPhongMaterialsSize);
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(MaterialPhong), m_uPhongMaterialsOffset + _uDstOffset * sizeof(MaterialPhong) });
+	}
+
+
+	void SceneRenderer::UpdateDrawDescriptorIndicesRegion(const DrawDescriptorIndices* _pData, std::size_t _uDstOffset, std::size_t _uCount) {
+		DENG_ASSERT(_uDstOffset + _uCount <= m_uDrawDescriptorIndicesCount);
+		m_pendingRegions.push_back({ _pData, _uCount * sizeof(DrawDescriptorIndices), m_uDrawDescriptorIndicesOffset + _uDstOffset * sizeof(DrawDescriptorIndices) });
+	}
+
+
+	void SceneRenderer::FlushRegionUpdates() {
+		if (m_pendingRegions.empty())
+			return;
+
+		m_pRenderer->UpdateBufferRegions(m_pendingRegions.data(), m_pendingRegions.size());
+		m_pendingRegions.clear();
+	}
+
+
+	bool SceneRenderer::IsStorageReallocationRequired(
+		const std::vector<TransformComponent>& _transforms,
+		const std::vector<MaterialPBR>& _pbrMaterials,
+		const std::vector<MaterialPhong>& _phongMaterials,
+		const std::vector<DrawDescriptorIndices>& _drawDescriptorIndices) const
+	{
+		return m_uTransformsSize < _transforms.size() * MAX_FRAMES_IN_FLIGHT ||
+			m_uPbrMaterialsSize < _pbrMaterials.size() * MAX_FRAMES_IN_FLIGHT ||
+			m_uPhongMaterialsSize < _phongMaterials.size() * MAX_FRAMES_IN_FLIGHT ||
+			m_uDrawDescriptorIndicesCount < _drawDescriptorIndices.size() * MAX_FRAMES_IN_FLIGHT;
 	}
 
 
@@ -204,8 +241,8 @@ namespace DENG {
 			}
 		}
 
-		if (m_uTransformsSize < _transforms.size()) {
-			m_uTransformsSize = (_transforms.size() * 3) >> 1;
+		if (m_uTransformsSize < _transforms.size() * MAX_FRAMES_IN_FLIGHT) {
+			m_uTransformsSize = (_transforms.size() * MAX_FRAMES_IN_FLIGHT * 3) >> 1;
 			if (m_uTransformsOffset) {
 				m_pRenderer->DeallocateMemory(m_uTransformsOffset);
 			}
@@ -221,8 +258,8 @@ namespace DENG {
 			}
 		}
 
-		if (m_uDrawDescriptorIndicesCount < _drawDescriptorIndices.size()) {
-			m_uDrawDescriptorIndicesCount = (_drawDescriptorIndices.size() * 3) >> 1;
+		if (m_uDrawDescriptorIndicesCount < _drawDescriptorIndices.size() * MAX_FRAMES_IN_FLIGHT) {
+			m_uDrawDescriptorIndicesCount = (_drawDescriptorIndices.size() * MAX_FRAMES_IN_FLIGHT * 3) >> 1;
 			if (m_uDrawDescriptorIndicesOffset) {
 				m_pRenderer->DeallocateMemory(m_uDrawDescriptorIndicesOffset);
 			}
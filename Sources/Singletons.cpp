@@ -1,7 +1,12 @@
 #include "deng/RenderResources.h"
 #include "deng/Event.h"
+#include "deng/SpirvCache.h"
+#include "deng/ThreadPool.h"
 
 namespace DENG {
 	ResourceManager ResourceManager::m_sResourceManager = ResourceManager();
 	EventManager EventManager::m_sEventManager = EventManager();
-}
\ No newline at end of file
+	// statics are destroyed in reverse order, shader compilation jobs drained by ~ThreadPool() still use the cache
+	SpirvCache SpirvCache::m_sSpirvCache = SpirvCache();
+	ThreadPool ThreadPool::m_sThreadPool = ThreadPool();
+}
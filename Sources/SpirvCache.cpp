@@ -0,0 +1,93 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: SpirvCache.cpp - content addressed SPIR-V module cache class implementation
+// author: Karl-Mihkel Ott
+
+#define SPIRV_CACHE_CPP
+#include "deng/SpirvCache.h"
+
+using namespace std;
+
+namespace DENG {
+
+	cvar::hash_t SpirvCache::Hash(const void* _pData, size_t _uLength, cvar::hash_t _hshSeed) {
+		const unsigned char* pBytes = static_cast<const unsigned char*>(_pData);
+		cvar::hash_t hsh = _hshSeed;
+		for (size_t i = 0; i < _uLength; i++) {
+			hsh ^= static_cast<cvar::hash_t>(pBytes[i]);
+			hsh *= 1099511628211ull;
+		}
+
+		return hsh;
+	}
+
+
+	string SpirvCache::_GetModulePath(cvar::hash_t _hshKey) const {
+		stringstream ss;
+		ss << m_csCachePath << '/' << hex << setw(16) << setfill('0') << _hshKey << ".spv";
+		return ss.str();
+	}
+
+
+	bool SpirvCache::Find(cvar::hash_t _hshKey, vector<uint32_t>& _spirv) {
+		{
+			std::scoped_lock lock(m_mutex);
+			auto it = m_modules.find(_hshKey);
+			if (it != m_modules.end()) {
+				_spirv = it->second;
+				return true;
+			}
+		}
+
+		const FileView input = m_programFilesManager.MapProgramFile(_GetModulePath(_hshKey));
+		if (input.Size() < sizeof(uint32_t) || input.Size() % sizeof(uint32_t))
+			return false;
+
+		const uint32_t* pWords = reinterpret_cast<const uint32_t*>(input.Data());
+		if (pWords[0] != SPIRV_MAGIC_NUMBER) {
+			WARNME("Ignoring invalid cached SPIR-V module " << _GetModulePath(_hshKey));
+			return false;
+		}
+
+		_spirv.assign(pWords, pWords + input.Size() / sizeof(uint32_t));
+
+		std::scoped_lock lock(m_mutex);
+		m_modules.emplace(_hshKey, _spirv);
+		return true;
+	}
+
+
+	bool SpirvCache::Contains(cvar::hash_t _hshKey) {
+		{
+			std::scoped_lock lock(m_mutex);
+			if (m_modules.find(_hshKey) != m_modules.end())
+				return true;
+		}
+
+		return m_programFilesManager.ExistsFile(_GetModulePath(_hshKey));
+	}
+
+
+	void SpirvCache::Store(cvar::hash_t _hshKey, const vector<uint32_t>& _spirv) {
+		{
+			std::scoped_lock lock(m_mutex);
+			m_modules[_hshKey] = _spirv;
+		}
+
+		try {
+			m_programFilesManager.ReplaceProgramFile(
+				reinterpret_cast<const char*>(_spirv.data()),
+				_spirv.size() * sizeof(uint32_t),
+				_GetModulePath(_hshKey));
+		}
+		catch (const IOException& e) {
+			DISPATCH_ERROR_MESSAGE("IOException", e.what(), ErrorSeverity::NON_CRITICAL);
+		}
+	}
+
+
+	void SpirvCache::Clear() {
+		std::scoped_lock lock(m_mutex);
+		m_modules.clear();
+	}
+}
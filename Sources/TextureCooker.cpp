@@ -0,0 +1,482 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: TextureCooker.cpp - block compressed texture cooking and DDS container class implementation
+// author: Karl-Mihkel Ott
+
+#define TEXTURE_COOKER_CPP
+#include "deng/TextureCooker.h"
+
+#define DDS_MAGIC					0x20534444	// "DDS "
+#define DDS_FOURCC(a, b, c, d)		(static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24))
+
+#define DDSD_CAPS					0x1
+#define DDSD_HEIGHT					0x2
+#define DDSD_WIDTH					0x4
+#define DDSD_PIXELFORMAT			0x1000
+#define DDSD_MIPMAPCOUNT			0x20000
+#define DDSD_LINEARSIZE				0x80000
+#define DDPF_FOURCC					0x4
+#define DDSCAPS_COMPLEX				0x8
+#define DDSCAPS_TEXTURE				0x1000
+#define DDSCAPS_MIPMAP				0x400000
+#define DDSCAPS2_CUBEMAP			0x200
+#define DDS_DIMENSION_TEXTURE2D		3
+#define DDS_RESOURCE_MISC_TEXTURECUBE	0x4
+
+#define DXGI_FORMAT_BC1_UNORM		71
+#define DXGI_FORMAT_BC3_UNORM		77
+#define DXGI_FORMAT_BC5_UNORM		83
+#define DXGI_FORMAT_BC7_UNORM		98
+
+namespace DENG {
+
+	struct _DDSPixelFormat {
+		uint32_t uSize;
+		uint32_t uFlags;
+		uint32_t uFourCC;
+		uint32_t uRGBBitCount;
+		uint32_t uRBitMask;
+		uint32_t uGBitMask;
+		uint32_t uBBitMask;
+		uint32_t uABitMask;
+	};
+
+	struct _DDSHeader {
+		uint32_t uSize;
+		uint32_t uFlags;
+		uint32_t uHeight;
+		uint32_t uWidth;
+		uint32_t uPitchOrLinearSize;
+		uint32_t uDepth;
+		uint32_t uMipMapCount;
+		uint32_t arrReserved1[11];
+		_DDSPixelFormat pixelFormat;
+		uint32_t uCaps;
+		uint32_t uCaps2;
+		uint32_t uCaps3;
+		uint32_t uCaps4;
+		uint32_t uReserved2;
+	};
+
+	struct _DDSHeaderDX10 {
+		uint32_t uDxgiFormat;
+		uint32_t uResourceDimension;
+		uint32_t uMiscFlag;
+		uint32_t uArraySize;
+		uint32_t uMiscFlags2;
+	};
+
+	static_assert(sizeof(_DDSHeader) == 124, "DDS header must be 124 bytes");
+	static_assert(sizeof(_DDSHeaderDX10) == 20, "DDS DX10 header must be 20 bytes");
+
+
+	static uint16_t _PackRGB565(const uint8_t* _pRGB) {
+		return static_cast<uint16_t>(
+			(((_pRGB[0] * 31 + 127) / 255) << 11) |
+			(((_pRGB[1] * 63 + 127) / 255) << 5) |
+			((_pRGB[2] * 31 + 127) / 255));
+	}
+
+
+	static void _UnpackRGB565(uint16_t _uColor, int* _pRGB) {
+		const int r = (_uColor >> 11) & 0x1f;
+		const int g = (_uColor >> 5) & 0x3f;
+		const int b = _uColor & 0x1f;
+		_pRGB[0] = (r << 3) | (r >> 2);
+		_pRGB[1] = (g << 2) | (g >> 4);
+		_pRGB[2] = (b << 3) | (b >> 2);
+	}
+
+
+	// endpoints are the extreme texels along the principal axis of block's colors
+	void TextureCooker::_EncodeBC1Block(const uint8_t* _pRGBA, uint8_t* _pBlock) {
+		float arrMean[3] = {};
+		for (size_t i = 0; i < 16; i++) {
+			for (size_t c = 0; c < 3; c++)
+				arrMean[c] += static_cast<float>(_pRGBA[i * 4 + c]);
+		}
+		for (size_t c = 0; c < 3; c++)
+			arrMean[c] /= 16.f;
+
+		float arrCovariance[3][3] = {};
+		for (size_t i = 0; i < 16; i++) {
+			float arrDelta[3];
+			for (size_t c = 0; c < 3; c++)
+				arrDelta[c] = static_cast<float>(_pRGBA[i * 4 + c]) - arrMean[c];
+
+			for (size_t r = 0; r < 3; r++) {
+				for (size_t c = 0; c < 3; c++)
+					arrCovariance[r][c] += arrDelta[r] * arrDelta[c];
+			}
+		}
+
+		// power iteration
+		float arrAxis[3] = { 1.f, 1.f, 1.f };
+		for (int uIteration = 0; uIteration < 4; uIteration++) {
+			float arrNext[3] = {};
+			for (size_t r = 0; r < 3; r++) {
+				for (size_t c = 0; c < 3; c++)
+					arrNext[r] += arrCovariance[r][c] * arrAxis[c];
+			}
+
+			const float fLength = std::max(std::abs(arrNext[0]), std::max(std::abs(arrNext[1]), std::abs(arrNext[2])));
+			if (fLength < 1e-6f)
+				break;
+			for (size_t c = 0; c < 3; c++)
+				arrAxis[c] = arrNext[c] / fLength;
+		}
+
+		size_t uMin = 0, uMax = 0;
+		float fMin = FLT_MAX, fMax = -FLT_MAX;
+		for (size_t i = 0; i < 16; i++) {
+			const float fProjection = _pRGBA[i * 4] * arrAxis[0] + _pRGBA[i * 4 + 1] * arrAxis[1] + _pRGBA[i * 4 + 2] * arrAxis[2];
+			if (fProjection < fMin) {
+				fMin = fProjection;
+				uMin = i;
+			}
+			if (fProjection > fMax) {
+				fMax = fProjection;
+				uMax = i;
+			}
+		}
+
+		uint16_t uColor0 = _PackRGB565(_pRGBA + uMax * 4);
+		uint16_t uColor1 = _PackRGB565(_pRGBA + uMin * 4);
+		// color0 > color1 selects four color mode
+		if (uColor0 < uColor1)
+			std::swap(uColor0, uColor1);
+
+		uint32_t uIndices = 0;
+		if (uColor0 != uColor1) {
+			int arrPalette[4][3];
+			_UnpackRGB565(uColor0, arrPalette[0]);
+			_UnpackRGB565(uColor1, arrPalette[1]);
+			for (size_t c = 0; c < 3; c++) {
+				arrPalette[2][c] = (2 * arrPalette[0][c] + arrPalette[1][c]) / 3;
+				arrPalette[3][c] = (arrPalette[0][c] + 2 * arrPalette[1][c]) / 3;
+			}
+
+			for (size_t i = 0; i < 16; i++) {
+				uint32_t uBest = 0;
+				int iBestDistance = INT32_MAX;
+				for (uint32_t j = 0; j < 4; j++) {
+					int iDistance = 0;
+					for (size_t c = 0; c < 3; c++) {
+						const int iDelta = static_cast<int>(_pRGBA[i * 4 + c]) - arrPalette[j][c];
+						iDistance += iDelta * iDelta;
+					}
+
+					if (iDistance < iBestDistance) {
+						iBestDistance = iDistance;
+						uBest = j;
+					}
+				}
+
+				uIndices |= uBest << (i * 2);
+			}
+		}
+
+		_pBlock[0] = static_cast<uint8_t>(uColor0 & 0xff);
+		_pBlock[1] = static_cast<uint8_t>(uColor0 >> 8);
+		_pBlock[2] = static_cast<uint8_t>(uColor1 & 0xff);
+		_pBlock[3] = static_cast<uint8_t>(uColor1 >> 8);
+		for (size_t i = 0; i < 4; i++)
+			_pBlock[4 + i] = static_cast<uint8_t>((uIndices >> (i * 8)) & 0xff);
+	}
+
+
+	// single channel block in eight value mode, used for BC3 alpha and both BC5 channels
+	void TextureCooker::_EncodeBC4Block(const uint8_t* _pRGBA, size_t _uChannel, uint8_t* _pBlock) {
+		int iMin = 255, iMax = 0;
+		for (size_t i = 0; i < 16; i++) {
+			iMin = std::min(iMin, static_cast<int>(_pRGBA[i * 4 + _uChannel]));
+			iMax = std::max(iMax, static_cast<int>(_pRGBA[i * 4 + _uChannel]));
+		}
+
+		uint64_t uIndices = 0;
+		if (iMax != iMin) {
+			int arrPalette[8] = { iMax, iMin };
+			for (int j = 1; j < 7; j++)
+				arrPalette[j + 1] = ((7 - j) * iMax + j * iMin) / 7;
+
+			for (size_t i = 0; i < 16; i++) {
+				const int iValue = static_cast<int>(_pRGBA[i * 4 + _uChannel]);
+				uint64_t uBest = 0;
+				int iBestDistance = INT32_MAX;
+				for (uint64_t j = 0; j < 8; j++) {
+					const int iDistance = std::abs(iValue - arrPalette[j]);
+					if (iDistance < iBestDistance) {
+						iBestDistance = iDistance;
+						uBest = j;
+					}
+				}
+
+				uIndices |= uBest << (i * 3);
+			}
+		}
+
+		_pBlock[0] = static_cast<uint8_t>(iMax);
+		_pBlock[1] = static_cast<uint8_t>(iMin);
+		for (size_t i = 0; i < 6; i++)
+			_pBlock[2 + i] = static_cast<uint8_t>((uIndices >> (i * 8)) & 0xff);
+	}
+
+
+	void TextureCooker::_EncodeBlock(TextureFormat _eFormat, const uint8_t* _pRGBA, uint8_t* _pBlock) {
+		switch (_eFormat) {
+			case TextureFormat::BC1:
+				_EncodeBC1Block(_pRGBA, _pBlock);
+				break;
+
+			case TextureFormat::BC3:
+				_EncodeBC4Block(_pRGBA, 3, _pBlock);
+				_EncodeBC1Block(_pRGBA, _pBlock + 8);
+				break;
+
+			case TextureFormat::BC5:
+				_EncodeBC4Block(_pRGBA, 0, _pBlock);
+				_EncodeBC4Block(_pRGBA, 1, _pBlock + 8);
+				break;
+
+			default:
+				DENG_ASSERT(false);
+				break;
+		}
+	}
+
+
+	void TextureCooker::_EncodeMipLevel(TextureFormat _eFormat, const uint8_t* _pRGBA, uint32_t _uWidth, uint32_t _uHeight, uint8_t* _pDst) {
+		const size_t uBlockSize = GetBlockSize(_eFormat);
+		const uint32_t uBlocksX = (_uWidth + 3) / 4;
+		const uint32_t uBlocksY = (_uHeight + 3) / 4;
+
+		ThreadPool::GetInstance().ParallelFor(uBlocksY, 1, [=](size_t _uBegin, size_t _uEnd) {
+			uint8_t arrTexels[16 * 4];
+			for (size_t by = _uBegin; by < _uEnd; by++) {
+				for (uint32_t bx = 0; bx < uBlocksX; bx++) {
+					// edge blocks repeat the last row and column
+					for (uint32_t y = 0; y < 4; y++) {
+						const uint32_t uY = std::min(static_cast<uint32_t>(by * 4 + y), _uHeight - 1);
+						for (uint32_t x = 0; x < 4; x++) {
+							const uint32_t uX = std::min(bx * 4 + x, _uWidth - 1);
+							std::memcpy(arrTexels + (y * 4 + x) * 4, _pRGBA + (static_cast<size_t>(uY) * _uWidth + uX) * 4, 4);
+						}
+					}
+
+					_EncodeBlock(_eFormat, arrTexels, _pDst + (by * uBlocksX + bx) * uBlockSize);
+				}
+			}
+		});
+	}
+
+
+	std::vector<uint8_t> TextureCooker::_Downsample(const uint8_t* _pRGBA, uint32_t _uWidth, uint32_t _uHeight) {
+		const uint32_t uWidth = std::max(_uWidth / 2, 1u);
+		const uint32_t uHeight = std::max(_uHeight / 2, 1u);
+		std::vector<uint8_t> downsampled(static_cast<size_t>(uWidth) * uHeight * 4);
+
+		// 2x2 box filter
+		for (uint32_t y = 0; y < uHeight; y++) {
+			const uint32_t uY0 = std::min(y * 2, _uHeight - 1), uY1 = std::min(y * 2 + 1, _uHeight - 1);
+			for (uint32_t x = 0; x < uWidth; x++) {
+				const uint32_t uX0 = std::min(x * 2, _uWidth - 1), uX1 = std::min(x * 2 + 1, _uWidth - 1);
+				for (uint32_t c = 0; c < 4; c++) {
+					const uint32_t uSum =
+						_pRGBA[(static_cast<size_t>(uY0) * _uWidth + uX0) * 4 + c] +
+						_pRGBA[(static_cast<size_t>(uY0) * _uWidth + uX1) * 4 + c] +
+						_pRGBA[(static_cast<size_t>(uY1) * _uWidth + uX0) * 4 + c] +
+						_pRGBA[(static_cast<size_t>(uY1) * _uWidth + uX1) * 4 + c];
+					downsampled[(static_cast<size_t>(y) * uWidth + x) * 4 + c] = static_cast<uint8_t>((uSum + 2) / 4);
+				}
+			}
+		}
+
+		return downsampled;
+	}
+
+
+	size_t TextureCooker::GetBlockSize(TextureFormat _eFormat) {
+		switch (_eFormat) {
+			case TextureFormat::BC1:
+				return 8;
+
+			case TextureFormat::BC3:
+			case TextureFormat::BC5:
+			case TextureFormat::BC7:
+				return 16;
+
+			default:
+				return 0;
+		}
+	}
+
+
+	size_t TextureCooker::CalculateMipLevelSize(TextureFormat _eFormat, uint32_t _uWidth, uint32_t _uHeight) {
+		return static_cast<size_t>(std::max((_uWidth + 3) / 4, 1u)) * std::max((_uHeight + 3) / 4, 1u) * GetBlockSize(_eFormat);
+	}
+
+
+	uint32_t TextureCooker::CalculateMipLevelCount(uint32_t _uWidth, uint32_t _uHeight) {
+		uint32_t uLevels = 1;
+		for (uint32_t uSize = std::max(_uWidth, _uHeight); uSize > 1; uSize /= 2)
+			uLevels++;
+		return uLevels;
+	}
+
+
+	std::vector<char> TextureCooker::Cook(const char* _pRGBA, uint32_t _uWidth, uint32_t _uHeight, TextureFormat _eFormat) {
+		if (_eFormat != TextureFormat::BC1 && _eFormat != TextureFormat::BC3 && _eFormat != TextureFormat::BC5)
+			throw LogicException("Only BC1, BC3 and BC5 textures can be cooked");
+
+		const uint32_t uMipLevels = CalculateMipLevelCount(_uWidth, _uHeight);
+		size_t uDataSize = 0;
+		for (uint32_t i = 0; i < uMipLevels; i++)
+			uDataSize += CalculateMipLevelSize(_eFormat, std::max(_uWidth >> i, 1u), std::max(_uHeight >> i, 1u));
+
+		_DDSHeader header = {};
+		header.uSize = sizeof(_DDSHeader);
+		header.uFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+		header.uHeight = _uHeight;
+		header.uWidth = _uWidth;
+		header.uPitchOrLinearSize = static_cast<uint32_t>(CalculateMipLevelSize(_eFormat, _uWidth, _uHeight));
+		header.uMipMapCount = uMipLevels;
+		header.pixelFormat.uSize = sizeof(_DDSPixelFormat);
+		header.pixelFormat.uFlags = DDPF_FOURCC;
+		header.pixelFormat.uFourCC = DDS_FOURCC('D', 'X', '1', '0');
+		header.uCaps = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+		_DDSHeaderDX10 headerDX10 = {};
+		headerDX10.uResourceDimension = DDS_DIMENSION_TEXTURE2D;
+		headerDX10.uArraySize = 1;
+		switch (_eFormat) {
+			case TextureFormat::BC1:
+				headerDX10.uDxgiFormat = DXGI_FORMAT_BC1_UNORM;
+				break;
+
+			case TextureFormat::BC3:
+				headerDX10.uDxgiFormat = DXGI_FORMAT_BC3_UNORM;
+				break;
+
+			default:
+				headerDX10.uDxgiFormat = DXGI_FORMAT_BC5_UNORM;
+				break;
+		}
+
+		const uint32_t uMagic = DDS_MAGIC;
+		const size_t uHeaderSize = sizeof(uint32_t) + sizeof(_DDSHeader) + sizeof(_DDSHeaderDX10);
+		std::vector<char> output(uHeaderSize + uDataSize);
+		std::memcpy(output.data(), &uMagic, sizeof(uint32_t));
+		std::memcpy(output.data() + sizeof(uint32_t), &header, sizeof(_DDSHeader));
+		std::memcpy(output.data() + sizeof(uint32_t) + sizeof(_DDSHeader), &headerDX10, sizeof(_DDSHeaderDX10));
+
+		uint8_t* pDst = reinterpret_cast<uint8_t*>(output.data() + uHeaderSize);
+		std::vector<uint8_t> mipLevel;
+		const uint8_t* pLevel = reinterpret_cast<const uint8_t*>(_pRGBA);
+		uint32_t uWidth = _uWidth, uHeight = _uHeight;
+		for (uint32_t i = 0; i < uMipLevels; i++) {
+			_EncodeMipLevel(_eFormat, pLevel, uWidth, uHeight, pDst);
+			pDst += CalculateMipLevelSize(_eFormat, uWidth, uHeight);
+
+			if (i + 1 < uMipLevels) {
+				mipLevel = _Downsample(pLevel, uWidth, uHeight);
+				pLevel = mipLevel.data();
+				uWidth = std::max(uWidth / 2, 1u);
+				uHeight = std::max(uHeight / 2, 1u);
+			}
+		}
+
+		return output;
+	}
+
+
+	Texture TextureCooker::LoadDDS(const char* _pData, size_t _uSize) {
+		uint32_t uMagic = 0;
+		_DDSHeader header = {};
+		if (_uSize < sizeof(uint32_t) + sizeof(_DDSHeader))
+			throw IOException("DDS file is too small");
+
+		std::memcpy(&uMagic, _pData, sizeof(uint32_t));
+		std::memcpy(&header, _pData + sizeof(uint32_t), sizeof(_DDSHeader));
+		if (uMagic != DDS_MAGIC || header.uSize != sizeof(_DDSHeader))
+			throw IOException("Invalid DDS header");
+
+		Texture texture;
+		size_t uOffset = sizeof(uint32_t) + sizeof(_DDSHeader);
+		bool bIsCubemap = header.uCaps2 & DDSCAPS2_CUBEMAP;
+
+		if (!(header.pixelFormat.uFlags & DDPF_FOURCC))
+			throw IOException("Uncompressed DDS textures are not supported");
+
+		switch (header.pixelFormat.uFourCC) {
+			case DDS_FOURCC('D', 'X', '1', '0'):
+				{
+					_DDSHeaderDX10 headerDX10 = {};
+					if (_uSize < uOffset + sizeof(_DDSHeaderDX10))
+						throw IOException("DDS file is too small");
+					std::memcpy(&headerDX10, _pData + uOffset, sizeof(_DDSHeaderDX10));
+					uOffset += sizeof(_DDSHeaderDX10);
+
+					if (headerDX10.uMiscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+						bIsCubemap = true;
+
+					switch (headerDX10.uDxgiFormat) {
+						case DXGI_FORMAT_BC1_UNORM:
+							texture.eFormat = TextureFormat::BC1;
+							break;
+
+						case DXGI_FORMAT_BC3_UNORM:
+							texture.eFormat = TextureFormat::BC3;
+							break;
+
+						case DXGI_FORMAT_BC5_UNORM:
+							texture.eFormat = TextureFormat::BC5;
+							break;
+
+						case DXGI_FORMAT_BC7_UNORM:
+							texture.eFormat = TextureFormat::BC7;
+							break;
+
+						default:
+							throw IOException("Unsupported DXGI format in DDS file");
+					}
+				}
+				break;
+
+			case DDS_FOURCC('D', 'X', 'T', '1'):
+				texture.eFormat = TextureFormat::BC1;
+				break;
+
+			case DDS_FOURCC('D', 'X', 'T', '5'):
+				texture.eFormat = TextureFormat::BC3;
+				break;
+
+			case DDS_FOURCC('A', 'T', 'I', '2'):
+			case DDS_FOURCC('B', 'C', '5', 'U'):
+				texture.eFormat = TextureFormat::BC5;
+				break;
+
+			default:
+				throw IOException("Unsupported DDS pixel format");
+		}
+
+		texture.uWidth = header.uWidth;
+		texture.uHeight = header.uHeight;
+		texture.uBitDepth = 4;
+		texture.uMipLevels = std::max(header.uMipMapCount, 1u);
+		texture.eLoadType = TextureLoadType::External_DDS;
+		texture.eResourceType = bIsCubemap ? TextureType::Image_3D_Array : TextureType::Image_2D;
+
+		size_t uFaceSize = 0;
+		for (uint32_t i = 0; i < texture.uMipLevels; i++)
+			uFaceSize += CalculateMipLevelSize(texture.eFormat, std::max(texture.uWidth >> i, 1u), std::max(texture.uHeight >> i, 1u));
+
+		texture.uDataSize = uFaceSize * (bIsCubemap ? 6 : 1);
+		if (_uSize < uOffset + texture.uDataSize)
+			throw IOException("DDS file is truncated");
+
+		texture.bHeapAllocationFlag = true;
+		texture.pRGBAData = new char[texture.uDataSize];
+		std::memcpy(texture.pRGBAData, _pData + uOffset, texture.uDataSize);
+		return texture;
+	}
+}
@@ -0,0 +1,64 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: ThreadPool.cpp - worker thread pool class implementation
+// author: Karl-Mihkel Ott
+
+#include "deng/ThreadPool.h"
+
+namespace DENG {
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::scoped_lock lock(m_mutex);
+			m_bIsTerminating = true;
+		}
+
+		m_cvJobAvailable.notify_all();
+		for (auto it = m_workers.begin(); it != m_workers.end(); it++)
+			it->join();
+	}
+
+
+	void ThreadPool::_Start() {
+		const unsigned int uHardwareThreads = std::thread::hardware_concurrency();
+		const std::size_t uWorkerCount = uHardwareThreads > 1 ? static_cast<std::size_t>(uHardwareThreads - 1) : 1;
+
+		m_workers.reserve(uWorkerCount);
+		for (std::size_t i = 0; i < uWorkerCount; i++)
+			m_workers.emplace_back(&ThreadPool::_WorkerLoop, this);
+	}
+
+
+	void ThreadPool::_WorkerLoop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock lock(m_mutex);
+				m_cvJobAvailable.wait(lock, [this]() { return m_bIsTerminating || !m_jobs.empty(); });
+				if (m_bIsTerminating && m_jobs.empty())
+					return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop();
+			}
+
+			job();
+		}
+	}
+
+
+	void ThreadPool::_Push(std::function<void()>&& _job) {
+		std::call_once(m_startFlag, &ThreadPool::_Start, this);
+		{
+			std::scoped_lock lock(m_mutex);
+			m_jobs.push(std::move(_job));
+		}
+		m_cvJobAvailable.notify_one();
+	}
+
+
+	std::size_t ThreadPool::GetWorkerCount() {
+		std::call_once(m_startFlag, &ThreadPool::_Start, this);
+		return m_workers.size();
+	}
+}
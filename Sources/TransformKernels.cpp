@@ -0,0 +1,243 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: TransformKernels.cpp - batched transform math kernels implementation
+// author: Karl-Mihkel Ott
+
+#define TRANSFORM_KERNELS_CPP
+#include "deng/TransformKernels.h"
+
+#if defined(DENG_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define DENG_TARGET_SSE41 __attribute__((target("sse4.1")))
+	#define DENG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define DENG_TARGET_SSE41
+	#define DENG_TARGET_AVX2
+#endif
+
+// Cephes style sincos constants, valid for |x| up to ~8192
+#define SINCOS_FOPI			1.27323954473516f		// 4 / pi
+#define SINCOS_DP1			0.78515625f
+#define SINCOS_DP2			2.4187564849853515625e-4f
+#define SINCOS_DP3			3.77489497744594108e-8f
+#define SINCOS_SIN_P0		-1.9515295891e-4f
+#define SINCOS_SIN_P1		8.3321608736e-3f
+#define SINCOS_SIN_P2		-1.6666654611e-1f
+#define SINCOS_COS_P0		2.443315711809948e-5f
+#define SINCOS_COS_P1		-1.388731625493765e-3f
+#define SINCOS_COS_P2		4.166664568298827e-2f
+
+namespace DENG {
+
+#ifdef DENG_X86
+	DENG_TARGET_SSE41
+	static void _SinCosSSE41(__m128 _x, __m128& _sin, __m128& _cos) {
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+		__m128 signBitSin = _mm_and_ps(_x, signMask);
+		_x = _mm_andnot_ps(signMask, _x);
+
+		// octant selection
+		__m128i iOctant = _mm_cvttps_epi32(_mm_mul_ps(_x, _mm_set1_ps(SINCOS_FOPI)));
+		iOctant = _mm_and_si128(_mm_add_epi32(iOctant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+		const __m128 y = _mm_cvtepi32_ps(iOctant);
+
+		const __m128 swapSignBitSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(iOctant, _mm_set1_epi32(4)), 29));
+		const __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(iOctant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+		const __m128 signBitCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(iOctant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+		signBitSin = _mm_xor_ps(signBitSin, swapSignBitSin);
+
+		// extended precision modular arithmetic
+		_x = _mm_sub_ps(_x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP1)));
+		_x = _mm_sub_ps(_x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP2)));
+		_x = _mm_sub_ps(_x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP3)));
+		const __m128 z = _mm_mul_ps(_x, _x);
+
+		__m128 polyCos = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_COS_P0), z), _mm_set1_ps(SINCOS_COS_P1));
+		polyCos = _mm_add_ps(_mm_mul_ps(polyCos, z), _mm_set1_ps(SINCOS_COS_P2));
+		polyCos = _mm_mul_ps(_mm_mul_ps(polyCos, z), z);
+		polyCos = _mm_add_ps(_mm_sub_ps(polyCos, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.f));
+
+		__m128 polySin = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_SIN_P0), z), _mm_set1_ps(SINCOS_SIN_P1));
+		polySin = _mm_add_ps(_mm_mul_ps(polySin, z), _mm_set1_ps(SINCOS_SIN_P2));
+		polySin = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(polySin, z), _x), _x);
+
+		_sin = _mm_xor_ps(_mm_blendv_ps(polyCos, polySin, polyMask), signBitSin);
+		_cos = _mm_xor_ps(_mm_blendv_ps(polySin, polyCos, polyMask), signBitCos);
+	}
+
+
+	DENG_TARGET_AVX2
+	static void _SinCosAVX2(__m256 _x, __m256& _sin, __m256& _cos) {
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000)));
+		__m256 signBitSin = _mm256_and_ps(_x, signMask);
+		_x = _mm256_andnot_ps(signMask, _x);
+
+		// octant selection
+		__m256i iOctant = _mm256_cvttps_epi32(_mm256_mul_ps(_x, _mm256_set1_ps(SINCOS_FOPI)));
+		iOctant = _mm256_and_si256(_mm256_add_epi32(iOctant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+		const __m256 y = _mm256_cvtepi32_ps(iOctant);
+
+		const __m256 swapSignBitSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(iOctant, _mm256_set1_epi32(4)), 29));
+		const __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(iOctant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+		const __m256 signBitCos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(iOctant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+		signBitSin = _mm256_xor_ps(signBitSin, swapSignBitSin);
+
+		// extended precision modular arithmetic
+		_x = _mm256_sub_ps(_x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP1)));
+		_x = _mm256_sub_ps(_x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP2)));
+		_x = _mm256_sub_ps(_x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP3)));
+		const __m256 z = _mm256_mul_ps(_x, _x);
+
+		__m256 polyCos = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_COS_P0), z), _mm256_set1_ps(SINCOS_COS_P1));
+		polyCos = _mm256_add_ps(_mm256_mul_ps(polyCos, z), _mm256_set1_ps(SINCOS_COS_P2));
+		polyCos = _mm256_mul_ps(_mm256_mul_ps(polyCos, z), z);
+		polyCos = _mm256_add_ps(_mm256_sub_ps(polyCos, _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.f));
+
+		__m256 polySin = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_SIN_P0), z), _mm256_set1_ps(SINCOS_SIN_P1));
+		polySin = _mm256_add_ps(_mm256_mul_ps(polySin, z), _mm256_set1_ps(SINCOS_SIN_P2));
+		polySin = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(polySin, z), _x), _x);
+
+		_sin = _mm256_xor_ps(_mm256_blendv_ps(polyCos, polySin, polyMask), signBitSin);
+		_cos = _mm256_xor_ps(_mm256_blendv_ps(polySin, polyCos, polyMask), signBitCos);
+	}
+#endif
+
+
+	// R = Rx(a) * Ry(b) * Rz(c)
+	// | cb*cc               -cb*sc               sb     |
+	// | ca*sc + sa*sb*cc     ca*cc - sa*sb*sc    -sa*cb  |
+	// | sa*sc - ca*sb*cc     sa*cc + ca*sb*sc     ca*cb  |
+	void TransformKernels::_CalculateRotationsScalar(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+													 std::size_t _uBegin, std::size_t _uEnd, Matrix3SoA& _rotations, Matrix3SoA& _normals)
+	{
+		for (std::size_t i = _uBegin; i < _uEnd; i++) {
+			const std::array<float, 9> arrMatrix = CalculateRotation(_pRotationX[i], _pRotationY[i], _pRotationZ[i]);
+
+			for (int j = 0; j < 9; j++) {
+				_rotations.arrElements[j][i] = arrMatrix[j];
+				_normals.arrElements[(j % 3) * 3 + j / 3][i] = arrMatrix[j];
+			}
+		}
+	}
+
+#ifdef DENG_X86
+	DENG_TARGET_SSE41
+	void TransformKernels::_CalculateRotationsSSE41(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+													std::size_t _uCount, Matrix3SoA& _rotations, Matrix3SoA& _normals)
+	{
+		std::size_t i = 0;
+		for (; i + 4 <= _uCount; i += 4) {
+			__m128 sa, ca, sb, cb, sc, cc;
+			_SinCosSSE41(_mm_loadu_ps(_pRotationX + i), sa, ca);
+			_SinCosSSE41(_mm_loadu_ps(_pRotationY + i), sb, cb);
+			_SinCosSSE41(_mm_loadu_ps(_pRotationZ + i), sc, cc);
+
+			const __m128 sasb = _mm_mul_ps(sa, sb);
+			const __m128 casb = _mm_mul_ps(ca, sb);
+			const __m128 arrMatrix[9] = {
+				_mm_mul_ps(cb, cc),
+				_mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cb, sc)),
+				sb,
+				_mm_add_ps(_mm_mul_ps(ca, sc), _mm_mul_ps(sasb, cc)),
+				_mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc)),
+				_mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sa, cb)),
+				_mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc)),
+				_mm_add_ps(_mm_mul_ps(sa, cc), _mm_mul_ps(casb, sc)),
+				_mm_mul_ps(ca, cb)
+			};
+
+			for (int j = 0; j < 9; j++) {
+				_mm_storeu_ps(_rotations.arrElements[j] + i, arrMatrix[j]);
+				_mm_storeu_ps(_normals.arrElements[(j % 3) * 3 + j / 3] + i, arrMatrix[j]);
+			}
+		}
+
+		_CalculateRotationsScalar(_pRotationX, _pRotationY, _pRotationZ, i, _uCount, _rotations, _normals);
+	}
+
+
+	DENG_TARGET_AVX2
+	void TransformKernels::_CalculateRotationsAVX2(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ,
+												   std::size_t _uCount, Matrix3SoA& _rotations, Matrix3SoA& _normals)
+	{
+		std::size_t i = 0;
+		for (; i + 8 <= _uCount; i += 8) {
+			__m256 sa, ca, sb, cb, sc, cc;
+			_SinCosAVX2(_mm256_loadu_ps(_pRotationX + i), sa, ca);
+			_SinCosAVX2(_mm256_loadu_ps(_pRotationY + i), sb, cb);
+			_SinCosAVX2(_mm256_loadu_ps(_pRotationZ + i), sc, cc);
+
+			const __m256 sasb = _mm256_mul_ps(sa, sb);
+			const __m256 casb = _mm256_mul_ps(ca, sb);
+			const __m256 arrMatrix[9] = {
+				_mm256_mul_ps(cb, cc),
+				_mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(cb, sc)),
+				sb,
+				_mm256_add_ps(_mm256_mul_ps(ca, sc), _mm256_mul_ps(sasb, cc)),
+				_mm256_sub_ps(_mm256_mul_ps(ca, cc), _mm256_mul_ps(sasb, sc)),
+				_mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(sa, cb)),
+				_mm256_sub_ps(_mm256_mul_ps(sa, sc), _mm256_mul_ps(casb, cc)),
+				_mm256_add_ps(_mm256_mul_ps(sa, cc), _mm256_mul_ps(casb, sc)),
+				_mm256_mul_ps(ca, cb)
+			};
+
+			for (int j = 0; j < 9; j++) {
+				_mm256_storeu_ps(_rotations.arrElements[j] + i, arrMatrix[j]);
+				_mm256_storeu_ps(_normals.arrElements[(j % 3) * 3 + j / 3] + i, arrMatrix[j]);
+			}
+		}
+
+		_CalculateRotationsScalar(_pRotationX, _pRotationY, _pRotationZ, i, _uCount, _rotations, _normals);
+	}
+#endif
+
+
+	SimdInstructionSet TransformKernels::GetInstructionSet() {
+		static const SimdInstructionSet s_eInstructionSet = []() {
+#if defined(DENG_X86) && (defined(__GNUC__) || defined(__clang__))
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return SimdInstructionSet::AVX2;
+			if (__builtin_cpu_supports("sse4.1"))
+				return SimdInstructionSet::SSE41;
+#elif defined(DENG_X86) && defined(_MSC_VER)
+			int arrCpuInfo[4] = {};
+			__cpuid(arrCpuInfo, 1);
+			const bool bSSE41 = arrCpuInfo[2] & (1 << 19);
+			const bool bOSXSave = arrCpuInfo[2] & (1 << 27);
+			const bool bAVX = arrCpuInfo[2] & (1 << 28);
+
+			__cpuidex(arrCpuInfo, 7, 0);
+			const bool bAVX2 = arrCpuInfo[1] & (1 << 5);
+
+			// ymm state must be enabled by the os as well
+			if (bAVX2 && bAVX && bOSXSave && (_xgetbv(0) & 0x6) == 0x6)
+				return SimdInstructionSet::AVX2;
+			if (bSSE41)
+				return SimdInstructionSet::SSE41;
+#endif
+			return SimdInstructionSet::Scalar;
+		}();
+
+		return s_eInstructionSet;
+	}
+
+
+	void TransformKernels::CalculateRotations(const float* _pRotationX, const float* _pRotationY, const float* _pRotationZ, std::size_t _uCount,
+											  Matrix3SoA& _rotations, Matrix3SoA& _normals, SimdInstructionSet _eInstructionSet)
+	{
+		switch (_eInstructionSet) {
+#ifdef DENG_X86
+			case SimdInstructionSet::AVX2:
+				_CalculateRotationsAVX2(_pRotationX, _pRotationY, _pRotationZ, _uCount, _rotations, _normals);
+				break;
+
+			case SimdInstructionSet::SSE41:
+				_CalculateRotationsSSE41(_pRotationX, _pRotationY, _pRotationZ, _uCount, _rotations, _normals);
+				break;
+#endif
+			default:
+				_CalculateRotationsScalar(_pRotationX, _pRotationY, _pRotationZ, 0, _uCount, _rotations, _normals);
+				break;
+		}
+	}
+}
@@ -0,0 +1,169 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanBufferArena.cpp - Vulkan multi-block device buffer arena class implementation
+// author: Karl-Mihkel Ott
+
+#define VULKAN_BUFFER_ARENA_CPP
+#include "deng/VulkanBufferArena.h"
+
+namespace DENG {
+    namespace Vulkan {
+
+        BufferArena::BufferArena(const InstanceCreator* _pInstanceCreator, DeletionQueue& _deletionQueue, VkBufferUsageFlags _bmUsage, VkDeviceSize _uDefaultBlockSize) :
+            m_pInstanceCreator(_pInstanceCreator),
+            m_deletionQueue(_deletionQueue),
+            m_bmUsage(_bmUsage),
+            m_uDefaultBlockSize(_uDefaultBlockSize)
+        {
+            // first block is never retired
+            m_blocks.emplace_back();
+            m_blocks.back().uSize = static_cast<size_t>(m_uDefaultBlockSize);
+            _CreateBlockBuffer(m_blocks.back());
+            m_uArenaSize = m_blocks.back().uSize;
+        }
+
+
+        BufferArena::~BufferArena() {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            for (_Block& block : m_blocks) {
+                if (block.buffer.hBuffer != VK_NULL_HANDLE) {
+                    vkDestroyBuffer(hDevice, block.buffer.hBuffer, nullptr);
+                    vkFreeMemory(hDevice, block.buffer.hMemory, nullptr);
+                }
+            }
+        }
+
+
+        void BufferArena::_CreateBlockBuffer(_Block& _block) {
+            _block.buffer.uSize = static_cast<VkDeviceSize>(_block.uSize);
+
+            VkMemoryRequirements memoryRequirements = _CreateBuffer(
+                m_pInstanceCreator->GetDevice(),
+                _block.buffer.uSize,
+                m_bmUsage,
+                _block.buffer.hBuffer);
+
+            _AllocateMemory(
+                m_pInstanceCreator->GetDevice(),
+                m_pInstanceCreator->GetPhysicalDevice(),
+                memoryRequirements.size,
+                _block.buffer.hMemory,
+                memoryRequirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            vkBindBufferMemory(m_pInstanceCreator->GetDevice(), _block.buffer.hBuffer, _block.buffer.hMemory, 0);
+        }
+
+
+        bool BufferArena::_TryAllocate(_Block& _block, size_t _uSize, size_t _uAlignment, size_t& _uOffset) {
+            // block allocator has no upper bound, regions that end up past the block are given back
+            MemoryRegion region = _block.allocator.RequestMemory(_uSize, _uAlignment);
+            if (region.uOffset + region.uSize > _block.uSize) {
+                _block.allocator.FreeMemory(region.uOffset);
+                return false;
+            }
+
+            _block.uAllocationCount++;
+            m_uUsedSize += region.uSize;
+            m_uHighWaterMark = std::max(m_uHighWaterMark, m_uUsedSize);
+            _uOffset = _block.uBaseOffset + region.uOffset;
+            return true;
+        }
+
+
+        size_t BufferArena::_FindBlockIndex(size_t _uOffset) const {
+            auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), _uOffset,
+                [](size_t _uOffset, const _Block& _block) { return _uOffset < _block.uBaseOffset; });
+
+            DENG_ASSERT(it != m_blocks.begin());
+            return static_cast<size_t>(it - m_blocks.begin()) - 1;
+        }
+
+
+        size_t BufferArena::Allocate(size_t _uSize, size_t _uAlignment) {
+            size_t uOffset = 0;
+            for (_Block& block : m_blocks) {
+                if (block.buffer.hBuffer != VK_NULL_HANDLE && _TryAllocate(block, _uSize, _uAlignment, uOffset))
+                    return uOffset;
+            }
+
+            // empty allocator always places the first region at offset 0
+            const size_t uAlignedSize = (_uSize + _uAlignment - 1) & ~(_uAlignment - 1);
+            for (_Block& block : m_blocks) {
+                if (block.buffer.hBuffer == VK_NULL_HANDLE && uAlignedSize <= block.uSize) {
+                    _CreateBlockBuffer(block);
+                    _TryAllocate(block, _uSize, _uAlignment, uOffset);
+                    return uOffset;
+                }
+            }
+
+            size_t uBlockSize = std::max(static_cast<size_t>(m_uDefaultBlockSize), (uAlignedSize * 3) >> 1);
+            uBlockSize = (uBlockSize + BUFFER_ARENA_BLOCK_ALIGNMENT - 1) & ~static_cast<size_t>(BUFFER_ARENA_BLOCK_ALIGNMENT - 1);
+
+            // tells apart growth caused by fragmentation from growth caused by actual usage
+            LOG("Buffer arena statistics before growth: " << GetStatistics().ToJson());
+
+            m_blocks.emplace_back();
+            m_blocks.back().uBaseOffset = m_uArenaSize;
+            m_blocks.back().uSize = uBlockSize;
+            _CreateBlockBuffer(m_blocks.back());
+            m_uArenaSize += uBlockSize;
+
+            LOG("Appended buffer arena block of " << uBlockSize << " bytes, arena size is now " << m_uArenaSize << " bytes");
+            _TryAllocate(m_blocks.back(), _uSize, _uAlignment, uOffset);
+            return uOffset;
+        }
+
+
+        void BufferArena::Free(size_t _uOffset) {
+            _Block& block = m_blocks[_FindBlockIndex(_uOffset)];
+            DENG_ASSERT(block.buffer.hBuffer != VK_NULL_HANDLE);
+
+            const size_t uUsedSize = block.allocator.GetUsedSize();
+            if (!block.allocator.FreeMemory(_uOffset - block.uBaseOffset))
+                return;
+            m_uUsedSize -= uUsedSize - block.allocator.GetUsedSize();
+
+            block.uAllocationCount--;
+            if (block.uAllocationCount || &block == &m_blocks.front())
+                return;
+
+            // command buffers of frames in flight might still reference the block
+            m_deletionQueue.RetireBuffer(block.buffer);
+            block.buffer = BufferData();
+            block.allocator = GPUMemoryAllocator();
+        }
+
+
+        VkBuffer BufferArena::Resolve(size_t _uOffset, VkDeviceSize& _uLocalOffset) const {
+            const _Block& block = m_blocks[_FindBlockIndex(_uOffset)];
+            DENG_ASSERT(block.buffer.hBuffer != VK_NULL_HANDLE);
+
+            _uLocalOffset = static_cast<VkDeviceSize>(_uOffset - block.uBaseOffset);
+            return block.buffer.hBuffer;
+        }
+
+
+        MemoryStatistics BufferArena::GetStatistics() const {
+            MemoryStatistics statistics;
+            for (const _Block& block : m_blocks) {
+                if (block.buffer.hBuffer == VK_NULL_HANDLE)
+                    continue;
+
+                MemoryStatistics blockStatistics = block.allocator.GetStatistics();
+                const size_t uTailSize = block.uSize - block.allocator.GetEndOffset();
+                blockStatistics.uCapacity = block.uSize;
+                blockStatistics.uFreeBytes += uTailSize;
+                if (uTailSize) {
+                    blockStatistics.uFragmentCount++;
+                    blockStatistics.uLargestFreeBlock = std::max(blockStatistics.uLargestFreeBlock, uTailSize);
+                }
+
+                statistics.Accumulate(blockStatistics);
+            }
+
+            statistics.uHighWaterMark = m_uHighWaterMark;
+            return statistics;
+        }
+    }
+}
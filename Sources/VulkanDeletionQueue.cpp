@@ -0,0 +1,59 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanDeletionQueue.cpp - Vulkan frame deferred object deletion queue class implementation
+// author: Karl-Mihkel Ott
+
+#include "deng/VulkanDeletionQueue.h"
+
+namespace DENG {
+    namespace Vulkan {
+
+        DeletionQueue::DeletionQueue(VkDevice _hDevice) :
+            m_hDevice(_hDevice)
+        {
+        }
+
+
+        DeletionQueue::~DeletionQueue() {
+            for (_RetiredObjects& objects : m_frames)
+                _DestroyObjects(objects);
+        }
+
+
+        void DeletionQueue::_DestroyObjects(_RetiredObjects& _objects) {
+            for (VkPipeline hPipeline : _objects.pipelines)
+                vkDestroyPipeline(m_hDevice, hPipeline, nullptr);
+            for (VkPipelineLayout hPipelineLayout : _objects.pipelineLayouts)
+                vkDestroyPipelineLayout(m_hDevice, hPipelineLayout, nullptr);
+            for (VkDescriptorPool hDescriptorPool : _objects.descriptorPools)
+                vkDestroyDescriptorPool(m_hDevice, hDescriptorPool, nullptr);
+            for (VkSampler hSampler : _objects.samplers)
+                vkDestroySampler(m_hDevice, hSampler, nullptr);
+            for (VkImageView hImageView : _objects.imageViews)
+                vkDestroyImageView(m_hDevice, hImageView, nullptr);
+            for (VkImage hImage : _objects.images)
+                vkDestroyImage(m_hDevice, hImage, nullptr);
+            for (VkBuffer hBuffer : _objects.buffers)
+                vkDestroyBuffer(m_hDevice, hBuffer, nullptr);
+            for (VkDeviceMemory hMemory : _objects.memory)
+                vkFreeMemory(m_hDevice, hMemory, nullptr);
+
+            _objects.pipelines.clear();
+            _objects.pipelineLayouts.clear();
+            _objects.descriptorPools.clear();
+            _objects.samplers.clear();
+            _objects.imageViews.clear();
+            _objects.images.clear();
+            _objects.buffers.clear();
+            _objects.memory.clear();
+        }
+
+
+        void DeletionQueue::NextFrame() {
+            m_uFrameCounter++;
+
+            // this bucket was filled MAX_FRAMES_IN_FLIGHT + 1 frames ago
+            _DestroyObjects(_GetCurrentFrame());
+        }
+    }
+}
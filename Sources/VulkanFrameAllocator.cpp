@@ -0,0 +1,74 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanFrameAllocator.cpp - Vulkan per-frame linear buffer allocator class implementation
+// author: Karl-Mihkel Ott
+
+#define VULKAN_FRAME_ALLOCATOR_CPP
+#include "deng/VulkanFrameAllocator.h"
+
+namespace DENG {
+    namespace Vulkan {
+
+        FrameAllocator::FrameAllocator(BufferArena& _bufferArena, size_t _uSliceSize) :
+            m_bufferArena(_bufferArena)
+        {
+            _AllocateRegion(_uSliceSize);
+        }
+
+
+        FrameAllocator::~FrameAllocator() {
+            for (_Slice& slice : m_slices) {
+                for (size_t uOffset : slice.overflowRegions)
+                    m_bufferArena.Free(uOffset);
+            }
+
+            m_bufferArena.Free(m_uRegionOffset);
+        }
+
+
+        void FrameAllocator::_AllocateRegion(size_t _uSliceSize) {
+            // slice offsets keep the arena block alignment, which satisfies every vertex, index and uniform alignment
+            m_uSliceSize = (_uSliceSize + BUFFER_ARENA_BLOCK_ALIGNMENT - 1) & ~static_cast<size_t>(BUFFER_ARENA_BLOCK_ALIGNMENT - 1);
+            m_uRegionOffset = m_bufferArena.Allocate(m_uSliceSize * m_slices.size(), BUFFER_ARENA_BLOCK_ALIGNMENT);
+            LOG("Frame allocator slice size is " << m_uSliceSize << " bytes");
+        }
+
+
+        size_t FrameAllocator::Allocate(size_t _uSize, size_t _uAlignment) {
+            DENG_ASSERT(_uAlignment && _uAlignment <= BUFFER_ARENA_BLOCK_ALIGNMENT);
+            m_uRequestedSize += _uSize + _uAlignment - 1;
+
+            _Slice& slice = _GetCurrentSlice();
+            const size_t uLocalOffset = (slice.uUsedSize + _uAlignment - 1) & ~(_uAlignment - 1);
+            if (uLocalOffset + _uSize <= m_uSliceSize) {
+                slice.uUsedSize = uLocalOffset + _uSize;
+                return m_uRegionOffset + static_cast<size_t>(m_uFrameCounter % m_slices.size()) * m_uSliceSize + uLocalOffset;
+            }
+
+            // slice is exhausted for this frame
+            const size_t uOffset = m_bufferArena.Allocate(_uSize, _uAlignment);
+            slice.overflowRegions.push_back(uOffset);
+            return uOffset;
+        }
+
+
+        void FrameAllocator::NextFrame() {
+            const size_t uRequestedSize = m_uRequestedSize;
+            m_uRequestedSize = 0;
+            m_uFrameCounter++;
+
+            // this slice was last used MAX_FRAMES_IN_FLIGHT + 1 frames ago
+            _Slice& slice = _GetCurrentSlice();
+            for (size_t uOffset : slice.overflowRegions)
+                m_bufferArena.Free(uOffset);
+            slice.overflowRegions.clear();
+            slice.uUsedSize = 0;
+
+            if (uRequestedSize > m_uSliceSize) {
+                // other slices might still be read by frames in flight, old region is freed once the current slice is reset again
+                slice.overflowRegions.push_back(m_uRegionOffset);
+                _AllocateRegion((uRequestedSize * 3) >> 1);
+            }
+        }
+    }
+}
@@ -12,13 +12,15 @@ namespace DENG {
 
         Framebuffer::Framebuffer(
             const InstanceCreator* _pInstanceCreator, 
-            VkBuffer& _hMainBuffer,
+            const BufferArena& _mainBufferArena,
             VkSampleCountFlagBits _uSampleCountBits,
             TRS::Point2D<uint32_t> _extent,
-            bool _bIsSwapchain) :
+            bool _bIsSwapchain,
+            StagingRing* _pStagingRing) :
             IFramebuffer(_extent.x, _extent.y),
             m_pInstanceCreator(_pInstanceCreator),
-            m_hMainBuffer(_hMainBuffer),
+            m_mainBufferArena(_mainBufferArena),
+            m_pStagingRing(_pStagingRing),
             m_uSampleCountBits(_uSampleCountBits)
         {
             try {
@@ -48,6 +50,11 @@ namespace DENG {
 
 
         Framebuffer::~Framebuffer() {
+            // pipeline jobs use the render pass
+            for (auto it = m_pendingPipelineCreators.begin(); it != m_pendingPipelineCreators.end(); it++)
+                it->second.wait();
+            m_pendingPipelineCreators.clear();
+
             _DestroyFramebuffer();
             const VkDevice hDevice = m_pInstanceCreator->GetDevice();
 
@@ -304,6 +311,142 @@ namespace DENG {
         }
 
 
+        PipelineCreator* Framebuffer::_GetPipelineCreator(
+            cvar::hash_t _hshPipeline,
+            const IShader* _pShader,
+            VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+            VkDescriptorSetLayout _hMaterialDescriptorSetLayout)
+        {
+            auto itPipelineCreator = m_pipelineCreators.find(_hshPipeline);
+            if (itPipelineCreator != m_pipelineCreators.end())
+                return &itPipelineCreator->second;
+
+            if (m_failedPipelines.find(_hshPipeline) != m_failedPipelines.end())
+                return nullptr;
+
+            auto itDeferred = m_deferredPipelineCreators.find(_hshPipeline);
+            if (itDeferred != m_deferredPipelineCreators.end()) {
+                if (itDeferred->second.pShader->IsSpirvReady()) {
+                    _SubmitPipelineCreator(
+                        _hshPipeline,
+                        itDeferred->second.pShader,
+                        itDeferred->second.hShaderDescriptorSetLayout,
+                        itDeferred->second.hMaterialDescriptorSetLayout);
+                    m_deferredPipelineCreators.erase(itDeferred);
+                }
+                return nullptr;
+            }
+
+            auto itPending = m_pendingPipelineCreators.find(_hshPipeline);
+            if (itPending == m_pendingPipelineCreators.end()) {
+                RequestPipelineCreator(_hshPipeline, _pShader, _hShaderDescriptorSetLayout, _hMaterialDescriptorSetLayout);
+                return nullptr;
+            }
+
+            if (itPending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return nullptr;
+
+            std::future<PipelineCreator> job = std::move(itPending->second);
+            m_pendingPipelineCreators.erase(itPending);
+
+            try {
+                return &m_pipelineCreators.emplace(_hshPipeline, job.get()).first->second;
+            }
+            catch (const RendererException& e) {
+                m_failedPipelines.insert(_hshPipeline);
+                DISPATCH_ERROR_MESSAGE("RendererException", e.what(), ErrorSeverity::NON_CRITICAL);
+                return nullptr;
+            }
+        }
+
+
+        void Framebuffer::_SubmitPipelineCreator(
+            cvar::hash_t _hshPipeline,
+            const IShader* _pShader,
+            VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+            VkDescriptorSetLayout _hMaterialDescriptorSetLayout)
+        {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            const VkRenderPass hRenderPass = m_hRenderpass;
+            const VkSampleCountFlagBits uSampleCountBits = m_uSampleCountBits;
+            const PhysicalDeviceInformation* pInformation = &m_pInstanceCreator->GetPhysicalDeviceInformation();
+
+            m_pendingPipelineCreators.emplace(_hshPipeline, ThreadPool::GetInstance().Submit(
+                [=]() {
+                    return PipelineCreator(
+                        hDevice,
+                        hRenderPass,
+                        _hShaderDescriptorSetLayout,
+                        _hMaterialDescriptorSetLayout,
+                        uSampleCountBits,
+                        *pInformation,
+                        _pShader);
+                }));
+        }
+
+
+        cvar::hash_t Framebuffer::_GetFallbackPipelineKey(
+            cvar::hash_t _hshFallbackShader,
+            VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+            VkDescriptorSetLayout _hMaterialDescriptorSetLayout)
+        {
+            // non-dispatchable handles are 64 bit values on every platform
+            const uint64_t arrHandles[] = { (uint64_t)_hShaderDescriptorSetLayout, (uint64_t)_hMaterialDescriptorSetLayout };
+            cvar::hash_t hshPipeline = _hshFallbackShader;
+            for (uint64_t uHandle : arrHandles)
+                hshPipeline ^= uHandle + 0x9e3779b97f4a7c15ull + (hshPipeline << 6) + (hshPipeline >> 2);
+
+            m_fallbackPipelineKeys[_hshFallbackShader].insert(hshPipeline);
+            return hshPipeline;
+        }
+
+
+        void Framebuffer::RequestPipelineCreator(
+            cvar::hash_t _hshShader,
+            const IShader* _pShader,
+            VkDescriptorSetLayout _hShaderDescriptorSetLayout,
+            VkDescriptorSetLayout _hMaterialDescriptorSetLayout)
+        {
+            DENG_ASSERT(_pShader);
+            if (m_pipelineCreators.find(_hshShader) != m_pipelineCreators.end() ||
+                m_pendingPipelineCreators.find(_hshShader) != m_pendingPipelineCreators.end() ||
+                m_deferredPipelineCreators.find(_hshShader) != m_deferredPipelineCreators.end() ||
+                m_failedPipelines.find(_hshShader) != m_failedPipelines.end())
+            {
+                return;
+            }
+
+            if (!_pShader->IsSpirvReady()) {
+                m_deferredPipelineCreators.emplace(_hshShader, _DeferredPipelineCreator{ _pShader, _hShaderDescriptorSetLayout, _hMaterialDescriptorSetLayout });
+                return;
+            }
+
+            _SubmitPipelineCreator(_hshShader, _pShader, _hShaderDescriptorSetLayout, _hMaterialDescriptorSetLayout);
+        }
+
+
+        void Framebuffer::WaitForPipelineCreators() {
+            // compilation is waited for on the calling thread, thus creation jobs do not block the pool
+            for (auto it = m_deferredPipelineCreators.begin(); it != m_deferredPipelineCreators.end(); it++) {
+                it->second.pShader->WaitForSpirv();
+                _SubmitPipelineCreator(it->first, it->second.pShader, it->second.hShaderDescriptorSetLayout, it->second.hMaterialDescriptorSetLayout);
+            }
+            m_deferredPipelineCreators.clear();
+
+            for (auto it = m_pendingPipelineCreators.begin(); it != m_pendingPipelineCreators.end(); it++) {
+                try {
+                    m_pipelineCreators.emplace(it->first, it->second.get());
+                }
+                catch (const RendererException& e) {
+                    m_failedPipelines.insert(it->first);
+                    DISPATCH_ERROR_MESSAGE("RendererException", e.what(), ErrorSeverity::NON_CRITICAL);
+                }
+            }
+
+            m_pendingPipelineCreators.clear();
+        }
+
+
         void Framebuffer::BeginCommandBufferRecording(TRS::Vector4<float> _vClearColor) {
             if (m_pSwapchainCreator) {
                 vkWaitForFences(m_pInstanceCreator->GetDevice(), 1, &m_flightFences[m_uCurrentFrameIndex], VK_TRUE, UINT64_MAX);
@@ -359,28 +502,28 @@ namespace DENG {
             VkDescriptorSet _hShaderDescriptorSet, 
             VkDescriptorSet _hMaterialDescriptorSet,
             VkDescriptorSetLayout _hShaderDescriptorSetLayout,
-            VkDescriptorSetLayout _hMaterialDescriptorSetLayout) 
+            VkDescriptorSetLayout _hMaterialDescriptorSetLayout,
+            cvar::hash_t _hshFallbackShader) 
         {
             ResourceManager& resourceManager = ResourceManager::GetInstance();
             const IShader* pShader = resourceManager.GetShader(_hshShader);
             const MeshCommands* pMesh = resourceManager.GetMesh(_hshMesh);
 
-            // check if pipeline creator needs to be created
-            if (m_pipelineCreators.find(_hshShader) == m_pipelineCreators.end()) {
-                m_pipelineCreators.emplace(
-                    std::piecewise_construct,
-                    std::forward_as_tuple(_hshShader),
-                    std::forward_as_tuple(
-                        m_pInstanceCreator->GetDevice(),
-                        m_hRenderpass,
-                        _hShaderDescriptorSetLayout,
-                        _hMaterialDescriptorSetLayout,
-                        m_uSampleCountBits,
-                        m_pInstanceCreator->GetPhysicalDeviceInformation(),
-                        pShader
-                    ));
+            PipelineCreator* pPipelineCreator = _GetPipelineCreator(_hshShader, pShader, _hShaderDescriptorSetLayout, _hMaterialDescriptorSetLayout);
+            // fallback shader shares vertex attributes and descriptor set layouts with the requested shader
+            if (!pPipelineCreator && _hshFallbackShader) {
+                const IShader* pFallbackShader = resourceManager.GetShader(_hshFallbackShader);
+                DENG_ASSERT(pFallbackShader);
+                pPipelineCreator = _GetPipelineCreator(
+                    _GetFallbackPipelineKey(_hshFallbackShader, _hShaderDescriptorSetLayout, _hMaterialDescriptorSetLayout),
+                    pFallbackShader,
+                    _hShaderDescriptorSetLayout,
+                    _hMaterialDescriptorSetLayout);
             }
 
+            if (!pPipelineCreator)
+                return;
+
             // check if custom viewport should be used
             if (pShader->IsPropertySet(ShaderPropertyBit_EnableCustomViewport)) {
                 VkViewport viewport = {};
@@ -407,27 +550,30 @@ namespace DENG {
             
             // submit each draw command in mesh
             for (auto itCmd = pMesh->drawCommands.begin(); itCmd != pMesh->drawCommands.end(); itCmd++) {
-                auto itPipelineCreator = m_pipelineCreators.find(_hshShader);
                 vkCmdBindPipeline(
                     m_commandBuffers[m_uCurrentFrameIndex], 
                     VK_PIPELINE_BIND_POINT_GRAPHICS, 
-                    itPipelineCreator->second.GetPipeline());
+                    pPipelineCreator->GetPipeline());
 
-                std::vector<VkBuffer> buffers(pShader->GetAttributeTypes().size(), m_hMainBuffer);
+                // attributes might be stored in different arena blocks
+                std::vector<VkBuffer> buffers(pShader->GetAttributeTypes().size());
+                std::vector<VkDeviceSize> offsets(buffers.size());
+                for (size_t i = 0; i < buffers.size(); i++)
+                    buffers[i] = m_mainBufferArena.Resolve(itCmd->attributeOffsets[i], offsets[i]);
                 
                 vkCmdBindVertexBuffers(
                     m_commandBuffers[m_uCurrentFrameIndex],
                     0,
                     static_cast<uint32_t>(buffers.size()),
                     buffers.data(),
-                    itCmd->attributeOffsets.data());
+                    offsets.data());
 
                 // bind both descriptor sets
                 if (descriptorSets[0] && descriptorSets[1]) {
                     vkCmdBindDescriptorSets(
                         m_commandBuffers[m_uCurrentFrameIndex],
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        itPipelineCreator->second.GetPipelineLayout(),
+                        pPipelineCreator->GetPipelineLayout(),
                         0,
                         2,
                         descriptorSets.data(),
@@ -438,7 +584,7 @@ namespace DENG {
                     vkCmdBindDescriptorSets(
                         m_commandBuffers[m_uCurrentFrameIndex],
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        itPipelineCreator->second.GetPipelineLayout(),
+                        pPipelineCreator->GetPipelineLayout(),
                         0,
                         1,
                         &descriptorSets[0],
@@ -449,7 +595,7 @@ namespace DENG {
                     vkCmdBindDescriptorSets(
                         m_commandBuffers[m_uCurrentFrameIndex],
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        itPipelineCreator->second.GetPipelineLayout(),
+                        pPipelineCreator->GetPipelineLayout(),
                         0,
                         1,
                         &descriptorSets[1],
@@ -492,7 +638,7 @@ namespace DENG {
 
                     vkCmdPushConstants(
                         m_commandBuffers[m_uCurrentFrameIndex],
-                        itPipelineCreator->second.GetPipelineLayout(),
+                        pPipelineCreator->GetPipelineLayout(),
                         bShaderStage,
                         0,
                         pShader->GetPushConstant().uLength,
@@ -501,7 +647,9 @@ namespace DENG {
 
                 // check if indexed or unindexed draw call should be submitted
                 if (pShader->IsPropertySet(ShaderPropertyBit_EnableIndexing)) {
-                    vkCmdBindIndexBuffer(m_commandBuffers[m_uCurrentFrameIndex], m_hMainBuffer, static_cast<VkDeviceSize>(itCmd->uIndicesOffset), VK_INDEX_TYPE_UINT32);
+                    VkDeviceSize uIndicesOffset = 0;
+                    VkBuffer hIndexBuffer = m_mainBufferArena.Resolve(itCmd->uIndicesOffset, uIndicesOffset);
+                    vkCmdBindIndexBuffer(m_commandBuffers[m_uCurrentFrameIndex], hIndexBuffer, uIndicesOffset, VK_INDEX_TYPE_UINT32);
                     vkCmdDrawIndexed(m_commandBuffers[m_uCurrentFrameIndex], itCmd->uDrawCount, _uInstanceCount, _uFirstInstance, 0, 0);
                 } else {
                     vkCmdDraw(m_commandBuffers[m_uCurrentFrameIndex], itCmd->uDrawCount, _uInstanceCount, 0, _uFirstInstance);
@@ -520,6 +668,12 @@ namespace DENG {
         void Framebuffer::RenderToFramebuffer() {
             VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
+            // buffer uploads made while recording are copied right before the draw commands of the same batch
+            std::array<VkCommandBuffer, 2> commandBuffers = { VK_NULL_HANDLE, m_commandBuffers[m_uCurrentFrameIndex] };
+            if (m_pStagingRing)
+                commandBuffers[0] = m_pStagingRing->Flush();
+            const uint32_t uFirstCommandBuffer = commandBuffers[0] == VK_NULL_HANDLE ? 1 : 0;
+
             VkSubmitInfo submitInfo = {};
             submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
             if (m_pSwapchainCreator) {
@@ -529,14 +683,17 @@ namespace DENG {
                 submitInfo.signalSemaphoreCount = 1;
                 submitInfo.pSignalSemaphores = &m_renderFinishedSemaphores[m_uCurrentFrameIndex];
             }
-            submitInfo.commandBufferCount = 1;
-            submitInfo.pCommandBuffers = &m_commandBuffers[m_uCurrentFrameIndex];
+            submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size()) - uFirstCommandBuffer;
+            submitInfo.pCommandBuffers = &commandBuffers[uFirstCommandBuffer];
 
             // submit the graphics queue
             if (vkQueueSubmit(m_pInstanceCreator->GetGraphicsQueue(), 1, &submitInfo, m_flightFences[m_uCurrentFrameIndex]) != VK_SUCCESS) {
                 throw RendererException("vkQueueSubmit() failed to submit a command buffer to render queue");
             }
 
+            if (commandBuffers[0] != VK_NULL_HANDLE)
+                m_pStagingRing->EndSegment(m_pInstanceCreator->GetGraphicsQueue());
+
             if (m_pSwapchainCreator) {
                 VkPresentInfoKHR presentInfo = {};
                 presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -560,6 +717,44 @@ namespace DENG {
             }
         }
 
+        void Framebuffer::_RetirePipeline(cvar::hash_t _hshPipeline, DeletionQueue& _deletionQueue) {
+            m_deferredPipelineCreators.erase(_hshPipeline);
+            m_failedPipelines.erase(_hshPipeline);
+
+            // creation can not be cancelled, thus its result is retired like any other pipeline
+            auto itPending = m_pendingPipelineCreators.find(_hshPipeline);
+            if (itPending != m_pendingPipelineCreators.end()) {
+                try {
+                    m_pipelineCreators.emplace(_hshPipeline, itPending->second.get());
+                }
+                catch (const RendererException&) {}
+                m_pendingPipelineCreators.erase(itPending);
+            }
+
+            auto itPipelineCreator = m_pipelineCreators.find(_hshPipeline);
+            if (itPipelineCreator == m_pipelineCreators.end())
+                return;
+
+            _deletionQueue.RetirePipeline(itPipelineCreator->second.GetPipeline());
+            _deletionQueue.RetirePipelineLayout(itPipelineCreator->second.GetPipelineLayout());
+            itPipelineCreator->second.ReleasePipelineHandles();
+            m_pipelineCreators.erase(itPipelineCreator);
+        }
+
+
+        void Framebuffer::DestroyPipeline(cvar::hash_t _hshShader, DeletionQueue& _deletionQueue) {
+            _RetirePipeline(_hshShader, _deletionQueue);
+
+            auto itFallbackKeys = m_fallbackPipelineKeys.find(_hshShader);
+            if (itFallbackKeys == m_fallbackPipelineKeys.end())
+                return;
+
+            for (cvar::hash_t hshPipeline : itFallbackKeys->second)
+                _RetirePipeline(hshPipeline, _deletionQueue);
+            m_fallbackPipelineKeys.erase(itFallbackKeys);
+        }
+
+
         void Framebuffer::RecreateFramebuffer(uint32_t _uWidth, uint32_t _uHeight) {
             m_uWidth = _uWidth;
             m_uHeight = _uHeight;
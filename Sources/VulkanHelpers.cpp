@@ -195,6 +195,51 @@ namespace DENG {
         }
 
 
+        void _CopyBufferToImageMips(
+            VkDevice _dev,
+            VkCommandPool _cmd_pool,
+            VkQueue _graphics_queue,
+            VkBuffer _src,
+            VkImage _dst,
+            uint32_t _width,
+            uint32_t _height,
+            uint32_t _mip_l,
+            uint32_t _array_count,
+            VkDeviceSize _block_size)
+        {
+            std::vector<VkBufferImageCopy> copy_regions;
+            copy_regions.reserve(static_cast<size_t>(_mip_l) * _array_count);
+
+            VkDeviceSize offset = 0;
+            for (uint32_t layer = 0; layer < _array_count; layer++) {
+                for (uint32_t mip = 0; mip < _mip_l; mip++) {
+                    const uint32_t mip_width = std::max(_width >> mip, 1u);
+                    const uint32_t mip_height = std::max(_height >> mip, 1u);
+
+                    VkBufferImageCopy copy_region{};
+                    copy_region.bufferOffset = offset;
+                    copy_region.bufferRowLength = 0;
+                    copy_region.bufferImageHeight = 0;
+                    copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    copy_region.imageSubresource.mipLevel = mip;
+                    copy_region.imageSubresource.baseArrayLayer = layer;
+                    copy_region.imageSubresource.layerCount = 1;
+                    copy_region.imageOffset = { 0, 0, 0 };
+                    copy_region.imageExtent = { mip_width, mip_height, 1 };
+                    copy_regions.push_back(copy_region);
+
+                    // 4x4 texel blocks
+                    offset += static_cast<VkDeviceSize>((mip_width + 3) / 4) * ((mip_height + 3) / 4) * _block_size;
+                }
+            }
+
+            VkCommandBuffer tmp_cmd_buf;
+            _BeginCommandBufferSingleCommand(_dev, _cmd_pool, tmp_cmd_buf);
+            vkCmdCopyBufferToImage(tmp_cmd_buf, _src, _dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
+            _EndCommandBufferSingleCommand(_dev, _graphics_queue, _cmd_pool, tmp_cmd_buf);
+        }
+
+
         VkSampler _CreateTextureSampler(VkDevice _dev, float _max_sampler_anisotropy, uint32_t _mip_level) {
             VkSamplerCreateInfo sampler_info = {};
             sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -222,6 +267,96 @@ namespace DENG {
         }
 
 
+        bool _IsLinearBlitSupported(VkPhysicalDevice _gpu, VkFormat _format) {
+            VkFormatProperties format_properties = {};
+            vkGetPhysicalDeviceFormatProperties(_gpu, _format, &format_properties);
+
+            const VkFormatFeatureFlags required_features = 
+                VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            return (format_properties.optimalTilingFeatures & required_features) == required_features;
+        }
+
+
+        void _GenerateMipmaps(
+            VkDevice _dev,
+            VkCommandPool _cmd_pool,
+            VkQueue _graphics_q,
+            VkImage _img,
+            uint32_t _width,
+            uint32_t _height,
+            uint32_t _mip_l,
+            uint32_t _array_count)
+        {
+            VkCommandBuffer tmp_cmd_buf;
+            _BeginCommandBufferSingleCommand(_dev, _cmd_pool, tmp_cmd_buf);
+
+            VkImageMemoryBarrier memory_barrier = {};
+            memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            memory_barrier.image = _img;
+            memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            memory_barrier.subresourceRange.levelCount = 1;
+            memory_barrier.subresourceRange.baseArrayLayer = 0;
+            memory_barrier.subresourceRange.layerCount = _array_count;
+
+            int32_t mip_width = static_cast<int32_t>(_width);
+            int32_t mip_height = static_cast<int32_t>(_height);
+
+            // each level is blitted from the previous one, which is then no longer written to
+            for (uint32_t i = 1; i < _mip_l; i++) {
+                memory_barrier.subresourceRange.baseMipLevel = i - 1;
+                memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                vkCmdPipelineBarrier(tmp_cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &memory_barrier);
+
+                const int32_t next_width = mip_width > 1 ? mip_width / 2 : 1;
+                const int32_t next_height = mip_height > 1 ? mip_height / 2 : 1;
+
+                VkImageBlit blit = {};
+                blit.srcOffsets[0] = { 0, 0, 0 };
+                blit.srcOffsets[1] = { mip_width, mip_height, 1 };
+                blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                blit.srcSubresource.mipLevel = i - 1;
+                blit.srcSubresource.baseArrayLayer = 0;
+                blit.srcSubresource.layerCount = _array_count;
+                blit.dstOffsets[0] = { 0, 0, 0 };
+                blit.dstOffsets[1] = { next_width, next_height, 1 };
+                blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                blit.dstSubresource.mipLevel = i;
+                blit.dstSubresource.baseArrayLayer = 0;
+                blit.dstSubresource.layerCount = _array_count;
+
+                vkCmdBlitImage(tmp_cmd_buf, 
+                    _img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
+                    _img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+                    1, &blit, 
+                    VK_FILTER_LINEAR);
+
+                memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                vkCmdPipelineBarrier(tmp_cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &memory_barrier);
+
+                mip_width = next_width;
+                mip_height = next_height;
+            }
+
+            // last level was only written to
+            memory_barrier.subresourceRange.baseMipLevel = _mip_l - 1;
+            memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(tmp_cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &memory_barrier);
+
+            _EndCommandBufferSingleCommand(_dev, _graphics_q, _cmd_pool, tmp_cmd_buf);
+        }
+
+
         VkMemoryRequirements _CreateBuffer(VkDevice _dev, VkDeviceSize _size, VkBufferUsageFlags _usage, VkBuffer &_buffer) {
             // Set up buffer createinfo struct 
             VkBufferCreateInfo buffer_createinfo{};
@@ -242,6 +377,38 @@ namespace DENG {
         }
 
 
+        BufferData _CreateMappedBuffer(VkDevice _dev, VkPhysicalDevice _gpu, VkDeviceSize _size, VkBufferUsageFlags _flags) {
+            BufferData buffer;
+            buffer.uSize = _size;
+
+            VkMemoryRequirements mem_req = _CreateBuffer(_dev, _size, _flags, buffer.hBuffer);
+            _AllocateMemory(
+                _dev, 
+                _gpu, 
+                mem_req.size, 
+                buffer.hMemory, 
+                mem_req.memoryTypeBits, 
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            vkBindBufferMemory(_dev, buffer.hBuffer, buffer.hMemory, 0);
+
+            void *data = nullptr;
+            if (vkMapMemory(_dev, buffer.hMemory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+                VK_BUFFER_ERR("Failed to map host visible buffer memory!");
+            buffer.pMappedMemory = static_cast<char*>(data);
+
+            return buffer;
+        }
+
+
+        void _DestroyMappedBuffer(VkDevice _dev, BufferData& _buffer) {
+            if (_buffer.pMappedMemory)
+                vkUnmapMemory(_dev, _buffer.hMemory);
+            vkDestroyBuffer(_dev, _buffer.hBuffer, nullptr);
+            vkFreeMemory(_dev, _buffer.hMemory, nullptr);
+            _buffer = BufferData();
+        }
+
+
         void _CopyToBufferMemory(VkDevice _dev, VkDeviceSize _size, const void *_src, VkDeviceMemory _dst, VkDeviceSize _offset) {
             void *buf;
             vkMapMemory(_dev, _dst, _offset, _size, 0, &buf);
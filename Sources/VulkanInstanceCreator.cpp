@@ -275,6 +275,10 @@ namespace DENG {
             m_physicalDeviceInformation.fMaxSamplerAnisotropy =
                 deviceProperties.limits.maxSamplerAnisotropy;
 
+            VkPhysicalDeviceFeatures supportedFeatures;
+            vkGetPhysicalDeviceFeatures(m_hPhysicalDevice, &supportedFeatures);
+            m_physicalDeviceInformation.bTextureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
             switch(deviceProperties.deviceType) {
                 case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
                     m_physicalDeviceInformation.eDeviceType = PhysicalDeviceType::INTEGRATED_GPU;
@@ -358,6 +362,7 @@ namespace DENG {
             VkPhysicalDeviceFeatures deviceFeatures = {};
             deviceFeatures.samplerAnisotropy = VK_TRUE;
             deviceFeatures.geometryShader = VK_TRUE;
+            deviceFeatures.textureCompressionBC = m_physicalDeviceInformation.bTextureCompressionBC ? VK_TRUE : VK_FALSE;
 
             // Create device createinfo
             VkDeviceCreateInfo logicalDeviceCreateInfo = {};
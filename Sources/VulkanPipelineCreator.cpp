@@ -36,14 +36,16 @@ namespace DENG {
             pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
 
             if (_pShader->GetPipelineCacheStatus() & PipelineCacheStatusBit_VulkanCache) {
-                auto cacheBytes = _pShader->GetPipelineCache(RendererType::Vulkan);
+                // mapped cache file only has to stay alive until vkCreatePipelineCache() has consumed it
+                const FileView cacheBytes = _pShader->GetPipelineCache(RendererType::Vulkan);
                 
                 VkPipelineCacheHeaderVersionOne header = {};
-                memcpy(&header, cacheBytes.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+                if (cacheBytes.Size() >= sizeof(VkPipelineCacheHeaderVersionOne))
+                    memcpy(&header, cacheBytes.Data(), sizeof(VkPipelineCacheHeaderVersionOne));
 
                 if (header.deviceID == _information.uDeviceId && header.vendorID == _information.uVendorId) {
-                    pipelineCacheCreateInfo.initialDataSize = cacheBytes.size();
-                    pipelineCacheCreateInfo.pInitialData = cacheBytes.data();
+                    pipelineCacheCreateInfo.initialDataSize = cacheBytes.Size();
+                    pipelineCacheCreateInfo.pInitialData = cacheBytes.Data();
 
                     if (vkCreatePipelineCache(m_hDevice, &pipelineCacheCreateInfo, nullptr, &m_hPipelineCache) != VK_SUCCESS)
                         throw RendererException("vkCreatePipelineCache() failed to create pipeline cache");
@@ -29,15 +29,26 @@ namespace DENG {
                 vkDestroyDescriptorSetLayout(m_pInstanceCreator->GetDevice(), it->second.hDescriptorSetLayout, nullptr);
             }
 
-            DeleteTextureHandles();
+            for (auto it = m_textureHandles.begin(); it != m_textureHandles.end(); it++)
+                m_pDeletionQueue->RetireTexture(it->second);
+            m_textureHandles.clear();
 
-            // free main buffers
-            vkDestroyBuffer(m_pInstanceCreator->GetDevice(), m_mainBuffer.hBuffer, NULL);
-            vkFreeMemory(m_pInstanceCreator->GetDevice(), m_mainBuffer.hMemory, NULL);
+            delete m_pStagingRing;
+            m_pStagingRing = nullptr;
+
+            delete m_pFrameAllocator;
+            m_pFrameAllocator = nullptr;
+
+            // free main buffer blocks
+            delete m_pMainBufferArena;
+            m_pMainBufferArena = nullptr;
+
+            // device is idle, every retired object can be destroyed
+            delete m_pDeletionQueue;
+            m_pDeletionQueue = nullptr;
 
             // free staging buffers
-            vkDestroyBuffer(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hBuffer, nullptr);
-            vkFreeMemory(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hMemory, nullptr);
+            Vulkan::_DestroyMappedBuffer(m_pInstanceCreator->GetDevice(), m_stagingBuffer);
 
             // delete instance creator
             delete m_pInstanceCreator;
@@ -50,35 +61,69 @@ namespace DENG {
         ResourceManager& resourceManager = ResourceManager::GetInstance();
         auto pImage = resourceManager.GetTexture(_hshImage);
         DENG_ASSERT(pImage);
-        DENG_ASSERT(pImage->pRGBAData);
+        // heap data is released once it is uploaded, thus deleted handles of such textures can't be recreated
+        if (!pImage->pRGBAData)
+            throw RendererException("Texture data was already released, cannot create texture handles");
 
         Vulkan::TextureData vulkanTextureData;
         VkFormat eFormat = VK_FORMAT_UNDEFINED;
-        switch (pImage->uBitDepth) {
-            case 1:
-                eFormat = VK_FORMAT_R8_UNORM;
+        const bool bIsCompressed = pImage->eFormat != TextureFormat::Raw;
+        if (bIsCompressed && !m_pInstanceCreator->GetPhysicalDeviceInformation().bTextureCompressionBC)
+            throw RendererException("Physical device does not support BC texture compression");
+
+        switch (pImage->eFormat) {
+            case TextureFormat::BC1:
+                eFormat = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
                 break;
 
-            case 2:
-                eFormat = VK_FORMAT_R8G8_UNORM;
+            case TextureFormat::BC3:
+                eFormat = VK_FORMAT_BC3_UNORM_BLOCK;
                 break;
 
-            case 3:
-                eFormat = VK_FORMAT_R8G8B8_UNORM;
+            case TextureFormat::BC5:
+                eFormat = VK_FORMAT_BC5_UNORM_BLOCK;
                 break;
 
-            case 4:
-                eFormat = VK_FORMAT_R8G8B8A8_UNORM;
+            case TextureFormat::BC7:
+                eFormat = VK_FORMAT_BC7_UNORM_BLOCK;
                 break;
 
             default:
-                DENG_ASSERT(false);
                 break;
         }
 
+        if (!bIsCompressed) {
+            switch (pImage->uBitDepth) {
+                case 1:
+                    eFormat = VK_FORMAT_R8_UNORM;
+                    break;
+
+                case 2:
+                    eFormat = VK_FORMAT_R8G8_UNORM;
+                    break;
+
+                case 3:
+                    eFormat = VK_FORMAT_R8G8B8_UNORM;
+                    break;
+
+                case 4:
+                    eFormat = VK_FORMAT_R8G8B8A8_UNORM;
+                    break;
+
+                default:
+                    DENG_ASSERT(false);
+                    break;
+            }
+        }
+
         VkDeviceSize uSize = 0;
         VkImageCreateFlagBits bImageBits = (VkImageCreateFlagBits)0;
-        const uint32_t uMipLevels = 1; // temporary
+        uint32_t uMipLevels = 1;
+        // block compressed textures come with their mip chain cooked in
+        if (bIsCompressed)
+            uMipLevels = pImage->uMipLevels;
+        else if (Vulkan::_IsLinearBlitSupported(m_pInstanceCreator->GetPhysicalDevice(), eFormat))
+            uMipLevels = CALC_MIPLVL(pImage->uWidth, pImage->uHeight) + 1;
         uint32_t uArrayCount = 0;
 
         switch (pImage->eResourceType) {
@@ -103,8 +148,11 @@ namespace DENG {
                 return;
         }
 
-        _CheckAndReallocateBufferResources(uSize, 0);
-        Vulkan::_CopyToBufferMemory(m_pInstanceCreator->GetDevice(), uSize, pImage->pRGBAData, m_stagingBuffer.hMemory, 0);
+        if (bIsCompressed)
+            uSize = static_cast<VkDeviceSize>(pImage->uDataSize);
+
+        _CheckAndReallocateStagingBuffer(static_cast<size_t>(uSize));
+        std::memcpy(m_stagingBuffer.pMappedMemory, pImage->pRGBAData, static_cast<size_t>(uSize));
         
         LOG("Creating vulkan image handle for texture " << _hshImage);
         VkMemoryRequirements memoryRequirements = Vulkan::_CreateImage(
@@ -142,25 +190,54 @@ namespace DENG {
             uArrayCount);
 
         // copy from staging buffer to image memory
-        Vulkan::_CopyBufferToImage(
-            m_pInstanceCreator->GetDevice(),
-            hCommandPool,
-            m_pInstanceCreator->GetGraphicsQueue(),
-            m_stagingBuffer.hBuffer,
-            vulkanTextureData.hImage,
-            pImage->uWidth,
-            pImage->uHeight,
-            uArrayCount);
+        if (bIsCompressed) {
+            Vulkan::_CopyBufferToImageMips(
+                m_pInstanceCreator->GetDevice(),
+                hCommandPool,
+                m_pInstanceCreator->GetGraphicsQueue(),
+                m_stagingBuffer.hBuffer,
+                vulkanTextureData.hImage,
+                pImage->uWidth,
+                pImage->uHeight,
+                uMipLevels,
+                uArrayCount,
+                static_cast<VkDeviceSize>(TextureCooker::GetBlockSize(pImage->eFormat)));
+        }
+        else {
+            Vulkan::_CopyBufferToImage(
+                m_pInstanceCreator->GetDevice(),
+                hCommandPool,
+                m_pInstanceCreator->GetGraphicsQueue(),
+                m_stagingBuffer.hBuffer,
+                vulkanTextureData.hImage,
+                pImage->uWidth,
+                pImage->uHeight,
+                uArrayCount);
+        }
 
-        Vulkan::_TransitionImageLayout(
-            m_pInstanceCreator->GetDevice(),
-            vulkanTextureData.hImage,
-            hCommandPool,
-            m_pInstanceCreator->GetGraphicsQueue(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            uMipLevels,
-            uArrayCount);
+        // rest of the mip chain is generated from the uploaded base level
+        if (!bIsCompressed && uMipLevels > 1) {
+            Vulkan::_GenerateMipmaps(
+                m_pInstanceCreator->GetDevice(),
+                hCommandPool,
+                m_pInstanceCreator->GetGraphicsQueue(),
+                vulkanTextureData.hImage,
+                pImage->uWidth,
+                pImage->uHeight,
+                uMipLevels,
+                uArrayCount);
+        }
+        else {
+            Vulkan::_TransitionImageLayout(
+                m_pInstanceCreator->GetDevice(),
+                vulkanTextureData.hImage,
+                hCommandPool,
+                m_pInstanceCreator->GetGraphicsQueue(),
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                uMipLevels,
+                uArrayCount);
+        }
 
         // create image view
         VkImageViewCreateInfo imageViewCreateInfo = {};
@@ -197,105 +274,22 @@ namespace DENG {
     }
 
 
-    void VulkanRenderer::_CheckAndReallocateBufferResources(size_t _uSize, size_t _uOffset) {
-        VkCommandPool hCommandPool = static_cast<Vulkan::Framebuffer*>(m_framebuffers[0])->GetCommandPool();
-
-        // check if device should be on idle
-        if (static_cast<VkDeviceSize>(_uSize) > m_stagingBuffer.uSize || static_cast<VkDeviceSize>(_uSize + _uOffset) > m_mainBuffer.uSize)
-            vkDeviceWaitIdle(m_pInstanceCreator->GetDevice());
-
-        // check if staging buffer reallocation is required
-        if (static_cast<VkDeviceSize>(_uSize) > m_stagingBuffer.uSize) {
-            vkFreeMemory(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hMemory, nullptr);
-            vkDestroyBuffer(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hBuffer, nullptr);
-
-            m_stagingBuffer.uSize = (_uSize * 3) >> 1;
-            const VkDeviceSize uMinUniformBufferAlignment = static_cast<VkDeviceSize>(m_pInstanceCreator->GetPhysicalDeviceInformation().uMinimalUniformBufferAlignment);
-            m_stagingBuffer.uSize = (m_stagingBuffer.uSize + uMinUniformBufferAlignment - 1) & ~(uMinUniformBufferAlignment - 1);
-
-            VkMemoryRequirements memoryRequirements = Vulkan::_CreateBuffer(
-                m_pInstanceCreator->GetDevice(),
-                m_stagingBuffer.uSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                m_stagingBuffer.hBuffer);
-
-            Vulkan::_AllocateMemory(
-                m_pInstanceCreator->GetDevice(),
-                m_pInstanceCreator->GetPhysicalDevice(),
-                memoryRequirements.size,
-                m_stagingBuffer.hMemory,
-                memoryRequirements.memoryTypeBits,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-            vkBindBufferMemory(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hBuffer, m_stagingBuffer.hMemory, 0);
-        }
-
-        // check if main buffer reallocation is required
-        if (static_cast<VkDeviceSize>(_uSize + _uOffset) > m_mainBuffer.uSize) {
-            // allocate a temporary memory buffer to hold data in
-            VkBuffer hTemporaryBuffer = VK_NULL_HANDLE;
-            VkDeviceMemory hTemporaryBufferMemory = VK_NULL_HANDLE;
-            const VkDeviceSize cuOldBufferSize = m_mainBuffer.uSize;
-
-            VkMemoryRequirements memoryRequirements = Vulkan::_CreateBuffer(
-                m_pInstanceCreator->GetDevice(),
-                cuOldBufferSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                hTemporaryBuffer);
-
-            Vulkan::_AllocateMemory(
-                m_pInstanceCreator->GetDevice(),
-                m_pInstanceCreator->GetPhysicalDevice(),
-                memoryRequirements.size,
-                hTemporaryBufferMemory,
-                memoryRequirements.memoryTypeBits,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-            vkBindBufferMemory(m_pInstanceCreator->GetDevice(), hTemporaryBuffer, hTemporaryBufferMemory, 0);
-
-            // copy data from main buffer to temporary buffer
-            Vulkan::_CopyBufferToBuffer(
-                m_pInstanceCreator->GetDevice(),
-                hCommandPool,
-                m_pInstanceCreator->GetGraphicsQueue(),
-                m_mainBuffer.hBuffer,
-                hTemporaryBuffer,
-                cuOldBufferSize,
-                0, 0);
-
-            // free old main buffer resources and allocate new larger buffer
-            m_deletedBuffers.push_back(m_mainBuffer);
-            m_mainBuffer.uSize = (static_cast<VkDeviceSize>(_uSize + _uOffset) * 3) >> 1;
-
-            memoryRequirements = Vulkan::_CreateBuffer(
-                m_pInstanceCreator->GetDevice(),
-                m_mainBuffer.uSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                m_mainBuffer.hBuffer);
-
-            Vulkan::_AllocateMemory(
-                m_pInstanceCreator->GetDevice(),
-                m_pInstanceCreator->GetPhysicalDevice(),
-                memoryRequirements.size,
-                m_mainBuffer.hMemory,
-                memoryRequirements.memoryTypeBits,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    void VulkanRenderer::_CheckAndReallocateStagingBuffer(size_t _uSize) {
+        if (static_cast<VkDeviceSize>(_uSize) <= m_stagingBuffer.uSize)
+            return;
 
-            vkBindBufferMemory(m_pInstanceCreator->GetDevice(), m_mainBuffer.hBuffer, m_mainBuffer.hMemory, 0);
+        // texture uploads wait for the graphics queue to idle, thus the staging buffer is never in use at this point
+        Vulkan::_DestroyMappedBuffer(m_pInstanceCreator->GetDevice(), m_stagingBuffer);
 
-            Vulkan::_CopyBufferToBuffer(
-                m_pInstanceCreator->GetDevice(),
-                hCommandPool,
-                m_pInstanceCreator->GetGraphicsQueue(),
-                hTemporaryBuffer,
-                m_mainBuffer.hBuffer,
-                cuOldBufferSize,
-                0, 0);
+        VkDeviceSize uStagingBufferSize = (_uSize * 3) >> 1;
+        const VkDeviceSize uMinUniformBufferAlignment = static_cast<VkDeviceSize>(m_pInstanceCreator->GetPhysicalDeviceInformation().uMinimalUniformBufferAlignment);
+        uStagingBufferSize = (uStagingBufferSize + uMinUniformBufferAlignment - 1) & ~(uMinUniformBufferAlignment - 1);
 
-            vkFreeMemory(m_pInstanceCreator->GetDevice(), hTemporaryBufferMemory, nullptr);
-            vkDestroyBuffer(m_pInstanceCreator->GetDevice(), hTemporaryBuffer, nullptr);
-        }
+        m_stagingBuffer = Vulkan::_CreateMappedBuffer(
+            m_pInstanceCreator->GetDevice(),
+            m_pInstanceCreator->GetPhysicalDevice(),
+            uStagingBufferSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
     }
 
 
@@ -398,6 +392,20 @@ namespace DENG {
     }
 
 
+    void VulkanRenderer::_CreateShaderDescriptors(cvar::hash_t _hshShader, const IShader* _pShader) {
+        // shader descriptor sets are required but do not exist
+        if (_pShader->GetUniformDataLayouts().size() && m_shaderDescriptors.find(_hshShader) == m_shaderDescriptors.end()) {
+            _CreateShaderDescriptorSetLayout(&m_shaderDescriptors[_hshShader].hDescriptorSetLayout, _hshShader);
+            _AllocateShaderDescriptors(_hshShader);
+            m_shaderDescriptorUpdateTable[_hshShader] = false;
+        }
+
+        // check if material descriptor set is required
+        if (_pShader->GetMaterialSamplerCount() != 0 && m_materialDescriptorSetLayouts.find(_pShader->GetMaterialSamplerCount()) == m_materialDescriptorSetLayouts.end())
+            _CreateMaterialDescriptorSetLayout(_pShader->GetMaterialSamplerCount());
+    }
+
+
     void VulkanRenderer::_UpdateShaderDescriptorSet(
         VkDescriptorSet _hDescriptorSet, 
         const IShader* _pShader) 
@@ -422,8 +430,7 @@ namespace DENG {
                 case UniformDataType::Buffer:
                 case UniformDataType::StorageBuffer:
                     descriptorBufferInfos.emplace_back();
-                    descriptorBufferInfos.back().buffer = m_mainBuffer.hBuffer;
-                    descriptorBufferInfos.back().offset = _pShader->GetUniformDataLayouts()[i].block.uOffset;
+                    descriptorBufferInfos.back().buffer = m_pMainBufferArena->Resolve(_pShader->GetUniformDataLayouts()[i].block.uOffset, descriptorBufferInfos.back().offset);
                     descriptorBufferInfos.back().range = _pShader->GetUniformDataLayouts()[i].block.uSize;
                     break;
 
@@ -539,14 +546,33 @@ namespace DENG {
 
 
     void VulkanRenderer::DeleteTextureHandles() {
-        for (auto it = m_textureHandles.begin(); it != m_textureHandles.end(); it++) {
-            vkDestroySampler(m_pInstanceCreator->GetDevice(), it->second.hSampler, nullptr);
-            vkDestroyImageView(m_pInstanceCreator->GetDevice(), it->second.hImageView, nullptr);
-            vkDestroyImage(m_pInstanceCreator->GetDevice(), it->second.hImage, nullptr);
-            vkFreeMemory(m_pInstanceCreator->GetDevice(), it->second.hMemory, nullptr);
+        // descriptor sets of frames in flight might still sample from these textures, thus pools that own the sets
+        // are retired together with textures and new sets are allocated and written on the next draw
+        m_fullDescriptorPools.push_back(m_hMainDescriptorPool);
+        for (VkDescriptorPool hPool : m_fullDescriptorPools)
+            m_pDeletionQueue->RetireDescriptorPool(hPool);
+
+        m_fullDescriptorPools.clear();
+        m_materialDescriptors.clear();
+        m_placeholderMaterialDescriptors.clear();
+
+        // missing textures are substituted into every descriptor set whose texture is not available, thus they live as long as the renderer
+        for (auto it = m_textureHandles.begin(); it != m_textureHandles.end();) {
+            if (it->first == m_hshMissing2DTexture || it->first == m_hshMissing3DTexture) {
+                it++;
+                continue;
+            }
+
+            m_pDeletionQueue->RetireTexture(it->second);
+            it = m_textureHandles.erase(it);
         }
 
-        m_textureHandles.clear();
+        m_uDescriptorPoolUsage = 0;
+        _AllocateDescriptorPool();
+        for (auto it = m_shaderDescriptors.begin(); it != m_shaderDescriptors.end(); it++) {
+            _AllocateShaderDescriptors(it->first);
+            m_shaderDescriptorUpdateTable[it->first] = false;
+        }
     }
 
 
@@ -563,17 +589,57 @@ namespace DENG {
 
     
     void VulkanRenderer::DestroyPipeline(cvar::hash_t _hshShader) {
-        m_pipelineCreators.erase(_hshShader);
+        for (IFramebuffer* pFramebuffer : m_framebuffers)
+            static_cast<Vulkan::Framebuffer*>(pFramebuffer)->DestroyPipeline(_hshShader, *m_pDeletionQueue);
+    }
+
+    void VulkanRenderer::PrecompilePipelines(IFramebuffer* _pFramebuffer) {
+        ResourceManager& resourceManager = ResourceManager::GetInstance();
+
+        for (auto it = resourceManager.GetShaders().begin(); it != resourceManager.GetShaders().end(); it++) {
+            _CreateShaderDescriptors(it->first, it->second);
+
+            auto itShaderDescriptors = m_shaderDescriptors.find(it->first);
+            const VkDescriptorSetLayout hShaderDescriptorSetLayout =
+                itShaderDescriptors != m_shaderDescriptors.end() ? itShaderDescriptors->second.hDescriptorSetLayout : VK_NULL_HANDLE;
+            const VkDescriptorSetLayout hMaterialDescriptorSetLayout =
+                it->second->GetMaterialSamplerCount() ? m_materialDescriptorSetLayouts[it->second->GetMaterialSamplerCount()] : VK_NULL_HANDLE;
+
+            for (IFramebuffer* pFramebuffer : m_framebuffers) {
+                if (_pFramebuffer && pFramebuffer != _pFramebuffer)
+                    continue;
+
+                static_cast<Vulkan::Framebuffer*>(pFramebuffer)->RequestPipelineCreator(
+                    it->first,
+                    it->second,
+                    hShaderDescriptorSetLayout,
+                    hMaterialDescriptorSetLayout);
+            }
+        }
+
+        for (IFramebuffer* pFramebuffer : m_framebuffers) {
+            if (!_pFramebuffer || pFramebuffer == _pFramebuffer)
+                static_cast<Vulkan::Framebuffer*>(pFramebuffer)->WaitForPipelineCreators();
+        }
     }
 
+
+    bool VulkanRenderer::IsTextureCompressionSupported() const {
+        return m_pInstanceCreator && m_pInstanceCreator->GetPhysicalDeviceInformation().bTextureCompressionBC;
+    }
+
+
     IFramebuffer* VulkanRenderer::CreateFramebuffer(uint32_t _uWidth, uint32_t _uHeight) {
         Vulkan::Framebuffer* pFramebuffer = new Vulkan::Framebuffer(
             m_pInstanceCreator, 
-            m_mainBuffer.hBuffer,
+            *m_pMainBufferArena,
             m_uSampleCountBits, 
             TRS::Point2D<uint32_t>(_uWidth, _uHeight),
-            false);
+            false,
+            m_pStagingRing);
 
+        // renderer keeps track of every framebuffer, which allows pipelines to be destroyed in all of them
+        m_framebuffers.push_back(pFramebuffer);
         return pFramebuffer;
     }
 
@@ -582,50 +648,30 @@ namespace DENG {
 
         m_pInstanceCreator = new Vulkan::InstanceCreator(*_pWindow);
 
-        m_mainBuffer.uSize = DEFAULT_BUFFER_SIZE;
-        m_stagingBuffer.uSize = DEFAULT_STAGING_BUFFER_SIZE;
-
-        // allocate staging buffer memory
-        VkMemoryRequirements memoryRequirements = Vulkan::_CreateBuffer(
-            m_pInstanceCreator->GetDevice(),
-            m_stagingBuffer.uSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            m_stagingBuffer.hBuffer);
-
-        Vulkan::_AllocateMemory(
+        // staging buffer stays mapped for its whole lifetime
+        m_stagingBuffer = Vulkan::_CreateMappedBuffer(
             m_pInstanceCreator->GetDevice(),
             m_pInstanceCreator->GetPhysicalDevice(),
-            memoryRequirements.size,
-            m_stagingBuffer.hMemory,
-            memoryRequirements.memoryTypeBits,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        
-        vkBindBufferMemory(m_pInstanceCreator->GetDevice(), m_stagingBuffer.hBuffer, m_stagingBuffer.hMemory, 0);
+            DEFAULT_STAGING_BUFFER_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
 
-        // allocate main buffer memory
-        memoryRequirements = Vulkan::_CreateBuffer(
-            m_pInstanceCreator->GetDevice(),
-            m_mainBuffer.uSize,
+        m_pDeletionQueue = new Vulkan::DeletionQueue(m_pInstanceCreator->GetDevice());
+        m_pMainBufferArena = new Vulkan::BufferArena(
+            m_pInstanceCreator,
+            *m_pDeletionQueue,
             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            m_mainBuffer.hBuffer);
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
-        Vulkan::_AllocateMemory(
-            m_pInstanceCreator->GetDevice(),
-            m_pInstanceCreator->GetPhysicalDevice(),
-            memoryRequirements.size,
-            m_mainBuffer.hMemory,
-            memoryRequirements.memoryTypeBits,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        vkBindBufferMemory(m_pInstanceCreator->GetDevice(), m_mainBuffer.hBuffer, m_mainBuffer.hMemory, 0);
+        m_pFrameAllocator = new Vulkan::FrameAllocator(*m_pMainBufferArena);
+        m_pStagingRing = new Vulkan::StagingRing(m_pInstanceCreator, *m_pMainBufferArena);
 
         Vulkan::Framebuffer* pFramebuffer = new Vulkan::Framebuffer(
             m_pInstanceCreator,
-            m_mainBuffer.hBuffer,
+            *m_pMainBufferArena,
             m_uSampleCountBits,
             TRS::Point2D<uint32_t>(_pWindow->GetWidth(), _pWindow->GetHeight()),
-            true);
+            true,
+            m_pStagingRing);
 
         m_framebuffers.push_back(pFramebuffer);
 
@@ -650,14 +696,14 @@ namespace DENG {
 
         switch (_eType) {
         case BufferDataType::Vertex:
-            return m_gpuMemoryAllocator.RequestMemory(_uSize, sizeof(uint32_t)).uOffset;
+            return m_pMainBufferArena->Allocate(_uSize, sizeof(uint32_t));
 
         case BufferDataType::Index:
-            return m_gpuMemoryAllocator.RequestMemory(_uSize, sizeof(uint32_t)).uOffset;
+            return m_pMainBufferArena->Allocate(_uSize, sizeof(uint32_t));
 
         case BufferDataType::Uniform:
         {
-            size_t uOffset = m_gpuMemoryAllocator.RequestMemory(_uSize, m_pInstanceCreator->GetPhysicalDeviceInformation().uMinimalUniformBufferAlignment).uOffset;
+            size_t uOffset = m_pMainBufferArena->Allocate(_uSize, m_pInstanceCreator->GetPhysicalDeviceInformation().uMinimalUniformBufferAlignment);
             return uOffset;
         }
             default:
@@ -669,35 +715,46 @@ namespace DENG {
 
 
     void VulkanRenderer::DeallocateMemory(size_t _uOffset) {
-        m_gpuMemoryAllocator.FreeMemory(_uOffset);
+        m_pMainBufferArena->Free(_uOffset);
     }
 
 
-    void VulkanRenderer::UpdateBuffer(const void* _pData, size_t _uSize, size_t _uOffset) {
+    size_t VulkanRenderer::AllocateFrameMemory(size_t _uSize, BufferDataType _eType) {
         DENG_ASSERT(m_pInstanceCreator);
-        _CheckAndReallocateBufferResources(_uSize, _uOffset);
-        VkCommandPool hCommandPool = static_cast<Vulkan::Framebuffer*>(m_framebuffers[0])->GetCommandPool();
 
-        // staging
-        Vulkan::_CopyToBufferMemory(
-            m_pInstanceCreator->GetDevice(),
-            _uSize,
-            _pData,
-            m_stagingBuffer.hMemory, 0);
+        if (_eType == BufferDataType::Uniform)
+            return m_pFrameAllocator->Allocate(_uSize, m_pInstanceCreator->GetPhysicalDeviceInformation().uMinimalUniformBufferAlignment);
+        return m_pFrameAllocator->Allocate(_uSize, sizeof(uint32_t));
+    }
 
-        // staging to main
-        Vulkan::_CopyBufferToBuffer(
-            m_pInstanceCreator->GetDevice(),
-            hCommandPool,
-            m_pInstanceCreator->GetGraphicsQueue(),
-            m_stagingBuffer.hBuffer,
-            m_mainBuffer.hBuffer,
-            _uSize,
-            0, _uOffset);
+
+    void* VulkanRenderer::MapBufferRegion(size_t _uSize, size_t _uOffset) {
+        DENG_ASSERT(m_pInstanceCreator);
+        DENG_ASSERT(m_pStagingRing);
+
+        // staging ring spills into additional buffers instead of submitting copies in the middle of the frame
+        return m_pStagingRing->Allocate(static_cast<VkDeviceSize>(_uSize), static_cast<VkDeviceSize>(_uOffset));
+    }
+
+
+    void VulkanRenderer::UpdateBuffer(const void* _pData, size_t _uSize, size_t _uOffset) {
+        std::memcpy(MapBufferRegion(_uSize, _uOffset), _pData, _uSize);
+    }
+
+
+    void VulkanRenderer::UpdateBufferRegions(const BufferRegion* _pRegions, size_t _uCount) {
+        DENG_ASSERT(m_pInstanceCreator);
+        DENG_ASSERT(m_pStagingRing);
+
+        m_pStagingRing->WriteRegions(_pRegions, _uCount);
     }
 
 
     bool VulkanRenderer::SetupFrame() {
+        // roll over upload counters of the previous frame
+        m_uploadStatistics = m_pStagingRing->GetStatistics();
+        m_pStagingRing->GetStatistics() = UploadStatistics();
+
         // check if resize mode is active
         if (m_bResizeModeTriggered) {
             m_resizeEndTimestamp = std::chrono::high_resolution_clock::now();
@@ -715,16 +772,10 @@ namespace DENG {
             }
         }
 
-        // delete all previously reallocated buffers
-        if (m_deletedBuffers.size()) {
-            vkDeviceWaitIdle(m_pInstanceCreator->GetDevice());
-            for (auto it = m_deletedBuffers.begin(); it != m_deletedBuffers.end(); it++) {
-                vkFreeMemory(m_pInstanceCreator->GetDevice(), it->hMemory, nullptr);
-                vkDestroyBuffer(m_pInstanceCreator->GetDevice(), it->hBuffer, nullptr);
-            }
-
-            m_deletedBuffers.clear();
-        }
+        // destroy objects, which were retired long enough ago
+        m_pDeletionQueue->NextFrame();
+        m_pFrameAllocator->NextFrame();
+        m_memoryStatistics = m_pMainBufferArena->GetStatistics();
 
         // reset descriptor update table
         for (auto it = m_shaderDescriptorUpdateTable.begin(); it != m_shaderDescriptorUpdateTable.end(); it++) {
@@ -754,7 +805,7 @@ namespace DENG {
             DENG_ASSERT(texture);
 
             if ((texture->eResourceType == TextureType::Image_2D || texture->eResourceType == TextureType::Image_3D || texture->eResourceType == TextureType::Image_3D_Array) &&
-                m_textureHandles.find(pShader->GetTextureHash(i)) == m_textureHandles.end())
+                texture->pRGBAData && m_textureHandles.find(pShader->GetTextureHash(i)) == m_textureHandles.end())
             {
                 _CreateApiImageHandles(pShader->GetTextureHash(i));
             }
@@ -765,12 +816,7 @@ namespace DENG {
         
         Vulkan::Framebuffer* vulkanFramebuffer = static_cast<Vulkan::Framebuffer*>(_pFramebuffer);
 
-        // shader descriptor sets are required but do not exist
-        if (pShader->GetUniformDataLayouts().size() && m_shaderDescriptors.find(_hshShader) == m_shaderDescriptors.end()) {
-            _CreateShaderDescriptorSetLayout(&m_shaderDescriptors[_hshShader].hDescriptorSetLayout, _hshShader);
-            _AllocateShaderDescriptors(_hshShader);
-            m_shaderDescriptorUpdateTable[_hshShader] = false;
-        }
+        _CreateShaderDescriptors(_hshShader, pShader);
 
         if (pShader->GetUniformDataLayouts().size() && !m_shaderDescriptorUpdateTable[_hshShader]) {
             _UpdateShaderDescriptorSet(m_shaderDescriptors[_hshShader].descriptorSets[vulkanFramebuffer->GetCurrentFrameIndex()], pShader);
@@ -784,16 +830,21 @@ namespace DENG {
             else if (resourceManager.ExistsMaterialPhong(_hshMaterial))
                 _AllocateMaterialDescriptors<MaterialPhong, MAX_PHONG_SAMPLERS>(_hshMaterial, *resourceManager.GetMaterialPhong(_hshMaterial));
         }
+        else if (_hshMaterial && m_placeholderMaterialDescriptors.find(_hshMaterial) != m_placeholderMaterialDescriptors.end()) {
+            const uint32_t uFrameIndex = vulkanFramebuffer->GetCurrentFrameIndex();
+            if (resourceManager.ExistsMaterialPBR(_hshMaterial))
+                _RefreshPlaceholderMaterialDescriptors<MaterialPBR, MAX_PBR_SAMPLERS>(_hshMaterial, *resourceManager.GetMaterialPBR(_hshMaterial), uFrameIndex);
+            else if (resourceManager.ExistsMaterialPhong(_hshMaterial))
+                _RefreshPlaceholderMaterialDescriptors<MaterialPhong, MAX_PHONG_SAMPLERS>(_hshMaterial, *resourceManager.GetMaterialPhong(_hshMaterial), uFrameIndex);
+        }
 
         VkDescriptorSetLayout materialDescriptorSetLayout = VK_NULL_HANDLE;
-        
-        // check if material descriptor set is required
-        if (pShader->GetMaterialSamplerCount() != 0 && m_materialDescriptorSetLayouts.find(pShader->GetMaterialSamplerCount()) == m_materialDescriptorSetLayouts.end())
-            _CreateMaterialDescriptorSetLayout(pShader->GetMaterialSamplerCount());
-        
         if (pShader->GetMaterialSamplerCount() != 0)
             materialDescriptorSetLayout = m_materialDescriptorSetLayouts[pShader->GetMaterialSamplerCount()];
 
+        auto itFallbackShader = m_fallbackShaders.find(_hshShader);
+        const cvar::hash_t hshFallbackShader = itFallbackShader != m_fallbackShaders.end() ? itFallbackShader->second : 0;
+
         if (m_shaderDescriptors.find(_hshShader) != m_shaderDescriptors.end() && _hshMaterial) {
             vulkanFramebuffer->Draw(
                 _hshMesh, 
@@ -803,7 +854,8 @@ namespace DENG {
                 m_shaderDescriptors[_hshShader].descriptorSets[vulkanFramebuffer->GetCurrentFrameIndex()], 
                 m_materialDescriptors[_hshMaterial][vulkanFramebuffer->GetCurrentFrameIndex()],
                 m_shaderDescriptors[_hshShader].hDescriptorSetLayout,
-                materialDescriptorSetLayout);
+                materialDescriptorSetLayout,
+                hshFallbackShader);
         }
         else if (m_shaderDescriptors.find(_hshShader) != m_shaderDescriptors.end()) {
             vulkanFramebuffer->Draw(
@@ -814,7 +866,8 @@ namespace DENG {
                 m_shaderDescriptors[_hshShader].descriptorSets[vulkanFramebuffer->GetCurrentFrameIndex()],
                 VK_NULL_HANDLE,
                 m_shaderDescriptors[_hshShader].hDescriptorSetLayout,
-                materialDescriptorSetLayout);
+                materialDescriptorSetLayout,
+                hshFallbackShader);
         }
         else if (m_shaderDescriptors.find(_hshShader) == m_shaderDescriptors.end() && _hshMaterial) {
             vulkanFramebuffer->Draw(
@@ -825,7 +878,8 @@ namespace DENG {
                 VK_NULL_HANDLE,
                 m_materialDescriptors[_hshMaterial][vulkanFramebuffer->GetCurrentFrameIndex()],
                 m_shaderDescriptors[_hshShader].hDescriptorSetLayout,
-                materialDescriptorSetLayout);
+                materialDescriptorSetLayout,
+                hshFallbackShader);
         }
         else {
             vulkanFramebuffer->Draw(
@@ -836,7 +890,8 @@ namespace DENG {
                 VK_NULL_HANDLE,
                 VK_NULL_HANDLE,
                 m_shaderDescriptors[_hshShader].hDescriptorSetLayout,
-                materialDescriptorSetLayout);
+                materialDescriptorSetLayout,
+                hshFallbackShader);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,335 @@
+// DENG: dynamic engine - small but powerful 3D game engine
+// licence: Apache, see LICENCE file
+// file: VulkanStagingRing.cpp - Vulkan per frame staging ring class implementation
+// author: Karl-Mihkel Ott
+
+#define VULKAN_STAGING_RING_CPP
+#include "deng/VulkanStagingRing.h"
+
+namespace DENG {
+    namespace Vulkan {
+
+        static VkDeviceSize _AlignStagingOffset(VkDeviceSize _uOffset) {
+            return (_uOffset + STAGING_RING_ALIGNMENT - 1) & ~static_cast<VkDeviceSize>(STAGING_RING_ALIGNMENT - 1);
+        }
+
+
+        StagingRing::StagingRing(const InstanceCreator* _pInstanceCreator, const BufferArena& _dstArena, VkDeviceSize _uSegmentSize) :
+            m_pInstanceCreator(_pInstanceCreator),
+            m_dstArena(_dstArena),
+            m_uSegmentSize(_uSegmentSize)
+        {
+            VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+            commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.queueFamilyIndex = m_pInstanceCreator->GetGraphicsFamilyIndex();
+            commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+            if (vkCreateCommandPool(m_pInstanceCreator->GetDevice(), &commandPoolCreateInfo, nullptr, &m_hCommandPool) != VK_SUCCESS)
+                throw RendererException("vkCreateCommandPool() could not create a command pool for staging ring");
+
+            m_segments.reserve(MAX_FRAMES_IN_FLIGHT);
+            for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+                m_segments.push_back(_CreateSegment());
+        }
+
+
+        StagingRing::~StagingRing() {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            for (_Segment& segment : m_segments) {
+                vkWaitForFences(hDevice, 1, &segment.hFence, VK_TRUE, UINT64_MAX);
+                _DestroySegment(segment);
+            }
+
+            vkDestroyCommandPool(hDevice, m_hCommandPool, nullptr);
+        }
+
+
+        StagingRing::_Segment StagingRing::_CreateSegment() {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            _Segment segment;
+
+            // memory stays mapped for the lifetime of the segment
+            segment.buffer = _CreateMappedBuffer(
+                hDevice,
+                m_pInstanceCreator->GetPhysicalDevice(),
+                m_uSegmentSize,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+            commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocateInfo.commandPool = m_hCommandPool;
+            commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            commandBufferAllocateInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(hDevice, &commandBufferAllocateInfo, &segment.hCommandBuffer) != VK_SUCCESS)
+                throw RendererException("vkAllocateCommandBuffers() could not allocate staging ring command buffer");
+
+            VkFenceCreateInfo fenceCreateInfo = {};
+            fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            if (vkCreateFence(hDevice, &fenceCreateInfo, nullptr, &segment.hFence) != VK_SUCCESS)
+                throw RendererException("vkCreateFence() could not create a staging ring fence");
+
+            return segment;
+        }
+
+
+        void StagingRing::_DestroySegment(_Segment& _segment) {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            for (BufferData& spillBuffer : _segment.spillBuffers)
+                _DestroyMappedBuffer(hDevice, spillBuffer);
+            _segment.spillBuffers.clear();
+
+            vkDestroyFence(hDevice, _segment.hFence, nullptr);
+            vkFreeCommandBuffers(hDevice, m_hCommandPool, 1, &_segment.hCommandBuffer);
+            _DestroyMappedBuffer(hDevice, _segment.buffer);
+        }
+
+
+        void StagingRing::_ReleaseSegment(_Segment& _segment) {
+            // spill buffers in use are kept, which effectively grows the segment for frames with steady upload volume
+            for (size_t i = _segment.uSpillBufferCount; i < _segment.spillBuffers.size(); i++)
+                _DestroyMappedBuffer(m_pInstanceCreator->GetDevice(), _segment.spillBuffers[i]);
+            _segment.spillBuffers.resize(_segment.uSpillBufferCount);
+
+            _segment.copyRegions.clear();
+            _segment.uUsed = 0;
+            _segment.uSpillBufferCount = 0;
+            _segment.uSpillUsed = 0;
+        }
+
+
+        std::pair<const BufferData*, VkDeviceSize> StagingRing::_Reserve(_Segment& _segment, VkDeviceSize _uSize) {
+            VkDeviceSize uOffset = _AlignStagingOffset(_segment.uUsed);
+            if (uOffset + _uSize <= m_uSegmentSize) {
+                _segment.uUsed = uOffset + _uSize;
+                return std::make_pair(&_segment.buffer, uOffset);
+            }
+
+            if (_segment.uSpillBufferCount) {
+                const BufferData& spillBuffer = _segment.spillBuffers[_segment.uSpillBufferCount - 1];
+                uOffset = _AlignStagingOffset(_segment.uSpillUsed);
+                if (uOffset + _uSize <= spillBuffer.uSize) {
+                    _segment.uSpillUsed = uOffset + _uSize;
+                    return std::make_pair(&spillBuffer, uOffset);
+                }
+            }
+
+            // buffers kept from previous frames are replaced if they are too small for the region
+            while (_segment.uSpillBufferCount < _segment.spillBuffers.size() && _segment.spillBuffers[_segment.uSpillBufferCount].uSize < _uSize) {
+                _DestroyMappedBuffer(m_pInstanceCreator->GetDevice(), _segment.spillBuffers[_segment.uSpillBufferCount]);
+                _segment.spillBuffers.erase(_segment.spillBuffers.begin() + _segment.uSpillBufferCount);
+            }
+
+            if (_segment.uSpillBufferCount == _segment.spillBuffers.size()) {
+                _segment.spillBuffers.push_back(_CreateMappedBuffer(
+                    m_pInstanceCreator->GetDevice(),
+                    m_pInstanceCreator->GetPhysicalDevice(),
+                    std::max(_uSize, m_uSegmentSize),
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+            }
+
+            _segment.uSpillBufferCount++;
+            _segment.uSpillUsed = _uSize;
+            return std::make_pair(&_segment.spillBuffers[_segment.uSpillBufferCount - 1], static_cast<VkDeviceSize>(0));
+        }
+
+
+        bool StagingRing::_HasOverlappingDstRegions(const _Segment& _segment) {
+            m_sortedDstRanges.clear();
+            for (const _CopyRegion& copyRegion : _segment.copyRegions)
+                m_sortedDstRanges.emplace_back(copyRegion.copy.dstOffset, copyRegion.copy.dstOffset + copyRegion.copy.size);
+
+            std::sort(m_sortedDstRanges.begin(), m_sortedDstRanges.end());
+            for (size_t i = 1; i < m_sortedDstRanges.size(); i++) {
+                if (m_sortedDstRanges[i].first < m_sortedDstRanges[i - 1].second)
+                    return true;
+            }
+
+            return false;
+        }
+
+
+        void StagingRing::_PushCopyRegion(_Segment& _segment, VkBuffer _hSrcBuffer, VkDeviceSize _uSrcOffset, VkDeviceSize _uDstOffset, VkDeviceSize _uSize) {
+            // consecutive writes into consecutive regions of the same arena block are merged into a single copy
+            if (!_segment.copyRegions.empty() &&
+                _segment.copyRegions.back().hSrcBuffer == _hSrcBuffer &&
+                _segment.copyRegions.back().copy.srcOffset + _segment.copyRegions.back().copy.size == _uSrcOffset &&
+                _segment.copyRegions.back().copy.dstOffset + _segment.copyRegions.back().copy.size == _uDstOffset)
+            {
+                VkDeviceSize uLocalOffset = 0;
+                const VkBuffer hPreviousBuffer = m_dstArena.Resolve(static_cast<size_t>(_segment.copyRegions.back().copy.dstOffset), uLocalOffset);
+                if (hPreviousBuffer == m_dstArena.Resolve(static_cast<size_t>(_uDstOffset), uLocalOffset)) {
+                    _segment.copyRegions.back().copy.size += _uSize;
+                    return;
+                }
+            }
+
+            _CopyRegion copyRegion;
+            copyRegion.hSrcBuffer = _hSrcBuffer;
+            copyRegion.copy.srcOffset = _uSrcOffset;
+            copyRegion.copy.dstOffset = _uDstOffset;
+            copyRegion.copy.size = _uSize;
+            _segment.copyRegions.push_back(copyRegion);
+        }
+
+
+        void* StagingRing::Allocate(VkDeviceSize _uSize, VkDeviceSize _uDstOffset) {
+            _Segment& segment = m_segments[m_uSegmentIndex];
+
+            const std::pair<const BufferData*, VkDeviceSize> reservation = _Reserve(segment, _uSize);
+            _PushCopyRegion(segment, reservation.first->hBuffer, reservation.second, _uDstOffset, _uSize);
+
+            m_statistics.uBytesUploaded += static_cast<size_t>(_uSize);
+            m_statistics.uCopyCount++;
+            return reservation.first->pMappedMemory + reservation.second;
+        }
+
+
+        void StagingRing::WriteRegions(const BufferRegion* _pRegions, size_t _uCount) {
+            _Segment& segment = m_segments[m_uSegmentIndex];
+
+            VkDeviceSize uTotalSize = 0;
+            for (size_t i = 0; i < _uCount; i++)
+                uTotalSize += static_cast<VkDeviceSize>(_pRegions[i].uSize);
+
+            if (!uTotalSize)
+                return;
+
+            // regions are packed without padding, which lets consecutive destination ranges share a copy region
+            const std::pair<const BufferData*, VkDeviceSize> reservation = _Reserve(segment, uTotalSize);
+            VkDeviceSize uSrcOffset = reservation.second;
+            for (size_t i = 0; i < _uCount; i++) {
+                const VkDeviceSize uSize = static_cast<VkDeviceSize>(_pRegions[i].uSize);
+                const VkDeviceSize uDstOffset = static_cast<VkDeviceSize>(_pRegions[i].uDstOffset);
+                if (!uSize)
+                    continue;
+
+                std::memcpy(reservation.first->pMappedMemory + uSrcOffset, _pRegions[i].pData, static_cast<size_t>(uSize));
+                _PushCopyRegion(segment, reservation.first->hBuffer, uSrcOffset, uDstOffset, uSize);
+
+                uSrcOffset += uSize;
+                m_statistics.uCopyCount++;
+            }
+
+            m_statistics.uBytesUploaded += static_cast<size_t>(uTotalSize);
+        }
+
+
+        void StagingRing::_RecordCopies(_Segment& _segment) {
+            if (!_HasOverlappingDstRegions(_segment)) {
+                // order of non-overlapping copies is irrelevant, regions are grouped by source buffer and destination arena block
+                // and every group gets a single copy command
+                std::sort(_segment.copyRegions.begin(), _segment.copyRegions.end(),
+                    [](const _CopyRegion& _region1, const _CopyRegion& _region2) {
+                        if (_region1.hSrcBuffer != _region2.hSrcBuffer)
+                            return std::less<VkBuffer>()(_region1.hSrcBuffer, _region2.hSrcBuffer);
+                        return _region1.copy.dstOffset < _region2.copy.dstOffset;
+                    });
+
+                VkBuffer hSrcBuffer = VK_NULL_HANDLE;
+                VkBuffer hDstBuffer = VK_NULL_HANDLE;
+                m_copyBatch.clear();
+                for (const _CopyRegion& copyRegion : _segment.copyRegions) {
+                    VkBufferCopy copy = copyRegion.copy;
+                    const VkBuffer hRegionDstBuffer = m_dstArena.Resolve(static_cast<size_t>(copyRegion.copy.dstOffset), copy.dstOffset);
+                    if ((copyRegion.hSrcBuffer != hSrcBuffer || hRegionDstBuffer != hDstBuffer) && !m_copyBatch.empty()) {
+                        vkCmdCopyBuffer(_segment.hCommandBuffer, hSrcBuffer, hDstBuffer, static_cast<uint32_t>(m_copyBatch.size()), m_copyBatch.data());
+                        m_copyBatch.clear();
+                    }
+
+                    hSrcBuffer = copyRegion.hSrcBuffer;
+                    hDstBuffer = hRegionDstBuffer;
+                    m_copyBatch.push_back(copy);
+                }
+
+                vkCmdCopyBuffer(_segment.hCommandBuffer, hSrcBuffer, hDstBuffer, static_cast<uint32_t>(m_copyBatch.size()), m_copyBatch.data());
+                return;
+            }
+
+            // regions of a single copy command must not overlap, overlapping writes are copied one by one in upload order instead
+            VkMemoryBarrier orderBarrier = {};
+            orderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            orderBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            orderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            for (size_t i = 0; i < _segment.copyRegions.size(); i++) {
+                if (i) {
+                    vkCmdPipelineBarrier(
+                        _segment.hCommandBuffer,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 1, &orderBarrier, 0, nullptr, 0, nullptr);
+                }
+
+                VkBufferCopy copy = _segment.copyRegions[i].copy;
+                const VkBuffer hDstBuffer = m_dstArena.Resolve(static_cast<size_t>(_segment.copyRegions[i].copy.dstOffset), copy.dstOffset);
+                vkCmdCopyBuffer(_segment.hCommandBuffer, _segment.copyRegions[i].hSrcBuffer, hDstBuffer, 1, &copy);
+            }
+        }
+
+
+        VkCommandBuffer StagingRing::Flush() {
+            _Segment& segment = m_segments[m_uSegmentIndex];
+            if (segment.copyRegions.empty())
+                return VK_NULL_HANDLE;
+
+            if (vkResetCommandBuffer(segment.hCommandBuffer, 0) != VK_SUCCESS)
+                throw RendererException("vkResetCommandBuffer() could not reset staging ring command buffer");
+
+            VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+            commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            if (vkBeginCommandBuffer(segment.hCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+                throw RendererException("vkBeginCommandBuffer() could not begin staging ring command buffer recording");
+
+            // draws and copies of previous frames might still access regions that are about to be overwritten
+            VkMemoryBarrier memoryBarrier = {};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(
+                segment.hCommandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+            _RecordCopies(segment);
+
+            // make copied data visible to vertex fetch and shader reads of the following draw commands
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(
+                segment.hCommandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+            if (vkEndCommandBuffer(segment.hCommandBuffer) != VK_SUCCESS)
+                throw RendererException("vkEndCommandBuffer() could not end staging ring command buffer recording");
+
+            m_statistics.uSubmitCount++;
+            return segment.hCommandBuffer;
+        }
+
+
+        void StagingRing::EndSegment(VkQueue _hQueue) {
+            const VkDevice hDevice = m_pInstanceCreator->GetDevice();
+            _Segment& segment = m_segments[m_uSegmentIndex];
+
+            // submission without batches signals the fence once all previously submitted work, including the frame, has completed
+            vkResetFences(hDevice, 1, &segment.hFence);
+            if (vkQueueSubmit(_hQueue, 0, nullptr, segment.hFence) != VK_SUCCESS)
+                throw RendererException("vkQueueSubmit() failed to fence staging ring segment");
+
+            // waiting for the next segment could block on work of the frame that was just submitted, thus the ring is grown instead
+            const uint32_t uNextSegmentIndex = (m_uSegmentIndex + 1) % static_cast<uint32_t>(m_segments.size());
+            if (vkGetFenceStatus(hDevice, m_segments[uNextSegmentIndex].hFence) == VK_SUCCESS)
+                _ReleaseSegment(m_segments[uNextSegmentIndex]);
+            else m_segments.insert(m_segments.begin() + uNextSegmentIndex, _CreateSegment());
+
+            m_uSegmentIndex = uNextSegmentIndex;
+        }
+    }
+}